@@ -3,78 +3,86 @@
 #include <cstddef>
 #include <cstdio>
 #include <cstdlib>
+#include <new>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#define __heap_block_size(ptr) _msize(ptr)
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#define __heap_block_size(ptr) malloc_size(ptr)
+#else
+#include <malloc.h>
+#define __heap_block_size(ptr) malloc_usable_size(ptr)
+#endif
 
 // -------------------------------------------------
-// Global atomic counter for heap bytes
+// Global atomic counters for heap bytes
 // -------------------------------------------------
-inline std::atomic<std::size_t> __total_heap_bytes{0};
+// Blocks are counted by their usable size, read back from the allocator on
+// delete, so sized and unsized deletes both decrement the live counter.
+inline std::atomic<std::size_t> __total_heap_bytes{0};      // live now
+inline std::atomic<std::size_t> __peak_heap_bytes{0};       // max of live
+inline std::atomic<std::size_t> __allocated_heap_bytes{0};  // cumulative
+// The same per thread: bytes this thread allocated minus bytes it freed,
+// and the max of that (the profiler restarts it per region)
+inline thread_local std::ptrdiff_t __thread_heap_bytes = 0;
+inline thread_local std::ptrdiff_t __thread_peak_heap_bytes = 0;
+
+inline void __heap_count_alloc(void* ptr) {
+    std::size_t size = __heap_block_size(ptr);
+    __allocated_heap_bytes += size;
+    std::size_t now = (__total_heap_bytes += size);
+    std::size_t peak = __peak_heap_bytes.load(std::memory_order_relaxed);
+    while (now > peak && !__peak_heap_bytes.compare_exchange_weak(peak, now)) {
+    }
+    std::ptrdiff_t mine = (__thread_heap_bytes += size);
+    if (mine > __thread_peak_heap_bytes) __thread_peak_heap_bytes = mine;
+}
+
+inline void __heap_count_free(void* ptr) {
+    std::size_t size = __heap_block_size(ptr);
+    __total_heap_bytes -= size;
+    __thread_heap_bytes -= size;
+}
 
 // ----------------------------
 // Global operator new/delete
 // ----------------------------
 inline void* operator new(std::size_t size) {
-    void* ptr = std::malloc(size);
+    void* ptr = std::malloc(size ? size : 1);
     if (!ptr) throw std::bad_alloc();
-    __total_heap_bytes += size;
+    __heap_count_alloc(ptr);
     return ptr;
 }
 
-inline void operator delete(void* ptr, std::size_t size) noexcept {
-    if (ptr) {
-        __total_heap_bytes -= size;
-        std::free(ptr);
-    }
-}
-
 inline void* operator new[](std::size_t size) {
-    void* ptr = std::malloc(size);
+    void* ptr = std::malloc(size ? size : 1);
     if (!ptr) throw std::bad_alloc();
-    __total_heap_bytes += size;
+    __heap_count_alloc(ptr);
     return ptr;
 }
 
-inline void operator delete[](void* ptr, std::size_t size) noexcept {
+inline void operator delete(void* ptr) noexcept {
     if (ptr) {
-        __total_heap_bytes -= size;
+        __heap_count_free(ptr);
         std::free(ptr);
     }
 }
 
-// Fallback delete operators
-inline void operator delete(void* ptr) noexcept { std::free(ptr); }
-inline void operator delete[](void* ptr) noexcept { std::free(ptr); }
-
-// ----------------------------
-// HeapTracker class
-// ----------------------------
-namespace Heap {
-
-class HeapTracker {
-   public:
-    void start(const char* file, int line) {
-        file_start_ = file;
-        line_start_ = line;
-        start_bytes_ = __total_heap_bytes.load();
-    }
-
-    void stop(const char* file, int line) {
-        std::size_t end_bytes = __total_heap_bytes.load();
-        std::size_t delta = end_bytes - start_bytes_;
-        printf("\n[HeapCounter] %s:L%d - %s:L%d: %zu KB allocated\n",
-               file_start_, line_start_, file, line, delta / 1024);
+inline void operator delete[](void* ptr) noexcept {
+    if (ptr) {
+        __heap_count_free(ptr);
+        std::free(ptr);
     }
+}
 
-   private:
-    const char* file_start_ = nullptr;
-    int line_start_ = 0;
-    std::size_t start_bytes_ = 0;
-};
-
-// Global tracker instance inside namespace
-inline HeapTracker __global_heap_tracker;
+inline void operator delete(void* ptr, std::size_t) noexcept {
+    operator delete(ptr);
+}
 
-}  // namespace Heap
+inline void operator delete[](void* ptr, std::size_t) noexcept {
+    operator delete[](ptr);
+}
 
-// Macros
-#define HEAP_START() Heap::__global_heap_tracker.start(__FILE__, __LINE__)
-#define HEAP_END() Heap::__global_heap_tracker.stop(__FILE__, __LINE__)
\ No newline at end of file
+// Regions are measured by the hierarchical profiler in profiler.h.
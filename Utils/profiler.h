@@ -0,0 +1,306 @@
+// profiler.h
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "cudd.h"
+#include "heap_counter.h"
+
+// Scoped, nestable profiler. Each thread keeps its own stack of open
+// regions; closed regions are collected in one registry and written out as
+// a JSON tree and as folded stacks ("a;b;c <us>") for flamegraph.pl.
+//
+//     {
+//         PROFILE_SCOPE("symbolicReachability");
+//         ...
+//         PROFILE_CUDD(mgr);  // sample manager stats into this region
+//     }
+//
+// Heap start/end come from heap_counter.h and are process-wide. A region's
+// peak is its start plus the most its own thread's allocations rose during
+// it, so regions open on other threads do not disturb it.
+namespace Prof {
+
+using Clock = std::chrono::steady_clock;
+
+struct CuddStats {
+    bool present = false;
+    std::size_t memoryInUse = 0;   // Cudd_ReadMemoryInUse
+    int peakLiveNodes = 0;         // Cudd_ReadPeakLiveNodeCount
+    int garbageCollections = 0;    // Cudd_ReadGarbageCollections
+    unsigned int reorderings = 0;  // Cudd_ReadReorderings
+};
+
+struct Region {
+    int id = 0;
+    int parent = -1;  // id of the enclosing region on the same thread
+    int thread = 0;
+    int depth = 0;
+    std::string name;
+    std::string path;  // names from the outermost region, ';'-separated
+    double startMs = 0;
+    double wallMs = 0;
+    double cpuMs = 0;
+    std::size_t heapStart = 0;
+    std::size_t heapEnd = 0;
+    std::size_t heapPeak = 0;
+    std::size_t heapAllocated = 0;  // bytes requested inside the region
+    CuddStats cudd;
+};
+
+inline double threadCpuMs() {
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+#else
+    return 1e3 * std::clock() / CLOCKS_PER_SEC;  // process time
+#endif
+}
+
+class Registry {
+   public:
+    static Registry& instance() {
+        static Registry registry;
+        return registry;
+    }
+
+    int newId() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return nextId_++;
+    }
+
+    int threadIndex() {
+        thread_local int index = -1;
+        if (index < 0) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            index = nextThread_++;
+        }
+        return index;
+    }
+
+    // Closed regions are kept only while recording; a process that never
+    // writes a report (the server) turns it off so they do not pile up.
+    void add(const Region& r) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (recording_) regions_.push_back(r);
+    }
+
+    void setRecording(bool on) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        recording_ = on;
+        if (!on) regions_.clear();
+    }
+
+    std::vector<Region> regions() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<Region> copy = regions_;
+        std::sort(copy.begin(), copy.end(),
+                  [](const Region& a, const Region& b) { return a.id < b.id; });
+        return copy;
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        regions_.clear();
+    }
+
+    double sinceEpochMs(Clock::time_point t) const {
+        return std::chrono::duration<double, std::milli>(t - epoch_).count();
+    }
+
+   private:
+    std::mutex mutex_;
+    std::vector<Region> regions_;
+    int nextId_ = 0;
+    int nextThread_ = 0;
+    bool recording_ = true;
+    Clock::time_point epoch_ = Clock::now();
+};
+
+// Open region of the current thread
+struct Frame {
+    Region region;
+    Clock::time_point start;
+    double cpuStart;
+    std::size_t allocatedStart;
+    std::ptrdiff_t threadStart;  // __thread_heap_bytes when it opened
+    std::ptrdiff_t outerPeak;    // the enclosing region's thread peak
+};
+
+inline std::vector<Frame>& stack() {
+    thread_local std::vector<Frame> frames;
+    return frames;
+}
+
+inline void begin(const std::string& name) {
+    Registry& reg = Registry::instance();
+    std::vector<Frame>& frames = stack();
+
+    Frame f;
+    f.region.id = reg.newId();
+    f.region.thread = reg.threadIndex();
+    f.region.depth = static_cast<int>(frames.size());
+    f.region.name = name;
+    if (frames.empty()) {
+        f.region.path = name;
+    } else {
+        f.region.parent = frames.back().region.id;
+        f.region.path = frames.back().region.path + ";" + name;
+    }
+    f.region.heapStart = __total_heap_bytes.load();
+    f.allocatedStart = __allocated_heap_bytes.load();
+    // Restart this thread's peak so the region sees its own maximum; end()
+    // folds it back into the enclosing one.
+    f.threadStart = __thread_heap_bytes;
+    f.outerPeak = __thread_peak_heap_bytes;
+    __thread_peak_heap_bytes = __thread_heap_bytes;
+    f.cpuStart = threadCpuMs();
+    f.start = Clock::now();
+    f.region.startMs = reg.sinceEpochMs(f.start);
+    frames.push_back(f);
+}
+
+inline void end() {
+    std::vector<Frame>& frames = stack();
+    if (frames.empty()) return;
+
+    Clock::time_point now = Clock::now();
+    Frame f = frames.back();
+    frames.pop_back();
+
+    Region& r = f.region;
+    r.wallMs = std::chrono::duration<double, std::milli>(now - f.start).count();
+    r.cpuMs = threadCpuMs() - f.cpuStart;
+    r.heapEnd = __total_heap_bytes.load();
+    r.heapAllocated = __allocated_heap_bytes.load() - f.allocatedStart;
+    std::ptrdiff_t rise =
+        std::max<std::ptrdiff_t>(0, __thread_peak_heap_bytes - f.threadStart);
+    r.heapPeak = r.heapStart + static_cast<std::size_t>(rise);
+    __thread_peak_heap_bytes =
+        std::max(f.outerPeak, __thread_peak_heap_bytes);
+
+    Registry::instance().add(r);
+}
+
+// Records the manager's statistics in the innermost open region. Call it
+// while the manager is alive (before Cudd_Quit); the last sample wins.
+inline void sampleCudd(DdManager* mgr) {
+    std::vector<Frame>& frames = stack();
+    if (frames.empty() || mgr == nullptr) return;
+    CuddStats& s = frames.back().region.cudd;
+    s.present = true;
+    s.memoryInUse = Cudd_ReadMemoryInUse(mgr);
+    s.peakLiveNodes =
+        std::max(s.peakLiveNodes, Cudd_ReadPeakLiveNodeCount(mgr));
+    s.garbageCollections = Cudd_ReadGarbageCollections(mgr);
+    s.reorderings = Cudd_ReadReorderings(mgr);
+}
+
+class Scope {
+   public:
+    explicit Scope(const std::string& name) { begin(name); }
+    ~Scope() { end(); }
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+};
+
+inline std::string jsonEscape(const std::string& s) {
+    std::string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+inline bool writeJSON(const std::string& fileName) {
+    std::ofstream out(fileName);
+    if (!out.is_open()) return false;
+    std::vector<Region> regions = Registry::instance().regions();
+
+    out << "{\n  \"heap_peak_bytes\": " << __peak_heap_bytes.load()
+        << ",\n  \"regions\": [";
+    for (size_t i = 0; i < regions.size(); ++i) {
+        const Region& r = regions[i];
+        out << (i ? ",\n" : "\n") << "    {\"id\": " << r.id
+            << ", \"parent\": " << r.parent << ", \"thread\": " << r.thread
+            << ", \"depth\": " << r.depth << ", \"name\": \""
+            << jsonEscape(r.name) << "\", \"path\": \"" << jsonEscape(r.path)
+            << "\", \"start_ms\": " << r.startMs
+            << ", \"wall_ms\": " << r.wallMs << ", \"cpu_ms\": " << r.cpuMs
+            << ", \"heap\": {\"start\": " << r.heapStart
+            << ", \"end\": " << r.heapEnd << ", \"peak\": " << r.heapPeak
+            << ", \"allocated\": " << r.heapAllocated << "}";
+        if (r.cudd.present) {
+            out << ", \"cudd\": {\"memory_in_use\": " << r.cudd.memoryInUse
+                << ", \"peak_live_nodes\": " << r.cudd.peakLiveNodes
+                << ", \"garbage_collections\": " << r.cudd.garbageCollections
+                << ", \"reorderings\": " << r.cudd.reorderings << "}";
+        }
+        out << "}";
+    }
+    out << "\n  ]\n}\n";
+    return true;
+}
+
+// One line per region: "thread-N;outer;inner <self time in us>"
+inline bool writeFolded(const std::string& fileName) {
+    std::ofstream out(fileName);
+    if (!out.is_open()) return false;
+    std::vector<Region> regions = Registry::instance().regions();
+
+    std::map<int, double> childWall;
+    for (const Region& r : regions) {
+        if (r.parent >= 0) childWall[r.parent] += r.wallMs;
+    }
+    for (const Region& r : regions) {
+        double self = std::max(0.0, r.wallMs - childWall[r.id]);
+        out << "thread-" << r.thread << ";" << r.path << " "
+            << static_cast<long long>(self * 1000) << "\n";
+    }
+    return true;
+}
+
+// Writes <prefix>.json and <prefix>.folded
+inline bool writeReport(const std::string& prefix) {
+    bool ok = writeJSON(prefix + ".json");
+    return writeFolded(prefix + ".folded") && ok;
+}
+
+// Indented summary, one line per region
+inline void printSummary(FILE* out = stdout) {
+    std::vector<Region> regions = Registry::instance().regions();
+    std::string text = "\n[Profile]\n";
+    char line[256];
+    for (const Region& r : regions) {
+        std::snprintf(line, sizeof(line),
+                      "%*s%s: %.4f ms wall, %.4f ms cpu, peak %zu KB",
+                      2 * r.depth, "", r.name.c_str(), r.wallMs, r.cpuMs,
+                      r.heapPeak / 1024);
+        text += line;
+        if (r.cudd.present) {
+            std::snprintf(line, sizeof(line), ", %d peak BDD nodes",
+                          r.cudd.peakLiveNodes);
+            text += line;
+        }
+        text += "\n";
+    }
+    std::fputs(text.c_str(), out);
+}
+
+}  // namespace Prof
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) \
+    Prof::Scope PROFILE_CONCAT(__profile_scope_, __LINE__)(name)
+#define PROFILE_CUDD(mgr) Prof::sampleCudd(mgr)
@@ -0,0 +1,790 @@
+// Benchmark suite over the synthetic net families of net_generator.h.
+//
+// Every (family, N) runs parsing, explicit BFS, symbolic reachability,
+// symbolic deadlock detection and Task 5 optimization, the last three once
+// on BDDs and once on ZDDs (zdd_* stages), and symbolic reachability with
+// the image split over the hardware threads (parallel_symbolic, at least
+// 2), then compares time, peak heap and node/state counts with a stored
+// baseline. Task 5 also runs through ADDs (add_optimization, same maximum
+// as the recursive one; add_pairwise, with pairwise cost terms against the
+// explicit reachable set), for 64 costs vectors in one pass
+// (optimization_batch, checked against one Task 5 run per vector) and as
+// the top-k and Pareto queries (checked against the explicit reachable
+// set); a failed check is reported as WRONG. The server ops run once on a
+// net that is not 1-safe and once on an unbounded one (server/3 rows).
+//
+// Each family runs at a size where the engines take tens of ms (see
+// defaultSize): symbolic cost follows the BDD size since the per-transition
+// relations, so small nets only measure manager setup. That setup, timed
+// once per run (cudd_setup), is taken out of the symbolic stages, and the
+// sub-ms query stages are repeated over a 20 ms window and report the mean.
+//
+//     ./bench.exe                      compare with bench/baseline.csv
+//     ./bench.exe --update             rewrite the baseline
+//     ./bench.exe --families mutex,kanban --sizes 2,4 --tolerance 0.5
+//     ./bench.exe --repeats 5
+//     ./bench.exe --kernels            SIMD firing kernel microbenchmarks
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "deadlock_ILP.h"
+#include "firing_kernel.h"
+#include "net_generator.h"
+#include "optimization.h"
+#include "optimization_add.h"
+#include "parallel_bdd.h"
+#include "profiler.h"
+#include "reachability.h"
+#include "server.h"
+#include "thread_pool.h"
+#include "zdd.h"
+
+using namespace std;
+
+struct StageResult {
+    string family;
+    int N = 0;
+    string stage;
+    double ms = 0;
+    size_t peakKB = 0;    // peak heap above the stage start (+ CUDD memory)
+    double states = 0;    // markings / dead markings / max value
+    long long nodes = 0;  // BDD nodes of the stage result
+    bool wrong = false;   // disagrees with the explicit reachable set
+};
+
+struct BenchOptions {
+    string baseline = "bench/baseline.csv";
+    bool update = false;
+    bool kernels = false;     // --kernels: firing kernels only
+    double tolerance = 0.25;  // relative slack for time and memory
+    double minMs = 2.0;       // time differences below this are noise
+    int repeats = 3;          // best time of this many runs is kept
+    size_t minKB = 64;        // memory differences below this are noise
+    vector<string> families = netFamilyNames();
+    vector<int> sizes;        // empty: defaultSize of each family
+};
+
+// Size at which the family's explicit and symbolic engines take tens of ms
+// (token ring: symbolic only, its 2N markings are explored at once)
+static int defaultSize(NetFamily family) {
+    switch (family) {
+        case NetFamily::Philosophers: return 12;
+        case NetFamily::TokenRing: return 50;
+        case NetFamily::Kanban: return 7;
+        case NetFamily::FMS: return 8;
+        case NetFamily::Mutex: return 12;
+        case NetFamily::ProducerConsumer: return 15;
+    }
+    return 2;
+}
+
+// Size at which the family has at least 10^5 reachable markings, for the
+// kernel microbenchmarks; 0 for the token ring (2N markings)
+static int kernelSize(NetFamily family) {
+    switch (family) {
+        case NetFamily::Philosophers: return 14;  // 228,486
+        case NetFamily::TokenRing: return 0;
+        case NetFamily::Kanban: return 9;         // 262,144
+        case NetFamily::FMS: return 9;            // 137,781
+        case NetFamily::Mutex: return 14;         // 131,072
+        case NetFamily::ProducerConsumer: return 17;  // 131,072
+    }
+    return 0;
+}
+
+static vector<string> splitList(const string& s) {
+    vector<string> out;
+    stringstream ss(s);
+    string item;
+    while (getline(ss, item, ',')) {
+        if (!item.empty()) out.push_back(item);
+    }
+    return out;
+}
+
+// Runs f with library output muted; returns time and heap peak.
+template <typename F>
+static void measure(StageResult& r, F f) {
+    ostringstream sink;
+    streambuf* old = cout.rdbuf(sink.rdbuf());
+
+    size_t base = __total_heap_bytes.load();
+    __peak_heap_bytes = base;
+    auto start = chrono::steady_clock::now();
+    f();
+    r.ms = chrono::duration<double, milli>(chrono::steady_clock::now() -
+                                           start)
+               .count();
+    r.peakKB = (__peak_heap_bytes.load() - base) / 1024;
+
+    cout.rdbuf(old);
+}
+
+// measure for stages that leave no state behind: f runs until the calls
+// fill 20 ms, and r.ms is the mean per call
+template <typename F>
+static void measureRepeated(StageResult& r, F f) {
+    measure(r, f);
+    double total = r.ms;
+    if (total >= 20) return;
+    int calls = 1;
+    StageResult more;
+    measure(more, [&] {
+        auto start = chrono::steady_clock::now();
+        do {
+            f();
+            ++calls;
+        } while (chrono::duration<double, milli>(chrono::steady_clock::now() -
+                                                 start)
+                     .count() < 20);
+    });
+    r.ms = (total + more.ms) / calls;
+}
+
+// Best time of Cudd_Init for one manager, plus one per worker thread as
+// parallelSymbolicReachability creates them; subtracted from the symbolic
+// stages so they time the engines
+static double cuddSetupMs(int workers, int repeats) {
+    double best = 0;
+    for (int k = 0; k < max(3, repeats); ++k) {
+        vector<DdManager*> mgrs(workers + 1, nullptr);
+        auto start = chrono::steady_clock::now();
+        mgrs[0] = Cudd_Init(0, 0, CUDD_UNIQUE_SLOTS, CUDD_CACHE_SLOTS, 0);
+        if (workers > 0) {
+            ThreadPool pool(workers);
+            for (int w = 1; w <= workers; ++w) {
+                pool.submit([&, w] {
+                    mgrs[w] = Cudd_Init(0, 0, CUDD_UNIQUE_SLOTS,
+                                        CUDD_CACHE_SLOTS, 0);
+                });
+            }
+            pool.wait();
+        }
+        double ms = chrono::duration<double, milli>(
+                        chrono::steady_clock::now() - start)
+                        .count();
+        for (DdManager* m : mgrs) Cudd_Quit(m);
+        if (k == 0 || ms < best) best = ms;
+    }
+    return best;
+}
+
+static int parallelThreads(const PetriNet& net) {
+    int threads = max(2u, thread::hardware_concurrency());
+    return max(1, min(threads, int(net.transitions.size())));
+}
+
+// Value of M under costs
+static double value(const Marking& M, const vector<int>& costs) {
+    double v = 0;
+    for (size_t p = 0; p < M.size(); ++p) v += double(M[p]) * costs[p];
+    return v;
+}
+
+// Value of M under obj, linear and pairwise terms
+static double value(const Marking& M, const AddObjective& obj) {
+    double v = 0;
+    for (size_t p = 0; p < M.size(); ++p) v += M[p] * obj.linear[p];
+    for (const auto& t : obj.pairwise) v += t.weight * M[t.p] * M[t.q];
+    return v;
+}
+
+// Top-k result against all reachable markings: reachable witnesses with
+// the values claimed, and the k best values
+static bool checkTopK(const OptimizationTopKResult& res,
+                      const vector<Marking>& reach, const vector<int>& costs,
+                      int k) {
+    set<Marking> all(reach.begin(), reach.end());
+    vector<double> expected, got;
+    for (const auto& M : reach) expected.push_back(value(M, costs));
+    sort(expected.rbegin(), expected.rend());
+    expected.resize(min<size_t>(k, expected.size()));
+    for (const auto& e : res.best) {
+        if (!all.count(e.marking) || value(e.marking, costs) != e.value)
+            return false;
+        got.push_back(e.value);
+    }
+    return got == expected;
+}
+
+// Pareto front against all reachable markings: reachable witnesses, and
+// the non-dominated value vectors, each once
+static bool checkPareto(const OptimizationParetoResult& res,
+                        const vector<Marking>& reach,
+                        const vector<vector<int>>& objectives) {
+    set<Marking> all(reach.begin(), reach.end());
+    set<vector<double>> points, expected, got;
+    for (const auto& M : reach) {
+        vector<double> v;
+        for (const auto& c : objectives) v.push_back(value(M, c));
+        points.insert(v);
+    }
+    for (const auto& v : points) {
+        bool dominated = false;
+        for (const auto& w : points) {
+            bool geq = true;
+            for (size_t j = 0; j < v.size(); ++j) geq &= w[j] >= v[j];
+            dominated |= geq && w != v;
+        }
+        if (!dominated) expected.insert(v);
+    }
+    for (const auto& p : res.front) {
+        vector<double> v;
+        for (const auto& c : objectives) v.push_back(value(p.marking, c));
+        if (!all.count(p.marking) || v != p.values) return false;
+        got.insert(v);
+    }
+    return got == expected && got.size() == res.front.size();
+}
+
+static vector<StageResult> runFamily(NetFamily family, int N,
+                                     const BenchOptions& options) {
+    string name = netFamilyName(family);
+    vector<StageResult> out;
+    auto stage = [&](const string& s) {
+        StageResult r;
+        r.family = name;
+        r.N = N;
+        r.stage = s;
+        return r;
+    };
+
+    filesystem::create_directories("generated_files/bench");
+    string file =
+        "generated_files/bench/" + name + "_" + to_string(N) + ".pnml";
+    writePNML(generateNet(family, N), file);
+
+    PetriNet net;
+    StageResult parse = stage("parse");
+    measureRepeated(parse, [&] { net = toPetriNet(toRaw(file)); });
+    out.push_back(parse);
+
+    // engine-independent, so kept out of the stage times below
+    StageResult setup = stage("cudd_setup");
+    setup.ms = cuddSetupMs(0, options.repeats);
+    double parallelSetupMs =
+        cuddSetupMs(parallelThreads(net), options.repeats);
+    out.push_back(setup);
+
+    vector<Marking> reach;
+    StageResult expl = stage("explicit");
+    measure(expl, [&] {
+        reach = explicitReachability(net);
+        expl.states = reach.size();
+    });
+    out.push_back(expl);
+
+    ReachableContext ctx;
+    StageResult symb = stage("symbolic");
+    measure(symb, [&] {
+        ctx = buildReachableContext(net);
+        symb.states = Cudd_CountMinterm(ctx.mgr, ctx.R, net.places.size());
+    });
+    symb.ms = max(0.0, symb.ms - setup.ms);
+    symb.nodes = Cudd_DagSize(ctx.R);
+    symb.peakKB += Cudd_ReadMemoryInUse(ctx.mgr) / 1024;  // CUDD uses malloc
+    out.push_back(symb);
+
+    StageResult dead = stage("deadlock");
+    measure(dead, [&] {
+        DdNode* D = deadMarkingsBDD(ctx.mgr, net, ctx.x);
+        DdNode* RD = Cudd_bddAnd(ctx.mgr, ctx.R, D);
+        Cudd_Ref(RD);
+        Cudd_RecursiveDeref(ctx.mgr, D);
+        dead.states = Cudd_CountMinterm(ctx.mgr, RD, net.places.size());
+        dead.nodes = Cudd_DagSize(RD);
+        Cudd_RecursiveDeref(ctx.mgr, RD);
+    });
+    out.push_back(dead);
+
+    StageResult opt = stage("optimization");
+    measureRepeated(opt, [&] {
+        vector<int> costs(net.places.size());
+        for (size_t p = 0; p < costs.size(); ++p) costs[p] = p % 3 - 1;
+        opt.states = optimizationTask5Function(ctx.mgr, ctx.R, costs).maxValue;
+    });
+    out.push_back(opt);
+
+    // the same objective through ADDs (nodes: the objective ADD); the
+    // maximum must be the recursive one
+    StageResult addOpt = stage("add_optimization");
+    measure(addOpt, [&] {
+        vector<int> costs(net.places.size());
+        for (size_t p = 0; p < costs.size(); ++p) costs[p] = p % 3 - 1;
+        PlaceEncoding enc = oneBitEncoding(net.places.size());
+        AddObjective obj = linearObjective(costs);
+        addOpt.states = optimizationADD(ctx.mgr, ctx.R, enc, obj).maxValue;
+        DdNode* f = buildObjectiveADD(ctx.mgr, enc, obj);
+        addOpt.nodes = Cudd_DagSize(f);
+        Cudd_RecursiveDeref(ctx.mgr, f);
+    });
+    addOpt.wrong = addOpt.states != opt.states;
+    out.push_back(addOpt);
+
+    // the linear costs plus M(p) * M(p + 1) terms (every 4th p), which the
+    // recursive engine cannot sum: max and maximizer by enumeration of reach
+    StageResult addPair = stage("add_pairwise");
+    AddObjective quadratic;
+    for (size_t p = 0; p < net.places.size(); ++p) {
+        quadratic.linear.push_back(int(p % 3) - 1);
+        if (p % 4 == 0 && p + 1 < net.places.size()) {
+            double weight = p % 8 ? -1 : 2;
+            quadratic.pairwise.push_back({int(p), int(p + 1), weight});
+        }
+    }
+    PlaceEncoding pairEnc = oneBitEncoding(net.places.size());
+    OptimizationTask5Result pairBest;
+    measureRepeated(addPair, [&] {
+        pairBest = optimizationADD(ctx.mgr, ctx.R, pairEnc, quadratic);
+    });
+    DdNode* pairF = buildObjectiveADD(ctx.mgr, pairEnc, quadratic);
+    addPair.nodes = Cudd_DagSize(pairF);
+    Cudd_RecursiveDeref(ctx.mgr, pairF);
+    addPair.states = pairBest.maxValue;
+    double pairMax = value(reach[0], quadratic);
+    for (const auto& M : reach) pairMax = max(pairMax, value(M, quadratic));
+    addPair.wrong = !pairBest.found || pairBest.maxValue != pairMax ||
+                    find(reach.begin(), reach.end(),
+                         pairBest.optimalMarking) == reach.end() ||
+                    value(pairBest.optimalMarking, quadratic) != pairMax;
+    out.push_back(addPair);
+
+    // 64 costs vectors in one traversal, each checked against its own
+    // optimizationTask5Function run: same maximum, reachable maximizer
+    StageResult batch = stage("optimization_batch");
+    vector<vector<int>> costMatrix(64, vector<int>(net.places.size()));
+    for (size_t m = 0; m < costMatrix.size(); ++m) {
+        for (size_t p = 0; p < net.places.size(); ++p)
+            costMatrix[m][p] = int((p * 7 + m * 3) % 5) - 2;
+    }
+    OptimizationBatchResult many;
+    measureRepeated(batch, [&] {
+        many = optimizationBatch(ctx.mgr, ctx.R, costMatrix);
+    });
+    set<Marking> all(reach.begin(), reach.end());
+    for (size_t m = 0; m < costMatrix.size(); ++m) {
+        batch.states += many.maxValues[m];
+        OptimizationTask5Result one =
+            optimizationTask5Function(ctx.mgr, ctx.R, costMatrix[m]);
+        batch.wrong |= one.maxValue != many.maxValues[m] ||
+                       !all.count(many.optimalMarkings[m]) ||
+                       value(many.optimalMarkings[m], costMatrix[m]) !=
+                           many.maxValues[m];
+    }
+    out.push_back(batch);
+
+    StageResult topk = stage("topk");
+    vector<int> costs(net.places.size());
+    for (size_t p = 0; p < costs.size(); ++p) costs[p] = p % 3 - 1;
+    OptimizationTopKResult best;
+    measureRepeated(topk, [&] {
+        best = optimizationTopK(ctx.mgr, ctx.R, costs, 10);
+    });
+    for (const auto& e : best.best) topk.states += e.value;
+    topk.wrong = !checkTopK(best, reach, costs, 10);
+    out.push_back(topk);
+
+    StageResult pareto = stage("pareto");
+    vector<vector<int>> objectives = {costs, vector<int>(costs.size())};
+    for (size_t p = 0; p < costs.size(); ++p) objectives[1][p] = p % 2 == 0;
+    OptimizationParetoResult front;
+    measureRepeated(pareto, [&] {
+        front = optimizationPareto(ctx.mgr, ctx.R, objectives);
+    });
+    pareto.states = front.front.size();
+    pareto.wrong = !checkPareto(front, reach, objectives);
+    out.push_back(pareto);
+
+    freeReachableContext(ctx);
+
+    EncodedReachable pr;
+    StageResult par = stage("parallel_symbolic");
+    measure(par, [&] {
+        pr = parallelSymbolicReachability(
+            net, oneBitEncoding(net.places.size()), true,
+            parallelThreads(net));
+        par.states = Cudd_CountMinterm(pr.mgr, pr.R, pr.nvars);
+    });
+    par.ms = max(0.0, par.ms - parallelSetupMs);
+    par.nodes = Cudd_DagSize(pr.R);
+    par.peakKB += Cudd_ReadMemoryInUse(pr.mgr) / 1024;
+    out.push_back(par);
+    freeEncodedReachable(pr);
+
+    // the same stages on a ZDD (all families are 1-safe)
+    ZddReachable zr;
+    StageResult zsymb = stage("zdd_symbolic");
+    measure(zsymb, [&] {
+        zr = zddReachability(net);
+        zsymb.states = zddCount(zr);
+    });
+    zsymb.ms = max(0.0, zsymb.ms - setup.ms);
+    zsymb.nodes = Cudd_zddDagSize(zr.R);
+    zsymb.peakKB += Cudd_ReadMemoryInUse(zr.mgr) / 1024;
+    out.push_back(zsymb);
+
+    StageResult zdead = stage("zdd_deadlock");
+    measure(zdead, [&] {
+        DdNode* RD = zddDeadMarkings(zr);
+        zdead.states = Cudd_zddCountDouble(zr.mgr, RD);
+        zdead.nodes = Cudd_zddDagSize(RD);
+        Cudd_RecursiveDerefZdd(zr.mgr, RD);
+    });
+    out.push_back(zdead);
+
+    StageResult zopt = stage("zdd_optimization");
+    measureRepeated(zopt, [&] {
+        vector<int> costs(net.places.size());
+        for (size_t p = 0; p < costs.size(); ++p) costs[p] = p % 3 - 1;
+        zopt.states = zddOptimization(zr, costs).maxValue;
+    });
+    out.push_back(zopt);
+
+    freeZddReachable(zr);
+    return out;
+}
+
+// Server ops through serverRequest. Three tokens moved along a chain of
+// three places reach 10 markings, the only dead one being [0, 0, 3]; a
+// transition that puts its token back and adds one elsewhere is unbounded
+// and must be refused.
+static vector<StageResult> runServerChecks() {
+    vector<StageResult> out;
+    auto write = [](const string& file, int tokens, bool pump) {
+        RawData raw;
+        raw.Blocks = {{"p0", tokens}, {"p1", 0}, {"p2", 0},
+                      {"t0", -1},     {"t1", -1}};
+        raw.Arcs = {{"a0", "p0", "t0"}, {"a1", "t0", "p1"},
+                    {"a2", "p1", "t1"}, {"a3", "t1", "p2"}};
+        if (pump) raw.Arcs.push_back({"a4", "t0", "p0"});
+        writePNML(raw, file);
+    };
+    filesystem::create_directories("generated_files/bench");
+    string chain = "generated_files/bench/server_chain.pnml";
+    string pump = "generated_files/bench/server_pump.pnml";
+    write(chain, 3, false);
+    write(pump, 1, true);
+
+    vector<pair<string, string>> checks = {
+        {"count", "\"states\": 10,"},
+        {"deadlock", "\"marking\": [0, 0, 3]"},
+        {"reachable", "\"reachable\": true"},
+        {"optimize", "\"max_value\": 3,"},
+    };
+    for (const auto& [op, expected] : checks) {
+        StageResult r;
+        r.family = "server";
+        r.N = 3;
+        r.stage = op;
+        string response;
+        measure(r, [&] {
+            string req = "{\"op\": \"" + op + "\", \"net\": \"" + chain +
+                         "\", \"marking\": [0, 0, 3], \"costs\": [0, 0, 1]}";
+            response = serverRequest(req);
+        });
+        r.wrong = response.find(expected) == string::npos;
+        out.push_back(r);
+    }
+    // M(p1) * M(p2) + M(p2) on markings of 3 tokens: 4 at [0, 1, 2]
+    StageResult pairs;
+    pairs.family = "server";
+    pairs.N = 3;
+    pairs.stage = "optimize_pair";
+    string answer;
+    measure(pairs, [&] {
+        answer = serverRequest("{\"op\": \"optimize\", \"net\": \"" + chain +
+                               "\", \"costs\": [0, 0, 1], "
+                               "\"costs_pair\": [[1, 2, 1]]}");
+    });
+    pairs.wrong = answer.find("\"max_value\": 4,") == string::npos;
+    out.push_back(pairs);
+    StageResult r;
+    r.family = "server";
+    r.N = 3;
+    r.stage = "unbounded";
+    string response;
+    measure(r, [&] {
+        response = serverRequest("{\"op\": \"count\", \"net\": \"" + pump +
+                                 "\"}");
+    });
+    r.wrong = response.find("is unbounded") == string::npos;
+    out.push_back(r);
+    return out;
+}
+
+// Best ns per marking of f over passes of at least 20 ms
+template <typename F>
+static double nsPerMarking(size_t markings, int repeats, F f) {
+    double best = 0;
+    for (int r = 0; r < repeats; ++r) {
+        size_t passes = 0;
+        auto start = chrono::steady_clock::now();
+        double ns = 0;
+        do {
+            f();
+            ++passes;
+            ns = chrono::duration<double, nano>(chrono::steady_clock::now() -
+                                                start)
+                     .count();
+        } while (ns < 20e6);
+        double per = ns / passes / max<size_t>(1, markings);
+        if (r == 0 || per < best) best = per;
+    }
+    return best;
+}
+
+// Enabledness and successor generation over the reachable markings of
+// each net: is_enabled / fire_transition, then the batch kernels at every
+// level this CPU has, in both row layouts. Kernel results must match the
+// scalar kernel's. Without --sizes every family runs at kernelSize, so
+// the rows stream through memory as in a real BFS.
+static int runKernelBench(const BenchOptions& opt) {
+    int mismatches = 0;
+    char line[256];
+    snprintf(line, sizeof(line), "%-13s %3s %-7s %-10s %8s %12s %10s %8s  %s\n",
+             "family", "N", "layout", "level", "markings", "enabled_ns",
+             "succ_ns", "speedup", "status");
+    cout << line;
+    for (const auto& name : opt.families) {
+        NetFamily family;
+        if (!parseNetFamily(name, family)) {
+            cerr << "Unknown family " << name << "\n";
+            return 2;
+        }
+        vector<int> sizes = opt.sizes;
+        if (sizes.empty() && kernelSize(family) > 0)
+            sizes.push_back(kernelSize(family));
+        for (int N : sizes) {
+            PetriNet net = toPetriNet(generateNet(family, N));
+            vector<Marking> reach;
+            StageResult ignored;
+            measure(ignored, [&] { reach = explicitReachability(net); });
+            size_t n = reach.size();
+            int T = static_cast<int>(net.transitions.size());
+            auto print = [&](const char* layout, const char* level,
+                             double enabledNs, double succNs, double ref,
+                             const char* status) {
+                snprintf(line, sizeof(line),
+                         "%-13s %3d %-7s %-10s %8zu %12.1f %10.1f %7.2fx  "
+                         "%s\n",
+                         name.c_str(), N, layout, level, n, enabledNs, succNs,
+                         ref / succNs, status);
+                cout << line;
+            };
+
+            // the per-marking, per-transition path of explicitReachability
+            volatile size_t sink = 0;  // keeps the loops
+            double refEnabled = nsPerMarking(n, opt.repeats, [&] {
+                for (const auto& M : reach)
+                    for (int t = 0; t < T; ++t)
+                        sink = sink + is_enabled(M, t, net);
+            });
+            double refSucc = nsPerMarking(n, opt.repeats, [&] {
+                for (const auto& M : reach) {
+                    for (int t = 0; t < T; ++t) {
+                        if (is_enabled(M, t, net))
+                            sink = sink + fire_transition(M, t, net)[0];
+                    }
+                }
+            });
+            print("-", "reference", refEnabled, refSucc, refSucc, "ok");
+
+            for (bool safe : {true, false}) {
+                FiringKernel k = buildFiringKernel(net, safe);
+                vector<uint64_t> rows(n * k.rowWords);
+                for (size_t i = 0; i < n; ++i)
+                    packMarking(k, reach[i], rows.data() + i * k.rowWords);
+                vector<uint64_t> expected(n * k.maskWords);
+                enabledBatch(k, rows.data(), n, expected.data(),
+                             SimdLevel::Scalar);
+                vector<uint64_t> mask(n * k.maskWords), succ;
+                vector<uint32_t> from;
+                vector<int> via;
+                for (int l = 0; l <= int(detectSimdLevel()); ++l) {
+                    SimdLevel level = static_cast<SimdLevel>(l);
+                    // BFS-sized chunks, as batchedReachability runs them
+                    auto chunks = [&](auto f) {
+                        for (size_t i = 0; i < n; i += 1024)
+                            f(i, min<size_t>(1024, n - i));
+                    };
+                    double enabledNs = nsPerMarking(n, opt.repeats, [&] {
+                        chunks([&](size_t i, size_t c) {
+                            enabledBatch(k, rows.data() + i * k.rowWords, c,
+                                         mask.data() + i * k.maskWords,
+                                         level);
+                        });
+                    });
+                    double succNs = nsPerMarking(n, opt.repeats, [&] {
+                        chunks([&](size_t i, size_t c) {
+                            succ.clear();
+                            from.clear();
+                            via.clear();
+                            successorBatch(k, rows.data() + i * k.rowWords, c,
+                                           level, succ, from, via);
+                        });
+                    });
+                    bool same = mask == expected;
+                    if (!same) ++mismatches;
+                    print(k.safe ? "bitset" : "int32", simdLevelName(level),
+                          enabledNs, succNs, refSucc,
+                          same ? "ok" : "MISMATCH");
+                }
+                if (!k.safe) break;  // the bitset layout did not apply
+            }
+        }
+    }
+    cout << mismatches << " mismatch(es) against the scalar kernel\n";
+    return mismatches == 0 ? 0 : 1;
+}
+
+static string key(const StageResult& r) {
+    return r.family + "/" + to_string(r.N) + "/" + r.stage;
+}
+
+static const char* CSV_HEADER = "family,N,stage,ms,peak_kb,states,nodes";
+
+static void writeCSV(const vector<StageResult>& results, const string& path) {
+    ofstream out(path);
+    out << CSV_HEADER << "\n";
+    for (const auto& r : results) {
+        out << r.family << "," << r.N << "," << r.stage << "," << r.ms << ","
+            << r.peakKB << "," << r.states << "," << r.nodes << "\n";
+    }
+}
+
+static map<string, StageResult> readCSV(const string& path) {
+    map<string, StageResult> rows;
+    ifstream in(path);
+    string line;
+    getline(in, line);  // header
+    while (getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        vector<string> f = splitList(line);
+        if (f.size() != 7) continue;
+        StageResult r;
+        r.family = f[0];
+        r.N = stoi(f[1]);
+        r.stage = f[2];
+        r.ms = stod(f[3]);
+        r.peakKB = stoul(f[4]);
+        r.states = stod(f[5]);
+        r.nodes = stoll(f[6]);
+        rows[key(r)] = r;
+    }
+    return rows;
+}
+
+// Status of one result against its baseline row
+static string compare(const StageResult& r, const StageResult& b,
+                      const BenchOptions& opt) {
+    if (r.states != b.states || r.nodes != b.nodes) return "MISMATCH";
+    if (r.ms > b.ms * (1 + opt.tolerance) && r.ms - b.ms > opt.minMs)
+        return "SLOWER";
+    if (r.peakKB > b.peakKB * (1 + opt.tolerance) &&
+        r.peakKB - b.peakKB > opt.minKB)
+        return "MEMORY";
+    return "ok";
+}
+
+int main(int argc, char** argv) {
+    BenchOptions opt;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        auto next = [&]() -> string {
+            return i + 1 < argc ? argv[++i] : string();
+        };
+        if (arg == "--update") {
+            opt.update = true;
+        } else if (arg == "--kernels") {
+            opt.kernels = true;
+        } else if (arg == "--baseline") {
+            opt.baseline = next();
+        } else if (arg == "--tolerance") {
+            opt.tolerance = stod(next());
+        } else if (arg == "--repeats") {
+            opt.repeats = max(1, stoi(next()));
+        } else if (arg == "--families") {
+            opt.families = splitList(next());
+        } else if (arg == "--sizes") {
+            opt.sizes.clear();
+            for (const auto& s : splitList(next()))
+                opt.sizes.push_back(stoi(s));
+        } else {
+            cerr << "Unknown option " << arg << "\n";
+            return 2;
+        }
+    }
+
+    if (opt.kernels) return runKernelBench(opt);
+
+    map<string, StageResult> baseline;
+    if (!opt.update) baseline = readCSV(opt.baseline);
+
+    vector<StageResult> results;
+    int regressions = 0;
+    string report;
+    char line[256];
+    snprintf(line, sizeof(line), "%-13s %3s %-18s %10s %9s %12s %8s  %s\n",
+             "family", "N", "stage", "ms", "peak_kb", "states", "nodes",
+             "status");
+    report += line;
+
+    for (const auto& name : opt.families) {
+        NetFamily family;
+        if (!parseNetFamily(name, family)) {
+            cerr << "Unknown family " << name << "\n";
+            return 2;
+        }
+        vector<int> sizes = opt.sizes;
+        if (sizes.empty()) sizes.push_back(defaultSize(family));
+        for (int N : sizes) {
+            vector<StageResult> runs = runFamily(family, N, opt);
+            for (int k = 1; k < opt.repeats; ++k) {
+                vector<StageResult> again = runFamily(family, N, opt);
+                for (size_t s = 0; s < runs.size(); ++s)
+                    runs[s].ms = min(runs[s].ms, again[s].ms);
+            }
+            for (const auto& r : runs) {
+                results.push_back(r);
+                string status = "new";
+                auto it = baseline.find(key(r));
+                if (it != baseline.end()) status = compare(r, it->second, opt);
+                if (r.wrong) status = "WRONG";
+                if (status != "ok" && status != "new") ++regressions;
+                snprintf(line, sizeof(line),
+                         "%-13s %3d %-18s %10.3f %9zu %12.0f %8lld  %s\n",
+                         r.family.c_str(), r.N, r.stage.c_str(), r.ms,
+                         r.peakKB, r.states, r.nodes, status.c_str());
+                report += line;
+            }
+        }
+    }
+    for (const auto& r : runServerChecks()) {
+        results.push_back(r);
+        string status = r.wrong ? "WRONG" : "ok";
+        if (r.wrong) ++regressions;
+        snprintf(line, sizeof(line),
+                 "%-13s %3d %-18s %10.3f %9zu %12.0f %8lld  %s\n",
+                 r.family.c_str(), r.N, r.stage.c_str(), r.ms, r.peakKB,
+                 r.states, r.nodes, status.c_str());
+        report += line;
+    }
+    cout << report;
+
+    if (opt.update) {
+        writeCSV(results, opt.baseline);
+        cout << "Baseline written to " << opt.baseline << "\n";
+        return 0;
+    }
+    cout << regressions << " regression(s) against " << opt.baseline << "\n";
+    return regressions == 0 ? 0 : 1;
+}
@@ -0,0 +1,225 @@
+#pragma once
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "budget.h"
+#include "checkpoint.h"
+#include "jit.h"
+#include "optimization.h"
+#include "optimization_add.h"
+#include "parallel_bdd.h"
+#include "pnml_parser.h"
+
+// Non-interactive driver shared by the command line front end: runs the
+// selected tasks on one net and collects the results in a report that can
+// be rendered as human-readable text, JSON or CSV.
+
+enum class OutputFormat { Human, JSON, CSV };
+
+bool parseOutputFormat(const string& name, OutputFormat& format);
+
+struct AnalysisOptions {
+    set<int> tasks = {1, 2, 3, 4, 5};
+    // engine per task group, selected with --engine group=name
+    string explicitEngine = "bfs";  // Task 2: bfs | batch | jit |
+                                    // coverability
+    string symbolicEngine = "bdd";       // Task 3: bdd | zdd | parallel
+    string deadlockEngine = "ilp";  // Task 4: ilp | bdd | sim | astar |
+                                    // best-first | unfolding | zdd
+    string optEngine = "recursive";      // Task 5: recursive | add | zdd
+    string simd = "auto";  // explicit=batch: auto | scalar | avx2 | avx512
+    JitOptions jit;        // explicit=jit: compiler and object cache
+    int threads = 1;  // for engines that run in parallel (symbolic=parallel)
+    int samples = 5;                     // sample markings printed by Task 2
+    vector<int> costs;                   // Task 5, empty = all 1
+    vector<PairwiseTerm> costPairs;      // Task 5: + weight * M(p) * M(q)
+    int optTopK = 0;                     // Task 5: also the k best markings
+    vector<vector<int>> paretoObjectives;  // Task 5: Pareto front over these
+    vector<vector<int>> costSweep;  // Task 5: max for each, one traversal
+    Marking coverTarget;  // coverability query, empty = none
+    size_t walks = 1000;        // deadlock=sim: random walks
+    size_t walkLength = 100000;  // firings per walk
+    uint64_t seed = 1;
+    size_t prefixEvents = 20000;       // deadlock=unfolding: event limit
+    vector<string> ctl;                // CTL formulas (ctl.h) to check
+    Marking reachTarget;               // guided search for this marking
+    string heuristic = "tokens";       // guided search: tokens | lp
+    size_t searchLimit = 1000000;      // markings generated by a search
+    bool verbose = false;                // keep the engines' own messages
+    bool compress = false;               // drop invariant-implied places
+    bool reduce = false;                 // structural reduction first
+    bool traces = false;  // Task 2 keeps BFS parents: shortest deadlock trace
+    bool graph = false;   // reachability graph and its SCCs
+    string graphOut;      // binary graph file (reachability_graph.h)
+    string checkpoint;    // file prefix: Tasks 2-3 checkpoint and resume
+    double checkpointEvery = 60;  // seconds between checkpoints
+    Budget budget;        // Task 2 and the shared Task 3 BDD (budget.h)
+    string fallback = "none";  // after a budget stop: none | bitstate | sim
+    string encoding = "auto";  // auto: from token bounds | safe: 1 bit/place
+};
+
+// Engines report progress on cout; while a MuteCout(true) is alive that goes
+// to a sink so that only the report reaches the output. Counted, because
+// batch mode analyzes several nets at once and cout is shared.
+class MuteCout {
+   public:
+    explicit MuteCout(bool mute);
+    ~MuteCout();
+    MuteCout(const MuteCout&) = delete;
+    MuteCout& operator=(const MuteCout&) = delete;
+
+   private:
+    bool mute_;
+};
+
+// Sets the engine of one group ("explicit", "symbolic", "deadlock", "opt")
+bool setEngine(AnalysisOptions& opt, const string& assignment);
+
+// One guided search (guided_search.h): Task 4 with deadlock=astar or
+// best-first, or the --reach / --cover target search
+struct SearchReport {
+    bool done = false;
+    string goal;  // deadlock | reach | cover
+    bool found = false;
+    Marking marking;
+    vector<string> trace;  // transition ids from M0
+    bool exhausted = false;  // not found and nothing left to expand
+    size_t expanded = 0;
+    size_t generated = 0;
+    size_t pruned = 0;
+};
+
+// One CTL formula checked on the reachable set (ctl.h)
+struct CtlReport {
+    string formula;  // canonical form
+    bool holds = false;
+    double states = 0;  // reachable markings satisfying it
+    bool hasPath = false;  // witness (E) or counterexample (A) from M0
+    vector<string> trace;  // transition ids
+    Marking marking;       // end of the path
+};
+
+struct AnalysisReport {
+    string file;
+    int places = 0;
+    int transitions = 0;
+    Marking initialMarking;
+
+    bool reduced = false;  // Tasks 2-4 ran on the reduced net
+    int reducedPlaces = 0;
+    int reducedTransitions = 0;
+    bool countsExact = true;  // state counts equal the original net's
+    vector<pair<string, int>> reductionRules;  // rule, times applied
+
+    bool boundsDone = false;  // token bounds computed (--encoding auto)
+    bool oneSafe = true;
+    long long maxBound = -1;     // -1: some place has no known bound
+    string encoding = "safe";    // safe: 1 bit per place | binary
+    int encodingBits = 0;        // BDD variables of Tasks 3-5
+    int markingWidth = 4;        // bytes per place in Task 2's visited set
+
+    bool compressed = false;  // invariants computed, engines compressed
+    int pInvariants = 0;
+    int tInvariants = 0;
+    int impliedPlaces = 0;
+
+    bool coverabilityDone = false;  // Task 2 by Karp-Miller
+    size_t coverBasis = 0;          // minimal coverability set size
+    size_t coverNodes = 0;
+    vector<string> unboundedPlaces;
+    bool coverQueried = false;
+    bool coverable = false;
+    vector<int> skippedTasks;  // dropped because the net is unbounded
+
+    bool explicitDone = false;
+    size_t explicitStates = 0;
+    size_t parentBytes = 0;   // --traces: the BFS parent table
+    string explicitKernel;    // explicit=batch: SIMD level and layout
+    int stateWords = 0;       // fixed-size states of N words (fixed_state.h)
+    string jitStatus;  // explicit=jit: cached, compile time or the error
+    vector<Marking> samples;  // with OMEGA entries under coverability
+
+    bool graphDone = false;  // --graph, on the original net
+    size_t graphStates = 0;
+    size_t graphEdges = 0;
+    uint32_t sccs = 0;
+    size_t bottomSccs = 0;
+    bool reversible = false;
+    size_t homeStates = 0;
+    Marking homeState;                // the first one, in BFS order
+    vector<string> notLive;           // transition ids
+    vector<string> neverFired;
+    size_t graphBytes = 0;            // written to graphOut
+
+    bool symbolicDone = false;
+    double symbolicStates = 0;
+    int bddNodes = 0;
+    bool zddNodes = false;  // symbolic=zdd: bddNodes counts ZDD nodes
+    ParallelImageStats parallel;  // symbolic=parallel, threads > 0
+
+    // --checkpoint: Task 2 BFS log and symbolic reachability snapshots
+    bool explicitCheckpointed = false;
+    CheckpointStats explicitCheckpoint;
+    bool symbolicCheckpointed = false;
+    CheckpointStats symbolicCheckpoint;
+
+    // --budget-*: the engine that ran out and where it stopped
+    bool budgetStopped = false;
+    string budgetReason;         // time | memory | nodes
+    bool explicitPartial = false;  // explicitStates is a lower bound
+    size_t explicitFrontier = 0;   // discovered markings left unexpanded
+    bool symbolicPartial = false;  // the shared BDD is a lower bound
+    size_t symbolicLevels = 0;     // BFS iterations completed
+    double symbolicFrontier = 0;   // markings of the last one
+    string fallback;               // engine run after the stop, if any
+    size_t fallbackStates = 0;     // bitstate: markings stored, lower bound
+    bool fallbackComplete = false;  // bitstate search ended in its budget
+    double hashFactor = 0;          // bitstate: table bits per marking
+    size_t fallbackWalks = 0;       // sim: random walks and their firings
+    size_t fallbackFirings = 0;
+    bool fallbackDeadlock = false;  // found by the fallback, see Task 4
+    bool ctlSkipped = false;  // the reachable set was partial
+
+    bool deadlockDone = false;
+    bool deadlockFound = false;
+    Marking deadMarking;
+    bool deadlockExhaustive = true;  // false: random walks (deadlock=sim)
+                                     // or a truncated prefix
+    size_t simWalks = 0;
+    size_t simFirings = 0;
+    vector<string> deadlockTrace;  // transition ids from M0: sim, unfolding
+                                   // or --traces
+    bool shortestTrace = false;    // from the Task 2 BFS tree
+    bool prefixDone = false;       // deadlock=unfolding
+    size_t prefixEvents = 0;
+    size_t prefixConditions = 0;
+    size_t prefixCutoffs = 0;
+    bool prefixComplete = false;
+    size_t satConflicts = 0;
+    SearchReport deadlockSearch;   // deadlock=astar | best-first
+    SearchReport targetSearch;     // --reach, or --cover without coverability
+    vector<CtlReport> ctl;
+
+    bool optDone = false;
+    bool optLowerBound = false;  // maximized over a partial reachable set
+    OptimizationTask5Result opt;
+    vector<RankedMarking> optTopK;  // --opt-topk, best first
+    vector<ParetoPoint> optPareto;  // --opt-pareto
+    OptimizationBatchResult optSweep;  // --costs-sweep
+    string optQuerySkipped;  // why top-k / Pareto / the sweep did not run
+
+    vector<pair<string, double>> taskMs;  // time per task, in run order
+    string error;                         // empty when the run succeeded
+};
+
+AnalysisReport analyzeNet(const PetriNet& net, const AnalysisOptions& opt);
+
+// Parses fileName and analyzes it (Task 1 is the parsing itself).
+AnalysisReport analyzeFile(const string& fileName, const AnalysisOptions& opt);
+
+// Rendering; CSV rows share one header (csvHeader).
+string formatReport(const AnalysisReport& report, OutputFormat format);
+string csvHeader();
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "analysis.h"
+
+// Batch mode: analyzes many nets on a pool of worker threads and streams one
+// JSON line per net as soon as it finishes.
+//
+// Workers take the nets in input order and parse each one only when they
+// take it, so at most one net per worker is in memory; it is freed once its
+// line is written. Before a net runs, a bounded explicit probe estimates its
+// state space and the memory it will need, and the worker waits until the
+// estimate fits in what is left of the memory budget (reservations and the
+// measured RSS, whichever is larger). A net larger than the whole budget
+// still runs, but alone.
+
+struct BatchOptions {
+    AnalysisOptions analysis;
+    int jobs = 0;                // worker threads, 0 = hardware concurrency
+    size_t memoryBudget = 0;     // bytes, 0 = 3/4 of physical memory
+    size_t probeStates = 20000;  // cap of the estimating exploration
+};
+
+struct NetEstimate {
+    size_t states = 0;
+    bool exact = false;  // the probe explored the whole state space
+    size_t bytes = 0;    // memory the selected tasks are expected to use
+};
+
+// Bounded BFS of at most probeStates markings; when it does not finish, the
+// net is assumed to have P times more states than were seen (capped at 2^P).
+NetEstimate estimateNet(const PetriNet& net, const AnalysisOptions& opt,
+                        size_t probeStates);
+
+// *.pnml below a directory (recursively, sorted), the file itself for a
+// .pnml path, otherwise a manifest with one path per line ('#' comments).
+vector<string> collectBatchInputs(const string& path);
+
+// Writes one JSON object per net to out; returns the number of failed nets.
+int runBatch(const vector<string>& files, const BatchOptions& options,
+             ostream& out);
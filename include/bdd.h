@@ -4,16 +4,111 @@
 #include <set>
 #include <vector>
 
+#include "budget.h"
+#include "checkpoint.h"
 #include "cudd.h"
+#include "invariants.h"
 #include "pnml_parser.h"
 #include "reachability.h"
 
-DdNode* compute_post(DdManager* mgr, DdNode* R,
-                     const vector<vector<int>>& incidence, int t,
-                     const vector<DdNode*>& x, const vector<DdNode*>& x_next);
-// just removed static state of this function and add it in this header
-
 DdNode* symbolicReachability(const PetriNet& net);
 
 DdNode* make_marking(DdManager* mgr, DdNode** x, const std::vector<int>& bits,
                      int n);
+
+// Reachable set over the kept places of a PlaceCompression, one variable per
+// kept place (x[i] is place pc.kept[i]). Implied places are functions of
+// these, so Cudd_CountMinterm(R, x.size()) counts full markings.
+struct CompressedReachable {
+    DdManager* mgr = nullptr;
+    vector<DdNode*> x;
+    DdNode* R = nullptr;
+};
+
+CompressedReachable symbolicReachability(const PetriNet& net,
+                                         const PlaceCompression& pc);
+void freeCompressedReachable(CompressedReachable& cr);
+
+// Mapping of places onto BDD variables: bits[p] lists the variable indices
+// that hold the token count of place p, least significant bit first.
+// 1-safe nets use one variable per place (oneBitEncoding).
+struct PlaceEncoding {
+    vector<vector<int>> bits;
+};
+
+// place p -> variable p, the layout of symbolicReachability_in_mgr
+PlaceEncoding oneBitEncoding(int P);
+
+// Firing of every transition, built once per manager and shared by the
+// forward images of the reachability engines and the backward images of
+// the CTL checker (ctl.h). Neither direction needs next-state variables.
+//
+// safe: one variable per place with the 1-safe update (pre places
+// cleared, post places set), so for the places t changes
+//   post_t(S) = (exists changed. S & guard) & values
+//   pre_t(S)  = (exists changed. S & values) & guard
+// otherwise binary counters, firing t being value(p) += C[p][t]:
+//   post_t(S) = (S & guard)(y - C[.][t]) & range
+//   pre_t(S)  = S(m + C[.][t]) & fires
+struct TransitionRelations {
+    DdManager* mgr = nullptr;
+    PlaceEncoding enc;
+    int nvars = 0;
+    bool safe = true;
+    vector<DdNode*> guard;            // t is enabled
+    vector<DdNode*> changed, values;  // safe
+    // counters: y - C inside the bits, guard with m + C inside the bits
+    vector<DdNode*> range, fires;
+    vector<vector<DdNode*>> backward, forward;  // y - C, m + C
+};
+
+TransitionRelations buildTransitionRelations(DdManager* mgr,
+                                             const PetriNet& net,
+                                             const PlaceEncoding& enc,
+                                             bool safe);
+void freeTransitionRelations(TransitionRelations& tr);
+
+// Successors and predecessors of S through t, Ref'd. postImage returns
+// NULL if the manager gives up under a limit (budget.h).
+DdNode* postImage(const TransitionRelations& tr, DdNode* S, int t);
+DdNode* preImage(const TransitionRelations& tr, DdNode* S, int t);
+
+// Everything reachable from S (S included), frontier based, Ref'd.
+// checkpoint, when given, snapshots R and the frontier to its path +
+// ".bdd" between iterations (checkpoint.h) and resumes from a snapshot of
+// the same fingerprint and relations; its fingerprint must identify S.
+// budget, when given, limits the manager during the fixpoint (budget.h);
+// once it runs out, R is what the completed iterations reached.
+DdNode* forwardClosure(const TransitionRelations& tr, DdNode* S,
+                       const CheckpointOptions* checkpoint = nullptr,
+                       CheckpointStats* stats = nullptr,
+                       BudgetMonitor* budget = nullptr);
+
+// The single marking M over enc, Ref'd
+DdNode* markingBDD(DdManager* mgr, const PlaceEncoding& enc, const Marking& M);
+
+// Token counts as binary numbers: place p uses the variables enc.bits[p]
+// (least significant first), so bounded nets that are not 1-safe can be
+// explored symbolically. Firing t is the inverse substitution
+// value(p) := value(p) - C[p][t] through Cudd_bddVectorCompose, again
+// without next-state variables.
+struct EncodedReachable {
+    DdManager* mgr = nullptr;
+    PlaceEncoding enc;
+    int nvars = 0;
+    DdNode* R = nullptr;
+};
+
+EncodedReachable symbolicReachability(const PetriNet& net,
+                                      const PlaceEncoding& enc,
+                                      const CheckpointOptions* checkpoint =
+                                          nullptr,
+                                      CheckpointStats* stats = nullptr,
+                                      BudgetMonitor* budget = nullptr);
+void freeEncodedReachable(EncodedReachable& er);
+
+// value(bits) >= k, Ref'd
+DdNode* valueAtLeast(DdManager* mgr, const vector<int>& bits, long long k);
+
+// Marking of a cube picked from a BDD over enc (don't cares read as 0)
+Marking decodeMarking(const PlaceEncoding& enc, const vector<char>& cube);
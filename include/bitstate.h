@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "budget.h"
+#include "pnml_parser.h"
+
+using namespace std;
+
+// Bitstate (supertrace) exploration: a depth-first search that keeps no
+// markings, only k bits per visited marking in a table of 2^log2Bits bits.
+// A marking whose bits are all set already is taken as visited, so a hash
+// collision can hide part of the state space: the count is a lower bound
+// and a missing deadlock proves nothing. Memory is the table plus the DFS
+// stack, whatever the size of the state space, which makes it the fallback
+// when the exact engines run out of budget.
+//
+// With n markings stored, the chance that a new one is wrongly taken as
+// visited is about (1 - e^(-k n / m))^k for m bits: small while the hash
+// factor m / n stays above ~100.
+
+struct BitstateOptions {
+    int log2Bits = 29;  // 64 MB
+    int hashes = 3;     // k
+};
+
+struct BitstateResult {
+    size_t states = 0;    // markings stored
+    size_t maxDepth = 0;
+    bool complete = false;  // the search ended, not the budget
+    double hashFactor = 0;  // table bits per stored marking
+    bool deadlockFound = false;
+    Marking deadMarking;
+    vector<int> trace;  // transition indices from M0 (the DFS stack)
+};
+
+// log2Bits is lowered to fit half the memory budget, if there is one
+BitstateResult bitstateReachability(const PetriNet& net,
+                                    const BitstateOptions& opt,
+                                    BudgetMonitor* budget = nullptr);
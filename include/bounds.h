@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+
+#include "bdd.h"
+#include "pnml_parser.h"
+
+// Per-place token bounds, used to pick the cheapest correct encoding.
+//
+// Upper bounds come from the semi-positive P-invariants of the basis
+// (invariants.h) first, then, for the places none of them covers, from the
+// state equation: max M(p) subject to M = M0 + C sigma, M >= 0,
+// sigma >= 0 (an LP per place). When that does not already prove the net
+// 1-safe, a capped BFS sweep follows: it gives exact bounds when it
+// finishes and proves a place unbounded when a marking strictly covers one
+// of its ancestors. A sweep that hits the cap falls back to the Karp-Miller
+// coverability set (coverability.h), capped alike. The result is meant to
+// be computed once per net and handed to the engines that need it.
+struct PlaceBounds {
+    vector<long long> bound;  // -1: no finite bound known
+    vector<bool> exact;       // bound is reached by some reachable marking
+    bool sweepComplete = false;
+    size_t sweepStates = 0;
+    int unboundedPlace = -1;  // proved unbounded (covering path), else -1
+    size_t coverabilityNodes = 0;  // Karp-Miller nodes, when the sweep was cut
+
+    bool oneSafe() const;      // every bound <= 1
+    bool allBounded() const;   // every place has a finite bound
+    long long maxBound() const;
+};
+
+PlaceBounds computePlaceBounds(const PetriNet& net,
+                               size_t sweepCap = 100000);
+
+// Bits per place: 1 for safe places, ceil(log2(bound + 1)) otherwise,
+// variables numbered place after place. Needs allBounded().
+PlaceEncoding boundedEncoding(const PlaceBounds& bounds);
+
+// Bytes per token count in stored markings: 1, 2 or 4
+int markingWidth(const PlaceBounds& bounds);
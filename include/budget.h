@@ -0,0 +1,69 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+#include "cudd.h"
+
+using namespace std;
+
+// Resource budgets of one analysis run. An engine that runs out stops
+// where it is and hands back what it has: the markings found so far are
+// all reachable, so counts become lower bounds.
+//
+// Explicit engines poll exhausted() every thousand markings (wall time and
+// resident memory). BDD fixpoints also hand the limits to CUDD, which
+// makes the operation in progress return NULL once its node allocator sees
+// the time (Cudd_SetTimeLimit, wall time as well: util_cpu_time in
+// cudd_fix.cpp), memory (Cudd_SetMaxMemory) or
+// live node (Cudd_SetMaxLive) limit passed; the fixpoint then keeps the
+// last complete iteration.
+
+struct Budget {
+    double seconds = 0;     // wall time, 0: none
+    size_t memoryMB = 0;    // resident memory of the process, 0: none
+    unsigned bddNodes = 0;  // live nodes per CUDD manager, 0: none
+
+    bool any() const { return seconds > 0 || memoryMB > 0 || bddNodes > 0; }
+};
+
+// Resident set size of the process, 0 when unknown
+size_t residentBytes();
+
+class BudgetMonitor {
+   public:
+    // The clock starts here
+    explicit BudgetMonitor(const Budget& budget);
+
+    const Budget& budget() const { return budget_; }
+    double elapsedSeconds() const;
+
+    // What is left for a further engine: the time not yet spent (at least
+    // a millisecond, 0 would mean none), the memory and node limits as
+    // they are
+    Budget left() const;
+
+    // Checks time and memory; once over budget, stays stopped
+    bool exhausted();
+
+    // Hands what is left of the budget to mgr's own limits, and lifts
+    // them again, recording the cause if an operation gave up (NULL)
+    void limit(DdManager* mgr) const;
+    void release(DdManager* mgr);
+
+    // Where the engine that was stopped got to
+    void progress(size_t done, double frontier);
+    bool stopped() const { return stopped_; }
+    const string& reason() const { return reason_; }  // time|memory|nodes
+    size_t done() const { return done_; }  // markings expanded / levels
+    double frontier() const { return frontier_; }  // markings left waiting
+
+   private:
+    Budget budget_;
+    chrono::steady_clock::time_point start_;
+    bool stopped_ = false;
+    string reason_;
+    size_t done_ = 0;
+    double frontier_ = 0;
+};
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "cudd.h"
+#include "pnml_parser.h"
+
+using namespace std;
+
+// Checkpoints of long reachability runs, so that a killed run can be
+// started again with the same options and carry on where it stopped.
+//
+// Explicit BFS (PREFIX.states) is an append-only log: a header, then one
+// block per checkpoint with the markings discovered since the previous
+// block and how many markings have been expanded so far. A BFS stopped
+// after expanding its first k markings has discovered exactly the
+// markings in the blocks, so the visited set and the queue (the markings
+// from k on) come back from the log. A block is valid only with its end
+// tag, so a write cut short by a kill is dropped on reading.
+//
+//   header  char magic[4] = "PNST", uint32 version = 1,
+//           uint64 fingerprint, uint32 places, uint32 0
+//   block   uint64 count, uint64 expanded,
+//           int32 markings[count * places],
+//           uint32 parent[count], uint32 via[count],  (BFS tree)
+//           uint64 count ^ expanded ^ BLOCK_TAG
+//
+// Symbolic closure (PREFIX.bdd) is a snapshot of R, the frontier and the
+// iteration, written to PREFIX.bdd.tmp and renamed over the previous one,
+// so the file always holds a whole snapshot:
+//   header  char magic[4] = "PNBD", uint32 version = 1,
+//           uint64 fingerprint, uint32 variables, uint32 iteration,
+//           uint64 nodes
+//   node    uint32 variable, uint32 0, uint64 then, uint64 else
+//   roots   uint64 R, uint64 frontier
+// Nodes are listed children first. A reference is id << 1 | complement,
+// id 0 being the constant one and node i of the list having id i + 1.
+//
+// Both files carry a fingerprint of the explored net and the layout of
+// the state, and are ignored when it does not match, so a stale file is
+// overwritten by a fresh run rather than resumed.
+
+struct CheckpointOptions {
+    string path;            // file prefix, empty: no checkpoints
+    double seconds = 60;    // between writes; 0: as often as checked
+    uint64_t fingerprint = 0;  // set by the engines (netFingerprint)
+};
+
+struct CheckpointStats {
+    bool resumed = false;
+    size_t resumedAt = 0;  // markings expanded / iterations done
+    size_t writes = 0;
+    size_t bytes = 0;      // last file size
+    double writeMs = 0;    // time spent writing
+    double runMs = 0;      // the whole checkpointed run
+
+    double overhead() const { return runMs > 0 ? writeMs / runMs : 0; }
+};
+
+// FNV-1a over the places, the incidence matrix and M0
+uint64_t netFingerprint(const PetriNet& net);
+
+// --- Explicit BFS log ---
+
+struct StateLog {
+    size_t expanded = 0;
+    vector<Marking> states;         // discovery order
+    vector<uint32_t> parent, via;   // per state, as in ParentTable
+};
+
+// Loads every complete block of path into log and cuts a torn last block
+// off the file. False when there is no log of this fingerprint.
+bool loadStateLog(const string& path, uint64_t fingerprint, int places,
+                  StateLog& log);
+
+class StateLogWriter {
+   public:
+    // Appends to a log loadStateLog accepted (resume), else starts one
+    bool open(const string& path, uint64_t fingerprint, int places,
+              bool resume);
+    // One block: states[from..] with their parents, plus expanded
+    bool append(const vector<Marking>& states, size_t from,
+                const vector<uint32_t>& parent, const vector<uint32_t>& via,
+                size_t expanded);
+    size_t bytes() const { return bytes_; }
+
+   private:
+    ofstream out_;
+    int places_ = 0;
+    size_t bytes_ = 0;
+};
+
+// --- Symbolic snapshot ---
+
+// Writes R and frontier; returns the bytes written, 0 on failure
+size_t writeBddSnapshot(const string& path, uint64_t fingerprint,
+                        int variables, DdNode* R, DdNode* frontier,
+                        uint32_t iteration);
+
+// Rebuilds the snapshot in mgr, R and frontier Ref'd. False when there is
+// none of this fingerprint and number of variables.
+bool readBddSnapshot(const string& path, uint64_t fingerprint,
+                     DdManager* mgr, int variables, DdNode*& R,
+                     DdNode*& frontier, uint32_t& iteration);
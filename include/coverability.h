@@ -0,0 +1,44 @@
+#pragma once
+
+#include <climits>
+#include <cstddef>
+#include <vector>
+
+#include "pnml_parser.h"
+
+using namespace std;
+
+// Karp-Miller coverability for nets that may be unbounded.
+//
+// Markings are extended with OMEGA ("arbitrarily many tokens"). The tree is
+// built with omega-acceleration (a successor that strictly covers an
+// ancestor gets OMEGA wherever it grew) and with Reynier-Servais pruning:
+// a successor covered by an active node is dropped, and active nodes it
+// covers are deactivated together with their subtrees. Deactivated nodes
+// stay in the tree so that later accelerations can still use them. The
+// active nodes at the end form the minimal coverability set.
+
+const int OMEGA = INT_MAX;
+
+struct CoverabilitySet {
+    vector<Marking> basis;       // minimal coverability set (an antichain)
+    vector<bool> unbounded;      // per place: OMEGA in some basis marking
+    bool complete = false;       // false when maxNodes stopped the build
+    size_t nodes = 0;            // tree nodes created
+    size_t accelerations = 0;    // successors that received an OMEGA
+    size_t pruned = 0;           // successors covered by an active node
+    size_t deactivated = 0;      // nodes deactivated by a larger successor
+
+    bool bounded() const;
+    // Max tokens per place over the basis, -1 for unbounded places. Exact
+    // once complete.
+    vector<long long> bounds() const;
+    // Some reachable marking has at least target[p] tokens in every place
+    bool covers(const Marking& target) const;
+};
+
+// maxNodes = 0: no limit
+CoverabilitySet coverabilitySet(const PetriNet& net, size_t maxNodes = 0);
+
+// m1 <= m2 place by place, OMEGA above every number
+bool coveredBy(const Marking& m1, const Marking& m2);
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "bdd.h"
+#include "pnml_parser.h"
+
+using namespace std;
+
+// Symbolic CTL model checking over the reachable set R.
+//
+// Every subformula is evaluated once to the set of reachable markings
+// satisfying it (memoized on its canonical text), with the backward images
+// of TransitionRelations and fixpoints kept inside R:
+//   EX f     = R & OR_t pre_t(f)
+//   E[f U g] = mu Z. g | (f & EX Z)
+//   EG f     = nu Z. f & (EX Z | dead)
+// Paths are maximal, so a dead marking ends its only path: EG f holds on a
+// dead marking satisfying f and AX f holds on every dead marking. The
+// other operators are duals: AX f = !EX !f, AF f = !EG !f,
+// AG f = !EF !f, A[f U g] = !(E[!g U (!f & !g)] | EG !g).
+//
+// Grammar, loosest binding first:
+//   f    := g ['->' f]
+//   g    := h {'|' h}
+//   h    := u {'&' u}
+//   u    := '!' u | EX u | AX u | EF u | AF u | EG u | AG u
+//         | E '[' f U f ']' | A '[' f U f ']' | '(' f ')' | atom
+//   atom := true | false | deadlock | initial | en(T) | P [op N]
+// op is one of >= <= > < = !=, P and T are place and transition ids (in
+// double quotes when they clash with the syntax), and P alone is P >= 1.
+// Example: AG EF initial (reversibility), AG !deadlock, E[!p1 U p2 >= 2].
+
+enum class CtlOp {
+    True,
+    False,
+    Atom,
+    Initial,
+    Deadlock,
+    Enabled,
+    Not,
+    And,
+    Or,
+    Implies,
+    EX,
+    AX,
+    EF,
+    AF,
+    EG,
+    AG,
+    EU,
+    AU
+};
+
+struct CtlFormula {
+    CtlOp op = CtlOp::True;
+    int index = -1;  // Atom: place, Enabled: transition
+    string cmp;      // Atom: >= <= > < = !=
+    int value = 0;   // Atom
+    vector<CtlFormula> args;
+};
+
+// false with a message naming the position of the error
+bool parseCtl(const string& text, const PetriNet& net, CtlFormula& f,
+              string& error);
+
+// Fully parenthesized, the memoization key
+string ctlString(const CtlFormula& f, const PetriNet& net);
+
+struct CtlResult {
+    string formula;       // ctlString
+    bool holds = false;   // in M0
+    double states = 0;    // reachable markings satisfying the formula
+    // From M0: a witness when EX, EF or E[f U g] holds, a counterexample
+    // when AX or AG fails (path.back() violates the operand)
+    bool hasPath = false;
+    vector<int> trace;  // transition indices
+    vector<Marking> path;
+};
+
+// R must be the reachable set over tr.enc; formulas share one memo
+vector<CtlResult> checkCtl(const PetriNet& net, const TransitionRelations& tr,
+                           DdNode* R, const vector<CtlFormula>& formulas);
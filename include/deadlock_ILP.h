@@ -5,6 +5,7 @@
 #include <vector>
 
 #include "bdd.h"
+#include "bounds.h"
 #include "pnml_parser.h"
 
 // Kết quả trả về (nếu sau này tích hợp solver thì điền vào đây)
@@ -15,25 +16,47 @@ struct ILPResult {
 
 // Hàm tạo file .lp (LP Format) để giải bài toán Deadlock
 // Input: Mạng Petri, Tên file output
+// Place domains follow bounds (computed when null): Binary for places
+// bounded by 1, General with a big-M disabling constraint otherwise.
 void generateDeadlockILP(
     const PetriNet& net, const std::string& purename,
-    vector<vector<int>> forbidden);  // changed to purename, add forbidden (list
-                                     // of unreachable dead markings)
+    vector<vector<int>> forbidden,  // changed to purename, add forbidden (list
+                                    // of unreachable dead markings)
+    const PlaceBounds* bounds = nullptr);
 
 // Hàm kiểm tra nhanh xem một Marking có phải là Deadlock không (Dùng để verify
 // nghiệm)
 bool isMarkingDead(const std::vector<int>& marking, const PetriNet& net);
 
 bool solveILP(const string& purename);  // Call system->cplex.exe to solve
-ILPResult cplex(
-    const PetriNet& net,
-    vector<vector<int>> forbidden);  // call solveILP() and parse sol file
+ILPResult cplex(const PetriNet& net, vector<vector<int>> forbidden,
+                const PlaceBounds* bounds =
+                    nullptr);  // call solveILP() and parse sol file
 bool is_marking_in_R(
     DdManager* mgr, DdNode* R, const std::vector<DdNode*>& x,
     const std::vector<int>& M);  // check if a marking is reachable
-vector<int> findDeadlock(const PetriNet& net);
+// Bounds as for cplex (computed when null). A net with a place of no known
+// bound gets no answer: error is set (printed when null) and {} returned.
+vector<int> findDeadlock(const PetriNet& net,
+                         const PlaceBounds* bounds = nullptr,
+                         string* error = nullptr);
 
-// integrated copy of original symbolicReachability
+// Markings (over x) in which no transition is enabled, Ref'd. R & this BDD
+// is the set of reachable dead markings.
+DdNode* deadMarkingsBDD(DdManager* mgr, const PetriNet& net,
+                        const vector<DdNode*>& x);
+
+// integrated copy of original symbolicReachability; checkpoint and budget
+// as in forwardClosure
 DdNode* symbolicReachability_in_mgr(DdManager* mgr, const PetriNet& net,
                                     vector<DdNode*>& x,
-                                    vector<DdNode*>& x_next);
+                                    vector<DdNode*>& x_next,
+                                    const CheckpointOptions* checkpoint =
+                                        nullptr,
+                                    CheckpointStats* stats = nullptr,
+                                    BudgetMonitor* budget = nullptr);
+
+// Same over a multi-bit encoding: some input place holds fewer tokens than
+// the arc weight (-C[p][t]).
+DdNode* deadMarkingsBDD(DdManager* mgr, const PetriNet& net,
+                        const PlaceEncoding& enc);
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "budget.h"
+#include "pnml_parser.h"
+#include "reachability.h"
+
+using namespace std;
+
+// Batch enabledness and firing for a block of markings against all
+// transitions, with AVX2 and AVX-512 kernels picked at run time and a
+// scalar fallback that gives the same results.
+//
+// Markings are packed into rows of rowWords 64-bit words:
+// - safe nets (1-safe, arc weights 1): one bit per place. t is enabled
+//   iff pre(t) & ~M == 0, tested for 4 (AVX2) or 8 (AVX-512) transitions
+//   at once over a transposed table of pre sets; M' = (M & ~pre) | post.
+// - bounded nets: one int32 lane per place, padded to blocks of 16 lanes.
+//   t is enabled iff no lane of need(t) exceeds M, compared a block at a
+//   time over the blocks where t has input places; M' = M + delta(t).
+
+enum class SimdLevel { Scalar, AVX2, AVX512 };
+
+// Best level this CPU and build support
+SimdLevel detectSimdLevel();
+const char* simdLevelName(SimdLevel level);
+// auto | scalar | avx2 | avx512; auto and levels above the CPU's give
+// detectSimdLevel()
+bool parseSimdLevel(const string& name, SimdLevel& level);
+
+struct FiringKernel {
+    int places = 0;
+    int transitions = 0;
+    bool safe = false;
+    int rowWords = 0;   // words per packed marking
+    int maskWords = 0;  // words of enabled bits per marking
+    int paddedT = 0;    // transitions rounded up to 8
+
+    // safe: word w of the pre/post set of t at w * paddedT + t
+    vector<uint64_t> pre, post;
+
+    // bounded: lane p of t at t * lanes + p, lanes = 2 * rowWords; the
+    // 16-lane blocks t reads (need) or changes (delta), CSR style
+    vector<int32_t> need, delta;
+    vector<int> needStart, needBlock, deltaStart, deltaBlock;
+};
+
+// safe: the net is 1-safe (bounds.h); falls back to the bounded layout if
+// some arc weight is not 1
+FiringKernel buildFiringKernel(const PetriNet& net, bool safe);
+
+void packMarking(const FiringKernel& k, const Marking& M, uint64_t* row);
+Marking unpackMarking(const FiringKernel& k, const uint64_t* row);
+
+// Bit t of enabled[i * k.maskWords + t / 64] tells whether t is enabled
+// in row i of the count rows at rows
+void enabledBatch(const FiringKernel& k, const uint64_t* rows, size_t count,
+                  uint64_t* enabled, SimdLevel level);
+
+// Fires every enabled transition of every row, rows in order and
+// transitions by index within a row (the order of the scalar BFS).
+// Appends the successor rows to succ, their row index to from and the
+// transition to via; returns the number of successors.
+size_t successorBatch(const FiringKernel& k, const uint64_t* rows,
+                      size_t count, SimdLevel level, vector<uint64_t>& succ,
+                      vector<uint32_t>& from, vector<int>& via);
+
+// Explicit BFS over packed rows of k (built from net), expanding the
+// queue a chunk at a time. Markings come out in the order of
+// explicitReachability; parents and budget as there.
+vector<Marking> batchedReachability(const PetriNet& net,
+                                    const FiringKernel& k, SimdLevel level,
+                                    ParentTable* parents = nullptr,
+                                    BudgetMonitor* budget = nullptr);
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <vector>
+
+#include "bounds.h"
+#include "budget.h"
+#include "pnml_parser.h"
+#include "reachability.h"
+
+using namespace std;
+
+// Explicit BFS on markings packed into std::array<uint64_t, N>, with the
+// engine instantiated for N = 1, 2, 4, 8 and 16 words so that hashing,
+// equality, the enabledness test and firing unroll over N.
+//
+// Each place gets a field of bitlen(v) + 1 bits, v the larger of its
+// token bound and its heaviest input arc; fields do not straddle words.
+// The top bit of every field stays clear, so the fields of a word are
+// compared and updated together (SWAR):
+//   t enabled  iff  ((M | H) - pre(t)) & H == H   (no field borrows)
+//   M'         =    M - pre(t) + post(t)          (no borrow, no carry)
+// with H the top bits of all fields.
+
+struct FieldLayout {
+    vector<int> word, shift, bits;  // per place
+    int words = 0;                  // words used
+};
+
+// bound: tokens per place, every one finite (PlaceBounds::bound)
+FieldLayout fieldLayout(const PetriNet& net, const vector<long long>& bound);
+
+// Smallest instantiated N that holds the layout, 0 if none does
+int fixedStateWords(const FieldLayout& layout);
+
+// The same markings in the same order as explicitReachability(net),
+// parents, budget and edges as there; needs bounds.allBounded(). A layout
+// wider than 16 words runs the dynamic engine instead (with markingWidth
+// bytes per place); words, when given, receives the N used, 0 then.
+vector<Marking> fixedReachability(const PetriNet& net,
+                                  const PlaceBounds& bounds,
+                                  ParentTable* parents = nullptr,
+                                  BudgetMonitor* budget = nullptr,
+                                  int* words = nullptr,
+                                  EdgeTable* edges = nullptr);
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "bounds.h"
+#include "pnml_parser.h"
+
+using namespace std;
+
+// Guided search for a dead marking or a target marking: A* (f = g + h) or
+// greedy best-first (f = h) over a binary-heap priority queue, with g the
+// number of firings from M0.
+//
+// Heuristics:
+//  - StateEquation: the LP relaxation of the marking equation from the
+//    current marking, min sum(sigma) s.t. M + C sigma = target (>= for
+//    Cover). For a deadlock the 1-safe disabling rows of
+//    generateDeadlockILP are used (1-safe nets only, Tokens otherwise).
+//    It never overestimates, so A* traces are shortest, and an infeasible
+//    LP prunes the marking: the target is unreachable from it. The LP is
+//    solved when a marking is taken off the queue, not when generated.
+//  - Tokens (default): missing tokens (Cover), token distance (Reach) or
+//    the number of enabled transitions (Deadlock). Cheap, not admissible.
+
+enum class SearchGoal { Deadlock, Reach, Cover };
+enum class SearchHeuristic { StateEquation, Tokens };
+
+struct GuidedSearchOptions {
+    SearchGoal goal = SearchGoal::Deadlock;
+    Marking target;  // Reach / Cover
+    SearchHeuristic heuristic = SearchHeuristic::Tokens;
+    bool greedy = false;        // best-first on h alone
+    size_t maxStates = 1000000;  // markings generated before giving up
+    // bounds of the net for the Deadlock LP; computed when null
+    const PlaceBounds* bounds = nullptr;
+};
+
+struct GuidedSearchResult {
+    bool found = false;
+    Marking marking;
+    vector<int> trace;       // transition indices from M0
+    bool exhausted = false;  // every marking not pruned was expanded
+    size_t expanded = 0;
+    size_t generated = 0;
+    size_t pruned = 0;  // markings whose LP was infeasible
+};
+
+GuidedSearchResult guidedSearch(const PetriNet& net,
+                                const GuidedSearchOptions& opt);
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "pnml_parser.h"
+
+// Place and transition invariants of the incidence matrix C.
+//
+// A P-invariant y satisfies y^T C = 0, so y . M = y . M0 for every
+// reachable M; a T-invariant x satisfies C x = 0 (firing x returns to the
+// same marking). Bases are computed by fraction-free integer elimination
+// (Hermite style) on sparse rows, so every vector is integral with gcd 1.
+
+// (index, coefficient) pairs, sorted by index, no zero coefficients
+using SparseVector = vector<pair<int, long long>>;
+
+struct InvariantBasis {
+    vector<SparseVector> vectors;
+    int dimension() const { return static_cast<int>(vectors.size()); }
+};
+
+// Basis of { y | y^T C = 0 } (indices are places)
+InvariantBasis pInvariantBasis(const vector<vector<int>>& C);
+
+// Basis of { x | C x = 0 } (indices are transitions)
+InvariantBasis tInvariantBasis(const vector<vector<int>>& C);
+
+// M[place] = (constant - sum coefficient * M[q]) / divisor, with every q a
+// kept place.
+struct ImpliedPlace {
+    int place;
+    long long constant;
+    long long divisor;  // > 0
+    SparseVector terms;
+};
+
+// Implied places removed through a P-invariant basis: the markings of the
+// kept places determine the rest.
+struct PlaceCompression {
+    int places = 0;    // P of the full net
+    vector<int> kept;  // increasing
+    vector<ImpliedPlace> implied;
+    InvariantBasis invariants;  // reduced basis the implied places come from
+
+    Marking compress(const Marking& full) const;
+    Marking expand(const Marking& compressed) const;
+};
+
+// One implied place per basis vector; identity compression when the net has
+// no P-invariants.
+PlaceCompression compressPlaces(const PetriNet& net);
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "budget.h"
+#include "fixed_state.h"
+#include "pnml_parser.h"
+#include "reachability.h"
+
+using namespace std;
+
+// Per-net code generation for the explicit engine.
+//
+// Markings are packed into the words of a FieldLayout (fixed_state.h), and
+// generateNetSource writes a C++ translation unit with one straight-line
+// block per transition: the guard-bit test of each word holding an input
+// place, then a copy of the marking with one constant added to each word
+// the transition changes. loadCompiledNet
+// compiles it with the local compiler into a shared object named after a
+// hash of the source, in the cache directory, and loads it (dlopen, or
+// LoadLibrary on Windows). A later run on the same net finds the object
+// and skips the compiler; objects are written under a temporary name and
+// renamed, so parallel runs can share a cache.
+//
+// The object exports
+//   int pn_places(), int pn_words(), int pn_transitions()
+//   int pn_successors(const uint64_t* M, uint64_t* out, int* via)
+// where pn_successors writes the successor of every enabled transition,
+// in transition order, as pn_words() words each to out and the
+// transition to via, and returns how many there are.
+
+struct JitOptions {
+    string cacheDir = "generated_files/jit";
+    string compiler = "g++";
+};
+
+using SuccessorsFn = int (*)(const uint64_t* M, uint64_t* out, int* via);
+
+struct CompiledNet {
+    void* handle = nullptr;
+    SuccessorsFn successors = nullptr;
+    int places = 0;
+    int transitions = 0;
+    FieldLayout layout;   // the packing compiled in
+    string path;          // the shared object
+    bool cached = false;  // found in the cache, not compiled
+    double compileMs = 0;
+};
+
+string generateNetSource(const PetriNet& net, const FieldLayout& layout);
+
+// Compiles (unless cached) and loads; false with error set on failure,
+// the temporaries removed from the cache
+bool loadCompiledNet(const PetriNet& net, const FieldLayout& layout,
+                     const JitOptions& opt, CompiledNet& out,
+                     string& error);
+void unloadCompiledNet(CompiledNet& cn);
+
+// Explicit BFS firing through cn, which must be built from net. The same
+// markings in the same order as explicitReachability(net); parents and
+// budget as there. Every place must stay within its layout field.
+vector<Marking> jitReachability(const PetriNet& net, const CompiledNet& cn,
+                                ParentTable* parents = nullptr,
+                                BudgetMonitor* budget = nullptr);
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "pnml_parser.h"
+
+// Scalable benchmark nets, sized by the number N of components.
+// All families are 1-safe, since the symbolic engines encode every place
+// with one BDD variable. Ids follow the WoPeD convention that toPetriNet
+// relies on: places start with 'p', transitions with 't'.
+enum class NetFamily {
+    Philosophers,      // N dining philosophers (has a deadlock)
+    TokenRing,         // N processes passing one token
+    Kanban,            // N kanban cells in a line, with rework loops
+    FMS,               // N machines sharing one robot for load/unload
+    Mutex,             // N processes around one shared lock
+    ProducerConsumer,  // chain of N one-slot buffers
+};
+
+vector<string> netFamilyNames();
+bool parseNetFamily(const string& name, NetFamily& family);
+string netFamilyName(NetFamily family);
+
+RawData generateNet(NetFamily family, int N);
+
+// Writes raw in the PNML layout that toRaw reads back.
+bool writePNML(const RawData& raw, const string& fileName);
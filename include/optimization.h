@@ -27,3 +27,69 @@ OptimizationTask5Result optimizationTask5Function(DdManager* mgr,
 
 OptimizationTask5Result runOptimizationTask5(const PetriNet& net,
                                              const vector<int>& costs);
+
+// Reachable set kept alive together with its manager, so that several
+// optimization queries can run on it without recomputing reachability.
+struct ReachableContext {
+    DdManager* mgr = nullptr;
+    vector<DdNode*> x, x_next;
+    DdNode* R = nullptr;
+};
+
+// checkpoint, budget: see forwardClosure
+ReachableContext buildReachableContext(const PetriNet& net,
+                                       const CheckpointOptions* checkpoint =
+                                           nullptr,
+                                       CheckpointStats* stats = nullptr,
+                                       BudgetMonitor* budget = nullptr);
+void freeReachableContext(ReachableContext& ctx);
+
+// One ranked marking of the reachable set.
+struct RankedMarking {
+    double value;
+    vector<int> marking;
+};
+
+// k best reachable markings for one costs vector, best first.
+struct OptimizationTopKResult {
+    vector<RankedMarking> best;
+    void print();
+};
+
+// One point of the Pareto front: a value per objective and a witness.
+struct ParetoPoint {
+    vector<double> values;
+    vector<int> marking;
+};
+
+// Non-dominated reachable markings for several costs vectors (maximized).
+struct OptimizationParetoResult {
+    vector<ParetoPoint> front;
+    void print();
+};
+
+// Both queries walk the reachable-set BDD once, keeping a bounded list of
+// partial results per node (k best paths / non-dominated value vectors).
+OptimizationTopKResult optimizationTopK(DdManager* mgr, DdNode* reachableSet,
+                                        const vector<int>& costs, int k);
+
+OptimizationParetoResult optimizationPareto(
+    DdManager* mgr, DdNode* reachableSet,
+    const vector<vector<int>>& objectives);  // objectives[j] = costs vector j
+
+// Maxima and maximizers for many costs vectors at once.
+struct OptimizationBatchResult {
+    vector<double> maxValues;             // maxValues[m] for costMatrix[m]
+    vector<vector<int>> optimalMarkings;  // argmax marking for costMatrix[m]
+    double seconds = 0;                   // time spent in the traversal
+    double vectorsPerSecond = 0;          // throughput
+    void print();
+};
+
+// Walks the reachable-set BDD once in topological order; every node holds
+// one value per costs vector in a contiguous padded row, so the per-node
+// loop runs over the cost dimension and GCC vectorizes it at -O2. The
+// maximizers are found again on the way down, without per-node choices.
+OptimizationBatchResult optimizationBatch(
+    DdManager* mgr, DdNode* reachableSet,
+    const vector<vector<int>>& costMatrix);  // costMatrix[m] = costs vector
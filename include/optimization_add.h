@@ -0,0 +1,32 @@
+#pragma once
+
+#include <vector>
+
+#include "cudd.h"
+#include "optimization.h"
+#include "pnml_parser.h"
+
+// weight * M(p) * M(q)
+struct PairwiseTerm {
+    int p;
+    int q;
+    double weight;
+};
+
+// Objective = sum_p linear[p] * M(p) + sum of pairwise terms
+struct AddObjective {
+    vector<double> linear;
+    vector<PairwiseTerm> pairwise;
+};
+
+AddObjective linearObjective(const vector<int>& costs);
+
+// Objective as an ADD over the encoding variables (returned Ref'd).
+DdNode* buildObjectiveADD(DdManager* mgr, const PlaceEncoding& enc,
+                          const AddObjective& obj);
+
+// Task 5 through ADDs: objective restricted to R, max by Cudd_addFindMax,
+// maximizer picked from the states that reach the max.
+OptimizationTask5Result optimizationADD(DdManager* mgr, DdNode* reachableSet,
+                                        const PlaceEncoding& enc,
+                                        const AddObjective& obj);
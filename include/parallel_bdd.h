@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vector>
+
+#include "bdd.h"
+#include "pnml_parser.h"
+
+using namespace std;
+
+// Symbolic reachability with the image split over worker threads.
+//
+// CUDD managers are not thread safe, so every worker owns a DdManager with
+// the same variables and the TransitionRelations of its share of the
+// transitions (round robin). Per BFS level each worker copies the frontier
+// out of the main manager with Cudd_bddTransfer (which only reads the
+// source), ORs its partial images, and the partial results are merged in a
+// reduction tree: at distance d = 1, 2, 4, ... worker w takes in the image
+// of worker w + d, pairs of one level running in parallel. Worker 0's
+// result goes back to the main manager, which keeps R and the frontier.
+
+struct ParallelIteration {
+    double wallMs = 0;      // the whole BFS level
+    double imageMs = 0;     // wall time of the partial images
+    double workMs = 0;      // CPU time of the images, summed over workers
+    double mergeMs = 0;     // wall time of the reduction tree
+    double transferMs = 0;  // CPU time in Cudd_bddTransfer, summed
+};
+
+struct ParallelImageStats {
+    int threads = 0;
+    vector<ParallelIteration> iterations;
+
+    // Image phase: summed worker CPU time / wall time
+    double speedup() const;
+    // Share of the workers' busy time spent copying between managers
+    double transferShare() const;
+};
+
+// safe: one variable per place (see TransitionRelations). threads is
+// capped by the number of transitions.
+EncodedReachable parallelSymbolicReachability(const PetriNet& net,
+                                              const PlaceEncoding& enc,
+                                              bool safe, int threads,
+                                              ParallelImageStats* stats =
+                                                  nullptr);
@@ -41,6 +41,7 @@ string extract(
 RawData cascade(string extracted);      // turn the extracted string into usable
                                         // data
 RawData toRaw(const string& fileName);  // composition of extract and cascade
+RawData rawFromText(const string& text);  // toRaw on PNML already read
 
 // A Marking is a vector of integers, representing the number of tokens in each
 // Place.
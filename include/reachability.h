@@ -1,14 +1,90 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <queue>
 #include <set>
 #include <vector>
 
+#include "budget.h"
+#include "checkpoint.h"
+#include "invariants.h"
 #include "pnml_parser.h"
 
 using namespace std;
 
-vector<Marking> explicitReachability(const PetriNet& net);
+// Shortest-path tree of the BFS, in flat arrays indexed like the returned
+// markings: state i was first reached from state parent[i] by firing
+// via(i). 6 bytes per state (8 with 65536 transitions or more) instead of
+// a stored path.
+struct ParentTable {
+    static const uint32_t NONE = UINT32_MAX;  // parent of M0
+
+    vector<uint32_t> parent;
+    vector<uint16_t> via16;
+    vector<uint32_t> via32;
+    bool wide = false;  // via32 in use
+
+    void reset(int transitions);
+    void record(uint32_t from, int t);
+    int via(size_t state) const { return wide ? via32[state] : via16[state]; }
+    size_t bytes() const;
+    // Transitions fired from M0 to state, walking back in O(depth)
+    vector<int> trace(size_t state) const;
+};
+
+// Successor lists of the BFS in compressed sparse row form, indexed like
+// the returned markings: firing label[e] in state s reaches state
+// target[e], for e in offset[s] .. offset[s + 1). Only returned markings
+// get a row, so after a budget stop some targets are past the result.
+struct EdgeTable {
+    vector<uint64_t> offset;  // one more than the rows
+    vector<uint32_t> target;
+    vector<uint32_t> label;
+
+    void reset();
+    void add(uint32_t to, int t) {
+        target.push_back(to);
+        label.push_back(static_cast<uint32_t>(t));
+    }
+    void close() { offset.push_back(target.size()); }  // ends a row
+    size_t edges() const { return target.size(); }
+};
+
+// parents, when given, records the BFS tree of the returned markings.
+// budget, when given, can stop the BFS early (budget.h): the result then
+// holds the expanded markings, and budget->frontier() more were found.
+// edges, when given, records every firing of the BFS.
+vector<Marking> explicitReachability(const PetriNet& net,
+                                     ParentTable* parents = nullptr,
+                                     BudgetMonitor* budget = nullptr,
+                                     EdgeTable* edges = nullptr);
+
+// Stores only the kept places of pc; returns full markings.
+vector<Marking> explicitReachability(const PetriNet& net,
+                                     const PlaceCompression& pc,
+                                     ParentTable* parents = nullptr,
+                                     BudgetMonitor* budget = nullptr,
+                                     EdgeTable* edges = nullptr);
+
+// Visited markings stored with width bytes per place (1, 2 or 4, see
+// markingWidth); every place must stay within that range.
+vector<Marking> explicitReachability(const PetriNet& net, int width,
+                                     ParentTable* parents = nullptr,
+                                     BudgetMonitor* budget = nullptr,
+                                     EdgeTable* edges = nullptr);
+
+// Plain BFS with checkpoints in cp.path + ".states" (checkpoint.h): a log
+// of the same net is resumed, and a block is appended every cp.seconds and
+// at the end. The result does not depend on where a run was interrupted;
+// a run stopped by its budget leaves a checkpoint to resume from. The log
+// keeps no edges: a resumed run refires the markings expanded before.
+vector<Marking> explicitReachability(const PetriNet& net,
+                                     const CheckpointOptions& cp,
+                                     CheckpointStats* stats = nullptr,
+                                     ParentTable* parents = nullptr,
+                                     BudgetMonitor* budget = nullptr,
+                                     EdgeTable* edges = nullptr);
 
 bool is_enabled(const Marking& M, int T_index, const PetriNet& net);
 
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "pnml_parser.h"
+
+using namespace std;
+
+// Reachability graph in compressed sparse row form. States are numbered in
+// BFS order (state 0 is M0); the successors of state s are
+// target[offset[s] .. offset[s + 1]), reached by firing transition label[i].
+// Task 2 records it: the markings it returns and their EdgeTable
+// (reachability.h).
+struct ReachabilityGraph {
+    int places = 0;
+    int transitions = 0;
+    vector<Marking> states;
+    vector<uint64_t> offset;  // states.size() + 1 entries
+    vector<uint32_t> target;
+    vector<uint32_t> label;
+
+    size_t edges() const { return target.size(); }
+};
+
+// Binary file, native byte order, every section starting on 8 bytes so
+// that the file can be mapped and read in place:
+//   header  char magic[4] = "PNRG", uint32 version = 1,
+//           uint32 places, uint32 transitions, uint64 states, uint64 edges
+//   int32   markings[states * places], padded to 8 bytes
+//   uint64  offset[states + 1]
+//   uint32  target[edges], padded to 8 bytes
+//   uint32  label[edges]
+// Returns the bytes written, 0 on failure.
+size_t writeReachabilityGraph(const ReachabilityGraph& g, const string& path);
+
+// Strongly connected components by iterative Tarjan. Every state is
+// reachable from M0, so the condensation has one source and:
+//  - the net is reversible iff there is a single SCC;
+//  - home states exist iff there is a single bottom SCC (no edge leaves
+//    it), and they are its states;
+//  - t is live iff it labels an edge in every bottom SCC, since every
+//    state reaches some bottom SCC and cannot leave it.
+struct SccAnalysis {
+    vector<uint32_t> component;  // per state; sinks get the lowest ids
+    uint32_t components = 0;
+    vector<bool> bottom;  // per component
+    size_t bottomCount = 0;
+    bool reversible = false;
+    vector<uint32_t> homeStates;  // empty unless one bottom SCC
+    vector<bool> live;            // per transition
+    vector<bool> fires;           // per transition: labels some edge
+};
+
+SccAnalysis analyzeSccs(const ReachabilityGraph& g);
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "bounds.h"
+#include "invariants.h"
+#include "pnml_parser.h"
+
+// Structural reduction of a PetriNet before exploration. Rules run until
+// none applies:
+//   constant place      row of C is zero: never changes, never blocks
+//   parallel place      same row and initial marking as another place
+//   parallel transition same column as another transition
+//   series place        t1 -> p -> t2 with p's only producer t1, only
+//                       consumer t2 and •t2 = {p}: fuse t1;t2
+//   series transition   p -> t -> q with •t = {p}, t• = {q}, p• = {t}:
+//                       producers of p put their token in q directly
+//   implicit place      state equation gives M(p) >= M(q) (row and M0 of p
+//                       dominate q's) and q is consumed wherever p is, so p
+//                       never is the only place disabling a transition;
+//                       only for a bounded p that a P-invariant rebuilds
+// All rules preserve deadlocks. The first three keep the reachable
+// markings in bijection; the others shrink the state space, so counts on
+// the reduced net are then only a lower bound (countsExact is false).
+enum class ReductionRule {
+    ConstantPlace,
+    ParallelPlace,
+    ParallelTransition,
+    SeriesPlace,
+    SeriesTransition,
+    ImplicitPlace,
+};
+const int REDUCTION_RULES = 6;
+
+string reductionRuleName(ReductionRule rule);
+
+struct RemovedPlace {
+    int place;  // index in the original net
+    ReductionRule rule;
+    int source = -1;  // ParallelPlace: original place with the same tokens
+    int value = 0;    // ConstantPlace: its token count
+};
+
+struct NetReduction {
+    PetriNet net;                          // reduced net
+    vector<int> placeOrigin;               // reduced place -> original
+    vector<vector<int>> transitionOrigin;  // reduced transition -> original
+                                           // transitions fired in sequence
+    vector<RemovedPlace> removed;          // in removal order
+    int applied[REDUCTION_RULES] = {};     // times each rule fired
+    int originalPlaces = 0;
+    int originalTransitions = 0;
+    bool countsExact = true;
+
+    // Original marking of a reduced one. Fused places are empty in every
+    // reduced marking; implicit places are rebuilt from P-invariants of the
+    // original net, which the rule checks before removing one.
+    Marking expand(const Marking& reduced) const;
+
+    // Original net's P-invariant basis and M0, used by expand
+    InvariantBasis originalInvariants;
+    Marking originalInitial;
+};
+
+// bounds: of net; without them implicit_place does not apply
+NetReduction reduceNet(const PetriNet& net,
+                       const PlaceBounds* bounds = nullptr);
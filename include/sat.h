@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+// Small CDCL SAT solver: two watched literals, first-UIP clause learning,
+// VSIDS variable order on a binary heap, phase saving and geometric
+// restarts. Enough for the queries the engines build (prefix deadlock
+// checks), not a competition solver.
+//
+// Literals are DIMACS style: variable v (from newVar, 1-based) is v and
+// its negation -v.
+class SatSolver {
+   public:
+    enum Result { Sat, Unsat, Unknown };
+
+    int newVar();
+    int vars() const { return static_cast<int>(value_.size()); }
+    // An empty clause makes the problem unsatisfiable
+    void addClause(const vector<int>& lits);
+    // maxConflicts = 0: no limit; Unknown when the limit is reached
+    Result solve(size_t maxConflicts = 0);
+    // Model after Sat
+    bool value(int var) const { return model_[var - 1]; }
+
+    size_t conflicts() const { return conflicts_; }
+    size_t decisions() const { return decisions_; }
+
+   private:
+    // internal literal: 2 * var + (negated ? 1 : 0), var 0-based
+    static int lit(int dimacs) {
+        return dimacs > 0 ? 2 * (dimacs - 1) : 2 * (-dimacs - 1) + 1;
+    }
+    int8_t litValue(int l) const;  // 1 true, 0 false, -1 unassigned
+    void assign(int l, int reason);
+    int propagate();  // conflicting clause or -1
+    void analyze(int conflict, vector<int>& learnt, int& backLevel);
+    void backtrack(int level);
+    void bump(int var);
+    int pickBranch();
+    void heapUp(int i);
+    void heapDown(int i);
+    void heapInsert(int var);
+    int heapPop();
+    int attach(const vector<int>& clause);
+
+    vector<vector<int>> clauses_;
+    vector<vector<int>> watches_;  // per literal: clauses watching it
+    vector<int8_t> value_;         // per var
+    vector<int> level_, reason_;
+    vector<bool> phase_, seen_, model_;
+    vector<double> activity_;
+    double bumpBy_ = 1.0;
+    vector<int> heap_, heapIndex_;  // max-heap on activity
+    vector<int> trail_, trailLim_;
+    size_t qhead_ = 0;
+    bool unsat_ = false;
+    size_t conflicts_ = 0, decisions_ = 0;
+};
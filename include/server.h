@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+
+// Long-running analysis server.
+//
+// Reads newline-delimited JSON requests (stdin or a Unix socket) and
+// answers each with one JSON line. Parsed nets and their reachable-set BDDs
+// stay in an LRU cache keyed by a hash of the PNML file, so repeated
+// queries skip parsing, Cudd_Init and the reachability fixpoint. Token
+// bounds are computed on load: bounded nets that are not 1-safe get the
+// binary encoding of bounds.h, unbounded nets are answered with an error.
+//
+// Requests:  {"id": 1, "op": "count", "net": "input/input_file1.pnml"}
+//   op = load | count | reachable (+ "marking": [..]) | deadlock
+//        | optimize (+ "costs": [..], "costs_pair": [[p, q, w], ..])
+//        | stats | shutdown
+// Responses: {"id": 1, "ok": true, "cached": true, "latency_us": 42, ...}
+//
+// Requests run concurrently on a worker pool; requests on the same net are
+// serialized because a CUDD manager is single-threaded. Responses may come
+// back out of order, "id" is echoed for matching.
+struct ServerOptions {
+    int threads = 1;         // worker pool size
+    size_t cacheSize = 16;   // nets kept warm
+    std::string socketPath;  // empty = serve stdin/stdout
+};
+
+int runServer(const ServerOptions& options);
+
+// One request line answered as runServer would, on a default-sized cache
+// shared by all calls (the bench checks the ops through it). Engine
+// output still goes to cout.
+std::string serverRequest(const std::string& line);
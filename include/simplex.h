@@ -0,0 +1,27 @@
+#pragma once
+
+#include <vector>
+
+using namespace std;
+
+// Small dense two-phase simplex (Bland's rule), enough for the state
+// equation of nets with a few hundred places and transitions.
+//
+//   maximize   c . x
+//   subject to A[i] . x  (<= | = | >=)  b[i],   x >= 0
+
+struct LinearProgram {
+    vector<vector<double>> A;
+    vector<double> b;
+    vector<char> sense;  // '<', '=' or '>' per row
+    vector<double> c;
+};
+
+struct LPResult {
+    enum Status { Optimal, Unbounded, Infeasible, IterationLimit };
+    Status status = Infeasible;
+    double value = 0;
+    vector<double> x;
+};
+
+LPResult solveLP(const LinearProgram& lp, int maxIterations = 100000);
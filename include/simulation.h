@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "pnml_parser.h"
+
+using namespace std;
+
+// Random-walk simulation for falsifying deadlock freedom quickly.
+//
+// Walks fire uniformly chosen enabled transitions (fire_transition
+// semantics) from M0 until no transition is enabled or the walk reaches
+// its length. A dead marking found this way is reachable, with the trace
+// as witness; finding none proves nothing.
+
+// Sparse, flat copy of the net for the inner loop. Ranges are CSR style:
+// the pre places of t are prePlace[preStart[t] .. preStart[t + 1]).
+struct CompactNet {
+    int places = 0;
+    int transitions = 0;
+    Marking initial;
+    vector<int> preStart, prePlace, preWeight;       // -C[p][t] > 0
+    vector<int> deltaStart, deltaPlace, deltaValue;  // C[p][t] != 0
+    // transitions consuming from p, with the arc weight
+    vector<int> consumerStart, consumer, consumerWeight;
+};
+
+CompactNet compactNet(const PetriNet& net);
+
+struct SimulationOptions {
+    size_t walks = 1000;
+    size_t walkLength = 100000;  // firings per walk
+    int threads = 1;
+    uint64_t seed = 1;
+    double seconds = 0;  // no walk starts after this wall time, 0: none
+};
+
+struct SimulationResult {
+    bool deadlockFound = false;
+    Marking deadMarking;
+    vector<int> trace;     // transition indices fired from M0
+    size_t walk = 0;       // index of the walk that found it
+    size_t walksRun = 0;
+    size_t firings = 0;    // over all walks
+};
+
+// Walks are independent and seeded from (seed, walk index), and the dead
+// marking of the lowest walk index is reported, so the result does not
+// depend on the number of threads (unless opt.seconds cuts the walks).
+SimulationResult simulateDeadlock(const PetriNet& net,
+                                  const SimulationOptions& opt);
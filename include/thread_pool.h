@@ -0,0 +1,78 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Fixed-size pool of worker threads running submitted jobs in FIFO order.
+class ThreadPool {
+   public:
+    explicit ThreadPool(int threads) {
+        if (threads < 1) threads = 1;
+        for (int i = 0; i < threads; ++i) {
+            workers_.emplace_back([this] { workerLoop(); });
+        }
+    }
+
+    // Finishes the queued jobs, then joins the workers.
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        for (auto& w : workers_) w.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(std::function<void()> job) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            jobs_.push(std::move(job));
+        }
+        wake_.notify_one();
+    }
+
+    // Blocks until the queue is empty and no job is running.
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        idle_.wait(lock, [this] { return jobs_.empty() && running_ == 0; });
+    }
+
+    int size() const { return static_cast<int>(workers_.size()); }
+
+   private:
+    void workerLoop() {
+        while (true) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wake_.wait(lock,
+                           [this] { return stopping_ || !jobs_.empty(); });
+                if (jobs_.empty()) return;  // stopping and drained
+                job = std::move(jobs_.front());
+                jobs_.pop();
+                ++running_;
+            }
+            job();
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                --running_;
+                if (jobs_.empty() && running_ == 0) idle_.notify_all();
+            }
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::queue<std::function<void()>> jobs_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable idle_;
+    int running_ = 0;
+    bool stopping_ = false;
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "pnml_parser.h"
+
+using namespace std;
+
+// Complete finite prefix of the unfolding of a 1-safe net (McMillan, with
+// the Esparza-Romer-Vogler refinement of the order).
+//
+// Events are added in the adequate order |[e]| first, then the Parikh
+// vector of [e] lexicographically, from a priority queue of possible
+// extensions. An event is a cut-off when a smaller local configuration
+// already reaches Mark([e]); cut-offs stay in the prefix but are not
+// extended. Possible extensions are the co-sets labelled with the preset of
+// a transition, searched through one co-relation bitset per condition.
+//
+// Concurrency-heavy nets whose interleavings blow up BDDs and explicit
+// search usually have a prefix of about the size of the net.
+
+struct PrefixCondition {
+    int place;
+    int pre;           // producing event, -1 for the initial cut
+    vector<int> post;  // consuming events
+};
+
+struct PrefixEvent {
+    int transition;
+    vector<int> preset, postset;  // condition ids
+    vector<int> local;            // [e] as sorted event ids, e included
+    bool cutoff = false;
+};
+
+struct UnfoldingPrefix {
+    vector<PrefixCondition> conditions;
+    vector<PrefixEvent> events;
+    size_t cutoffs = 0;
+    bool complete = false;  // false: stopped at maxEvents
+};
+
+// maxEvents = 0: no limit. The net must be 1-safe (computePlaceBounds).
+UnfoldingPrefix unfold(const PetriNet& net, size_t maxEvents = 20000);
+
+struct PrefixDeadlock {
+    bool found = false;
+    bool decided = false;  // found, or no deadlock on a complete prefix
+    Marking marking;
+    vector<int> trace;  // transition indices from M0
+    int vars = 0;
+    size_t clauses = 0;
+    size_t conflicts = 0;
+};
+
+// Deadlock check on the prefix as one SAT query (sat.h): a cut-off free
+// configuration C (causally closed and conflict free) whose cut Mark(C)
+// leaves at least one pre place of every transition empty. On a complete
+// prefix these configurations reach every reachable marking.
+PrefixDeadlock prefixDeadlock(const PetriNet& net,
+                              const UnfoldingPrefix& prefix);
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vector>
+
+#include "cudd.h"
+#include "optimization.h"
+#include "pnml_parser.h"
+
+using namespace std;
+
+// Reachable markings of a 1-safe net as a ZDD over the places: a marking is
+// the set of its marked places, ZDD variable p being place p.
+//
+// A BDD over all P variables spends a node on every place that is 0 along a
+// path; a ZDD skips them (zero-suppression), so nets where few places are
+// marked at a time keep much smaller sets. Images work on the families of
+// sets directly, with t consuming pre(t) and producing post(t):
+//   post_t(S) = change_post(subset0_post(subset1_pre(S)))
+// where subset1_p keeps the sets holding p and removes it, subset0_p keeps
+// the sets without p and change_p adds it back.
+struct ZddReachable {
+    DdManager* mgr = nullptr;
+    int places = 0;
+    DdNode* R = nullptr;
+    // per transition, the places it takes a token from / puts one in;
+    // transitions with an arc weight above 1 never fire on a 1-safe net
+    // and are left empty with usable[t] = false
+    vector<vector<int>> consume, produce;
+    vector<bool> usable;
+};
+
+// The net must be 1-safe (computePlaceBounds)
+ZddReachable zddReachability(const PetriNet& net);
+void freeZddReachable(ZddReachable& zr);
+
+// Successors of S through t, Ref'd
+DdNode* zddPostImage(const ZddReachable& zr, DdNode* S, int t);
+
+double zddCount(const ZddReachable& zr);
+
+// Reachable markings enabling no transition, Ref'd
+DdNode* zddDeadMarkings(const ZddReachable& zr);
+
+// One marking of S, empty when S is
+Marking zddPickMarking(const ZddReachable& zr, DdNode* S);
+
+// Task 5 on the ZDD: places off a path hold no token, so the best value of
+// a node is max(best(else), costs[p] + best(then)), one pass over the DAG.
+OptimizationTask5Result zddOptimization(const ZddReachable& zr,
+                                        const vector<int>& costs);
@@ -0,0 +1,1491 @@
+#include "analysis.h"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+
+#include "bdd.h"
+#include "bitstate.h"
+#include "bounds.h"
+#include "coverability.h"
+#include "ctl.h"
+#include "deadlock_ILP.h"
+#include "firing_kernel.h"
+#include "fixed_state.h"
+#include "guided_search.h"
+#include "invariants.h"
+#include "jit.h"
+#include "optimization_add.h"
+#include "reachability_graph.h"
+#include "reduction.h"
+#include "simulation.h"
+#include "unfolding.h"
+#include "zdd.h"
+#include "profiler.h"
+#include "reachability.h"
+
+using namespace std;
+
+bool parseOutputFormat(const string& name, OutputFormat& format) {
+    if (name == "human") {
+        format = OutputFormat::Human;
+    } else if (name == "json") {
+        format = OutputFormat::JSON;
+    } else if (name == "csv") {
+        format = OutputFormat::CSV;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool setEngine(AnalysisOptions& opt, const string& assignment) {
+    size_t eq = assignment.find('=');
+    if (eq == string::npos) return false;
+    string group = assignment.substr(0, eq);
+    string name = assignment.substr(eq + 1);
+
+    if (group == "explicit" &&
+        (name == "bfs" || name == "batch" || name == "jit" ||
+         name == "coverability")) {
+        opt.explicitEngine = name;
+    } else if (group == "symbolic" &&
+               (name == "bdd" || name == "zdd" || name == "parallel")) {
+        opt.symbolicEngine = name;
+    } else if (group == "deadlock" &&
+               (name == "ilp" || name == "bdd" || name == "sim" ||
+                name == "astar" || name == "best-first" ||
+                name == "unfolding" || name == "zdd")) {
+        opt.deadlockEngine = name;
+    } else if (group == "opt" &&
+               (name == "recursive" || name == "add" || name == "zdd")) {
+        opt.optEngine = name;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+namespace {
+
+class NullBuffer : public streambuf {
+   protected:
+    int overflow(int c) override { return c; }
+    streamsize xsputn(const char*, streamsize n) override { return n; }
+};
+
+mutex muteLock;
+int muteDepth = 0;
+NullBuffer muteSink;
+streambuf* unmutedBuffer = nullptr;
+
+// Times one task into report.taskMs and a profiler region
+class TaskTimer {
+   public:
+    TaskTimer(AnalysisReport& report, const string& name)
+        : report_(report), name_(name), start_(chrono::steady_clock::now()) {
+        Prof::begin(name);
+    }
+    ~TaskTimer() {
+        Prof::end();
+        double ms = chrono::duration<double, milli>(
+                        chrono::steady_clock::now() - start_)
+                        .count();
+        report_.taskMs.push_back({name_, ms});
+    }
+
+   private:
+    AnalysisReport& report_;
+    string name_;
+    chrono::steady_clock::time_point start_;
+};
+
+string markingString(const Marking& M) {
+    string s = "[";
+    for (size_t i = 0; i < M.size(); ++i) {
+        s += to_string(M[i]);
+        if (i + 1 < M.size()) s += ", ";
+    }
+    return s + "]";
+}
+
+// OMEGA (coverability) is printed as w
+string coverString(const Marking& M, bool json) {
+    string s = "[";
+    for (size_t i = 0; i < M.size(); ++i) {
+        if (i) s += ", ";
+        if (M[i] == OMEGA) {
+            s += json ? "\"w\"" : "w";
+        } else {
+            s += to_string(M[i]);
+        }
+    }
+    return s + "]";
+}
+
+string jsonString(const string& s) {
+    string out = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out + "\"";
+}
+
+// Runs a guided search on net and fills out; the trace names transitions.
+// bounds: those of net, or null
+void runGuidedSearch(const PetriNet& net, const AnalysisOptions& opt,
+                     SearchGoal goal, const Marking& target, bool greedy,
+                     SearchReport& out, const PlaceBounds* bounds = nullptr) {
+    GuidedSearchOptions search;
+    search.bounds = bounds;
+    search.goal = goal;
+    search.target = target;
+    search.heuristic = opt.heuristic == "tokens"
+                           ? SearchHeuristic::Tokens
+                           : SearchHeuristic::StateEquation;
+    search.greedy = greedy;
+    search.maxStates = opt.searchLimit;
+    GuidedSearchResult res = guidedSearch(net, search);
+    out.done = true;
+    out.goal = goal == SearchGoal::Deadlock ? "deadlock"
+               : goal == SearchGoal::Reach  ? "reach"
+                                            : "cover";
+    out.found = res.found;
+    out.marking = res.marking;
+    for (int t : res.trace) out.trace.push_back(net.transitions[t].id);
+    out.exhausted = res.exhausted;
+    out.expanded = res.expanded;
+    out.generated = res.generated;
+    out.pruned = res.pruned;
+}
+
+string searchJson(const SearchReport& s) {
+    ostringstream out;
+    out << "{\"goal\": " << jsonString(s.goal)
+        << ", \"found\": " << (s.found ? "true" : "false");
+    if (s.found) out << ", \"marking\": " << markingString(s.marking);
+    out << ", \"trace\": [";
+    for (size_t i = 0; i < s.trace.size(); ++i)
+        out << (i ? ", " : "") << jsonString(s.trace[i]);
+    out << "], \"exhausted\": " << (s.exhausted ? "true" : "false")
+        << ", \"expanded\": " << s.expanded
+        << ", \"generated\": " << s.generated
+        << ", \"pruned\": " << s.pruned << "}";
+    return out.str();
+}
+
+// Totals plus one entry per BFS level
+string parallelJson(const ParallelImageStats& s) {
+    ostringstream out;
+    out << "{\"threads\": " << s.threads
+        << ", \"levels\": " << s.iterations.size()
+        << ", \"image_speedup\": " << s.speedup()
+        << ", \"transfer_share\": " << s.transferShare();
+    auto series = [&](const char* name, double ParallelIteration::*field) {
+        out << ", \"" << name << "\": [";
+        for (size_t i = 0; i < s.iterations.size(); ++i)
+            out << (i ? ", " : "") << s.iterations[i].*field;
+        out << "]";
+    };
+    series("wall_ms", &ParallelIteration::wallMs);
+    series("image_ms", &ParallelIteration::imageMs);
+    series("work_ms", &ParallelIteration::workMs);
+    series("merge_ms", &ParallelIteration::mergeMs);
+    series("transfer_ms", &ParallelIteration::transferMs);
+    out << "}";
+    return out.str();
+}
+
+string checkpointJson(const CheckpointStats& c) {
+    ostringstream out;
+    out << "{\"resumed\": " << (c.resumed ? "true" : "false");
+    if (c.resumed) out << ", \"resumed_at\": " << c.resumedAt;
+    out << ", \"writes\": " << c.writes << ", \"bytes\": " << c.bytes
+        << ", \"write_ms\": " << c.writeMs << ", \"run_ms\": " << c.runMs
+        << "}";
+    return out.str();
+}
+
+// what: the unit of resumedAt
+string checkpointHuman(const CheckpointStats& c, const char* what) {
+    ostringstream out;
+    out << "Checkpoints: " << c.writes << " written (" << c.bytes
+        << " bytes, " << c.writeMs << " ms, " << 100 * c.overhead()
+        << "% of the run)";
+    if (c.resumed) out << ", resumed after " << c.resumedAt << " " << what;
+    out << "\n";
+    return out.str();
+}
+
+string searchHuman(const SearchReport& s) {
+    ostringstream out;
+    out << "Guided search: " << s.expanded << " markings expanded, "
+        << s.generated << " generated, " << s.pruned << " pruned by the LP";
+    if (!s.found) {
+        out << (s.exhausted ? " (search space exhausted)"
+                            : " (state limit reached, not a proof)");
+    }
+    out << "\n";
+    if (s.found) {
+        out << "Trace (" << s.trace.size() << " firings):";
+        for (const auto& t : s.trace) out << " " << t;
+        out << "\n";
+    }
+    return out.str();
+}
+
+}  // namespace
+
+MuteCout::MuteCout(bool mute) : mute_(mute) {
+    if (!mute_) return;
+    lock_guard<mutex> guard(muteLock);
+    if (muteDepth++ == 0) unmutedBuffer = cout.rdbuf(&muteSink);
+}
+
+MuteCout::~MuteCout() {
+    if (!mute_) return;
+    lock_guard<mutex> guard(muteLock);
+    if (--muteDepth == 0) cout.rdbuf(unmutedBuffer);
+}
+
+AnalysisReport analyzeNet(const PetriNet& net, const AnalysisOptions& opt) {
+    AnalysisReport report;
+    report.places = static_cast<int>(net.places.size());
+    report.transitions = static_cast<int>(net.transitions.size());
+    report.initialMarking = net.initialMarking;
+
+    MuteCout mute(!opt.verbose);
+
+    // One budget for the run: once Task 2 spends it, Task 3 stops too
+    BudgetMonitor monitor(opt.budget);
+    BudgetMonitor* budget = opt.budget.any() ? &monitor : nullptr;
+
+    // CTL formulas name places of the original net
+    vector<CtlFormula> formulas(opt.ctl.size());
+    for (size_t i = 0; i < opt.ctl.size(); ++i) {
+        string error;
+        if (!parseCtl(opt.ctl[i], net, formulas[i], error)) {
+            report.error = "CTL formula " + to_string(i + 1) + ": " + error;
+            return report;
+        }
+    }
+
+    // Unbounded nets keep only the tasks the coverability engine and the
+    // simulator answer
+    set<int> tasks = opt.tasks;
+    bool coverability = opt.explicitEngine == "coverability";
+    bool simulation = opt.deadlockEngine == "sim";
+
+    // Token bounds pick the encoding: one bit per place while the net is
+    // 1-safe, binary counters and narrow explicit markings otherwise. They
+    // are of the original net, so an unbounded place is caught before the
+    // reduction could drop it.
+    PlaceBounds bounds;
+    bool encoded = false;
+    if (opt.encoding == "auto") {
+        TaskTimer timer(report, "bounds");
+        bounds = computePlaceBounds(net);
+        report.boundsDone = true;
+        report.oneSafe = bounds.oneSafe();
+        report.maxBound = bounds.maxBound();
+        if (bounds.unboundedPlace >= 0) {
+            string place = net.places[bounds.unboundedPlace].id;
+            if (!coverability && !simulation) {
+                report.error = "place " + place +
+                               " is unbounded (try --engine "
+                               "explicit=coverability)";
+                return report;
+            }
+            for (int t : {2, 3, 4, 5}) {
+                if ((t == 2 && coverability) || (t == 4 && simulation))
+                    continue;
+                if (tasks.erase(t)) report.skippedTasks.push_back(t);
+            }
+        }
+        bool symbolic = tasks.count(3) || tasks.count(5) ||
+                        !formulas.empty() ||
+                        (tasks.count(4) && opt.deadlockEngine == "bdd");
+        if (!bounds.allBounded() && symbolic) {
+            report.error =
+                "no token bound found within the sweep; the symbolic "
+                "engines need one";
+            return report;
+        }
+        encoded = !report.oneSafe && bounds.allBounded() &&
+                  bounds.unboundedPlace < 0;
+    }
+
+    // Tasks 2-4 run on the reduced net and map markings back; Task 5 keeps
+    // the original net so that costs refer to the original places.
+    NetReduction reduction;
+    if (opt.reduce) {
+        TaskTimer timer(report, "reduction");
+        reduction = reduceNet(net, report.boundsDone ? &bounds : nullptr);
+        report.reduced = true;
+        report.reducedPlaces = static_cast<int>(reduction.net.places.size());
+        report.reducedTransitions =
+            static_cast<int>(reduction.net.transitions.size());
+        report.countsExact = reduction.countsExact;
+        for (int r = 0; r < REDUCTION_RULES; ++r) {
+            if (reduction.applied[r] == 0) continue;
+            report.reductionRules.push_back(
+                {reductionRuleName(static_cast<ReductionRule>(r)),
+                 reduction.applied[r]});
+        }
+    }
+    const PetriNet& work = opt.reduce ? reduction.net : net;
+    int workPlaces = static_cast<int>(work.places.size());
+    auto original = [&](const Marking& M) {
+        return opt.reduce ? reduction.expand(M) : M;
+    };
+    // Reduced markings are projections of reachable ones, so the kept
+    // places keep their bounds
+    PlaceBounds workBounds = bounds;
+    if (opt.reduce && report.boundsDone) {
+        workBounds.bound.clear();
+        workBounds.exact.clear();
+        for (int p : reduction.placeOrigin) {
+            workBounds.bound.push_back(bounds.bound[p]);
+            workBounds.exact.push_back(bounds.exact[p]);
+        }
+        workBounds.unboundedPlace = -1;
+    }
+    if (report.boundsDone) report.markingWidth = markingWidth(workBounds);
+
+    // Bounds of the original net, for the engines that run on it: computed
+    // at most once, and only when bounds were skipped
+    PlaceBounds originalBounds;
+    bool originalBoundsDone = false;
+    auto netBounds = [&]() -> const PlaceBounds& {
+        if (report.boundsDone) return bounds;
+        if (!originalBoundsDone) {
+            originalBounds = computePlaceBounds(net);
+            originalBoundsDone = true;
+        }
+        return originalBounds;
+    };
+
+    PlaceEncoding enc;
+    if (encoded) {
+        enc = boundedEncoding(workBounds);
+        report.encoding = "binary";
+        report.encodingBits = 0;
+        for (const auto& b : enc.bits)
+            report.encodingBits += static_cast<int>(b.size());
+    } else {
+        report.encodingBits = workPlaces;
+    }
+
+    // The ZDD engine keeps one reachable set for the tasks that select it,
+    // on the original net like the unfolding
+    bool zddTask3 = tasks.count(3) && opt.symbolicEngine == "zdd";
+    bool zddTask4 = tasks.count(4) && opt.deadlockEngine == "zdd";
+    bool zddTask5 = tasks.count(5) && opt.optEngine == "zdd";
+    bool needZDD = zddTask3 || zddTask4 || zddTask5;
+    if (needZDD) {
+        if (!netBounds().oneSafe()) {
+            report.error = "the zdd engine needs a 1-safe net";
+            return report;
+        }
+    }
+    // pairwise costs are ADD terms over the original places
+    if (tasks.count(5) && !opt.costPairs.empty()) {
+        if (zddTask5) {
+            report.error = "--costs-pair needs opt=recursive or add";
+            return report;
+        }
+        for (const auto& pt : opt.costPairs) {
+            for (int p : {pt.p, pt.q}) {
+                if (p < 0 || p >= report.places) {
+                    report.error = "--costs-pair: no place " + to_string(p);
+                    return report;
+                }
+            }
+        }
+    }
+    // checked before any manager exists, like the zdd engine
+    if (tasks.count(4) && opt.deadlockEngine == "unfolding" &&
+        !netBounds().oneSafe()) {
+        report.error = "deadlock=unfolding needs a 1-safe net";
+        return report;
+    }
+
+    PlaceCompression pc;
+    bool compress = opt.compress && !encoded;  // invariants assume 1-safe
+    if (compress) {
+        TaskTimer timer(report, "invariants");
+        pc = compressPlaces(work);
+        report.compressed = true;
+        report.pInvariants = pc.invariants.dimension();
+        report.tInvariants = tInvariantBasis(work.incidenceMatrix).dimension();
+        report.impliedPlaces = static_cast<int>(pc.implied.size());
+    }
+
+    // Karp-Miller runs on the original net: OMEGA markings do not map
+    // back through the reduction
+    if (tasks.count(2) && coverability) {
+        TaskTimer timer(report, "task2_coverability");
+        CoverabilitySet cs = coverabilitySet(net);
+        report.coverabilityDone = true;
+        report.coverBasis = cs.basis.size();
+        report.coverNodes = cs.nodes;
+        for (size_t p = 0; p < cs.unbounded.size(); ++p) {
+            if (cs.unbounded[p])
+                report.unboundedPlaces.push_back(net.places[p].id);
+        }
+        for (size_t i = 0; i < cs.basis.size() && (int)i < opt.samples; ++i)
+            report.samples.push_back(cs.basis[i]);
+        if (!opt.coverTarget.empty()) {
+            Marking target = opt.coverTarget;
+            target.resize(net.places.size(), 0);
+            report.coverQueried = true;
+            report.coverable = cs.covers(target);
+        }
+    }
+    // When an engine runs out of budget, the fallback policy tries a
+    // cheaper one on the original net, within what is left of the budget.
+    // A deadlock it finds answers Task 4 if that engine found none.
+    Marking fallbackDead;
+    vector<string> fallbackTrace;
+    auto budgetStopped = [&]() {
+        if (!report.budgetStopped) {
+            report.budgetStopped = true;
+            report.budgetReason = budget->reason();
+        }
+        if (opt.fallback == "none" || !report.fallback.empty()) return;
+        TaskTimer timer(report, "fallback_" + opt.fallback);
+        report.fallback = opt.fallback;
+        vector<int> trace;
+        if (opt.fallback == "bitstate") {
+            BudgetMonitor again(budget->left());
+            BitstateResult res =
+                bitstateReachability(net, BitstateOptions(), &again);
+            report.fallbackStates = res.states;
+            report.fallbackComplete = res.complete;
+            report.hashFactor = res.hashFactor;
+            report.fallbackDeadlock = res.deadlockFound;
+            fallbackDead = res.deadMarking;
+            trace = res.trace;
+        } else {
+            SimulationOptions sim;
+            sim.walks = opt.walks;
+            sim.walkLength = opt.walkLength;
+            sim.threads = opt.threads;
+            sim.seed = opt.seed;
+            sim.seconds = budget->left().seconds;
+            SimulationResult res = simulateDeadlock(net, sim);
+            report.fallbackWalks = res.walksRun;
+            report.fallbackFirings = res.firings;
+            report.fallbackDeadlock = res.deadlockFound;
+            fallbackDead = res.deadMarking;
+            trace = res.trace;
+        }
+        for (int t : trace) fallbackTrace.push_back(net.transitions[t].id);
+    };
+
+    // --traces: Task 2 markings and BFS tree, kept for Task 4. The reduced
+    // net has its own transitions, so traces need the original one.
+    bool keepTraces = opt.traces && !opt.reduce && !coverability;
+    // --graph: Task 2 also records its edges, for the same reason on the
+    // original net, and explores it all
+    if (opt.graph) {
+        if (coverability || opt.reduce) {
+            report.error = "--graph needs the explicit engine, without "
+                           "--reduce";
+            return report;
+        }
+        if (netBounds().unboundedPlace >= 0) {
+            report.error = "--graph needs a bounded net";
+            return report;
+        }
+        tasks.insert(2);
+    }
+    vector<Marking> explicitStates;
+    ParentTable parents;
+    EdgeTable edges;
+    CheckpointOptions checkpoint;
+    checkpoint.path = opt.checkpoint;
+    checkpoint.seconds = opt.checkpointEvery;
+    bool checkpointed = !opt.checkpoint.empty();
+    if (!coverability && tasks.count(2)) {
+        TaskTimer timer(report, "task2_explicit");
+        ParentTable* links = keepTraces ? &parents : nullptr;
+        EdgeTable* arcs = opt.graph ? &edges : nullptr;
+        // the checkpoint log holds full markings, so it takes the plain
+        // visited set; the batch and jit kernels keep their own packed rows
+        // and index no duplicate, so --graph leaves them out
+        SimdLevel level = SimdLevel::Scalar;
+        parseSimdLevel(opt.simd, level);
+        bool kernels = !checkpointed && !opt.graph;
+        bool batched = opt.explicitEngine == "batch" && kernels;
+        // with known bounds, markings pack into a fixed number of words
+        // (or markingWidth bytes per place, past 16 words)
+        bool fixed = report.boundsDone && workBounds.allBounded();
+        FiringKernel kernel;
+        if (batched)
+            kernel = buildFiringKernel(work, !encoded && report.oneSafe);
+        // explicit=jit: when the compiler or the object fails, the run
+        // goes on with the engine it would otherwise have picked
+        CompiledNet compiled;
+        bool jitted = false;
+        if (opt.explicitEngine == "jit" && kernels) {
+            // without bounds, 31 bits per place, as an int holds
+            vector<long long> bound =
+                fixed ? workBounds.bound
+                      : vector<long long>(work.places.size(), INT_MAX);
+            string error;
+            jitted = loadCompiledNet(work, fieldLayout(work, bound), opt.jit,
+                                     compiled, error);
+            ostringstream status;
+            if (!jitted)
+                status << "failed (" << error << ")";
+            else if (compiled.cached)
+                status << "cached " << compiled.path;
+            else
+                status << "compiled in "
+                       << static_cast<long>(compiled.compileMs) << " ms, "
+                       << compiled.path;
+            report.jitStatus = status.str();
+        }
+        vector<Marking> reach =
+            batched  ? batchedReachability(work, kernel, level, links, budget)
+            : jitted ? jitReachability(work, compiled, links, budget)
+            : checkpointed
+                ? explicitReachability(work, checkpoint,
+                                       &report.explicitCheckpoint, links,
+                                       budget, arcs)
+            : compress ? explicitReachability(work, pc, links, budget, arcs)
+            : fixed    ? fixedReachability(work, workBounds, links, budget,
+                                           &report.stateWords, arcs)
+                       : explicitReachability(work, links, budget, arcs);
+        unloadCompiledNet(compiled);
+        report.explicitCheckpointed = checkpointed;
+        if (batched) {
+            report.explicitKernel = string(simdLevelName(level)) +
+                                    (kernel.safe ? ", bitset" : ", int32");
+        }
+        report.explicitDone = true;
+        report.explicitStates = reach.size();
+        if (budget && budget->stopped()) {
+            report.explicitPartial = true;
+            report.explicitFrontier = static_cast<size_t>(budget->frontier());
+        }
+        report.parentBytes = parents.bytes();
+        for (size_t i = 0; i < reach.size() && (int)i < opt.samples; ++i)
+            report.samples.push_back(original(reach[i]));
+        if (keepTraces || opt.graph) explicitStates.swap(reach);
+    }
+    if (report.explicitPartial) budgetStopped();
+
+    // Reachability graph from Task 2's edges; a partial BFS has none worth
+    // analysing, its frontier states have no rows
+    if (opt.graph && report.explicitDone && !report.explicitPartial) {
+        TaskTimer timer(report, "reachability_graph");
+        ReachabilityGraph g;
+        g.places = static_cast<int>(net.places.size());
+        g.transitions = static_cast<int>(net.transitions.size());
+        g.states.swap(explicitStates);
+        g.offset.swap(edges.offset);
+        g.target.swap(edges.target);
+        g.label.swap(edges.label);
+        SccAnalysis scc = analyzeSccs(g);
+        report.graphDone = true;
+        report.graphStates = g.states.size();
+        report.graphEdges = g.edges();
+        report.sccs = scc.components;
+        report.bottomSccs = scc.bottomCount;
+        report.reversible = scc.reversible;
+        report.homeStates = scc.homeStates.size();
+        if (!scc.homeStates.empty())
+            report.homeState = g.states[scc.homeStates[0]];
+        for (int t = 0; t < g.transitions; ++t) {
+            if (!scc.live[t]) report.notLive.push_back(net.transitions[t].id);
+            if (!scc.fires[t])
+                report.neverFired.push_back(net.transitions[t].id);
+        }
+        if (!opt.graphOut.empty()) {
+            report.graphBytes = writeReachabilityGraph(g, opt.graphOut);
+            if (report.graphBytes == 0) {
+                report.error = "cannot write " + opt.graphOut;
+                return report;
+            }
+        }
+        if (keepTraces) explicitStates.swap(g.states);  // for Task 4
+    }
+
+    // Target search on the original net, next to the selected tasks
+    bool coverSearch = !opt.coverTarget.empty() && !coverability;
+    if (!opt.reachTarget.empty() || coverSearch) {
+        TaskTimer timer(report, "guided_search");
+        bool reach = !opt.reachTarget.empty();
+        SearchGoal goal = reach ? SearchGoal::Reach : SearchGoal::Cover;
+        runGuidedSearch(net, opt, goal,
+                        reach ? opt.reachTarget : opt.coverTarget, false,
+                        report.targetSearch);
+    }
+
+    // Compressed Task 3 has its own manager over the kept places only
+    bool bddTask3 = tasks.count(3) && opt.symbolicEngine == "bdd";
+    bool compressedTask3 = compress && bddTask3;
+    if (compressedTask3) {
+        TaskTimer timer(report, "symbolic_reachability_compressed");
+        CompressedReachable cr = symbolicReachability(work, pc);
+        PROFILE_CUDD(cr.mgr);
+        report.symbolicDone = true;
+        report.symbolicStates = Cudd_CountMinterm(cr.mgr, cr.R, cr.x.size());
+        report.bddNodes = Cudd_DagSize(cr.R);
+        freeCompressedReachable(cr);
+    }
+
+    // Tasks 3-5 share one reachable-set BDD, built only if one of them runs
+    bool needBDD = (bddTask3 && !compressedTask3) ||
+                   (tasks.count(5) && !opt.reduce && !zddTask5) ||
+                   (!formulas.empty() && !opt.reduce) ||
+                   (tasks.count(4) && opt.deadlockEngine == "bdd");
+    ReachableContext ctx;
+    EncodedReachable er;
+    if (needBDD) {
+        TaskTimer timer(report, "symbolic_reachability");
+        const CheckpointOptions* cp = checkpointed ? &checkpoint : nullptr;
+        if (encoded) {
+            er = symbolicReachability(work, enc, cp,
+                                      &report.symbolicCheckpoint, budget);
+            ctx.mgr = er.mgr;
+            ctx.R = er.R;
+        } else {
+            ctx = buildReachableContext(work, cp, &report.symbolicCheckpoint,
+                                        budget);
+        }
+        report.symbolicCheckpointed = checkpointed;
+        if (budget && budget->stopped()) {
+            report.symbolicPartial = true;
+            report.symbolicLevels = budget->done();
+            report.symbolicFrontier = budget->frontier();
+        }
+        PROFILE_CUDD(ctx.mgr);
+        if (bddTask3 && !compressedTask3) {
+            report.symbolicDone = true;
+            report.symbolicStates =
+                Cudd_CountMinterm(ctx.mgr, ctx.R, report.encodingBits);
+            report.bddNodes = Cudd_DagSize(ctx.R);
+        }
+    }
+
+    if (report.symbolicPartial) budgetStopped();
+
+    // Task 3 alone on the parallel engine, in managers of its own
+    if (tasks.count(3) && opt.symbolicEngine == "parallel") {
+        TaskTimer timer(report, "symbolic_reachability_parallel");
+        EncodedReachable pr = parallelSymbolicReachability(
+            work, encoded ? enc : oneBitEncoding(workPlaces), !encoded,
+            opt.threads, &report.parallel);
+        report.symbolicDone = true;
+        report.symbolicStates = Cudd_CountMinterm(pr.mgr, pr.R, pr.nvars);
+        report.bddNodes = Cudd_DagSize(pr.R);
+        freeEncodedReachable(pr);
+    }
+
+    ZddReachable zr;
+    if (needZDD) {
+        TaskTimer timer(report, "zdd_reachability");
+        zr = zddReachability(net);
+        if (zddTask3) {
+            report.symbolicDone = true;
+            report.symbolicStates = zddCount(zr);
+            report.bddNodes = Cudd_zddDagSize(zr.R);
+            report.zddNodes = true;
+        }
+    }
+
+    if (tasks.count(4)) {
+        TaskTimer timer(report, "task4_deadlock");
+        if (opt.deadlockEngine == "zdd") {
+            DdNode* dead = zddDeadMarkings(zr);
+            report.deadMarking = zddPickMarking(zr, dead);
+            report.deadlockFound = !report.deadMarking.empty();
+            Cudd_RecursiveDerefZdd(zr.mgr, dead);
+        } else if (opt.deadlockEngine == "bdd") {
+            DdNode* dead = encoded ? deadMarkingsBDD(ctx.mgr, work, enc)
+                                   : deadMarkingsBDD(ctx.mgr, work, ctx.x);
+            DdNode* reachableDead = Cudd_bddAnd(ctx.mgr, ctx.R, dead);
+            Cudd_Ref(reachableDead);
+            Cudd_RecursiveDeref(ctx.mgr, dead);
+            vector<char> cube(Cudd_ReadSize(ctx.mgr));
+            if (reachableDead != Cudd_ReadLogicZero(ctx.mgr) &&
+                Cudd_bddPickOneCube(ctx.mgr, reachableDead, cube.data())) {
+                report.deadlockFound = true;
+                Marking M(workPlaces, 0);
+                if (encoded) {
+                    M = decodeMarking(enc, cube);
+                } else {
+                    for (int p = 0; p < workPlaces; ++p)
+                        M[p] = (cube[p] == 1) ? 1 : 0;
+                }
+                report.deadMarking = original(M);
+            }
+            Cudd_RecursiveDeref(ctx.mgr, reachableDead);
+            // a dead marking of a partial set is still reachable, but
+            // finding none proves nothing
+            if (report.symbolicPartial && !report.deadlockFound)
+                report.deadlockExhaustive = false;
+        } else if (opt.deadlockEngine == "astar" ||
+                   opt.deadlockEngine == "best-first") {
+            runGuidedSearch(net, opt, SearchGoal::Deadlock, Marking(),
+                            opt.deadlockEngine == "best-first",
+                            report.deadlockSearch,
+                            opt.heuristic == "tokens" ? nullptr : &netBounds());
+            report.deadlockFound = report.deadlockSearch.found;
+            report.deadMarking = report.deadlockSearch.marking;
+        } else if (opt.deadlockEngine == "unfolding") {
+            // on the original net, like the simulator (1-safe, checked
+            // above)
+            UnfoldingPrefix prefix = unfold(net, opt.prefixEvents);
+            PrefixDeadlock res = prefixDeadlock(net, prefix);
+            report.prefixDone = true;
+            report.prefixEvents = prefix.events.size();
+            report.prefixConditions = prefix.conditions.size();
+            report.prefixCutoffs = prefix.cutoffs;
+            report.prefixComplete = prefix.complete;
+            report.satConflicts = res.conflicts;
+            report.deadlockExhaustive = res.decided;
+            report.deadlockFound = res.found;
+            if (res.found) {
+                report.deadMarking = res.marking;
+                for (int t : res.trace)
+                    report.deadlockTrace.push_back(net.transitions[t].id);
+            }
+        } else if (simulation) {
+            // on the original net, so that the trace names its transitions
+            SimulationOptions sim;
+            sim.walks = opt.walks;
+            sim.walkLength = opt.walkLength;
+            sim.threads = opt.threads;
+            sim.seed = opt.seed;
+            SimulationResult res = simulateDeadlock(net, sim);
+            report.deadlockExhaustive = false;
+            report.simWalks = res.walksRun;
+            report.simFirings = res.firings;
+            report.deadlockFound = res.deadlockFound;
+            if (res.deadlockFound) {
+                report.deadMarking = res.deadMarking;
+                for (int t : res.trace)
+                    report.deadlockTrace.push_back(net.transitions[t].id);
+            }
+        } else {
+            string error;
+            Marking M = findDeadlock(
+                work, report.boundsDone ? &workBounds : nullptr, &error);
+            if (!error.empty()) report.error = error;
+            report.deadlockFound = !M.empty();
+            if (report.deadlockFound) report.deadMarking = original(M);
+        }
+        // the fallback's markings are reachable: its deadlock is one
+        if (!report.deadlockFound && report.fallbackDeadlock) {
+            report.deadlockFound = true;
+            report.deadMarking = fallbackDead;
+            report.deadlockTrace = fallbackTrace;
+        }
+        if (keepTraces && report.deadlockFound && !explicitStates.empty()) {
+            // BFS order: the tree path is a shortest firing sequence
+            auto at = find(explicitStates.begin(), explicitStates.end(),
+                           report.deadMarking);
+            if (at != explicitStates.end()) {
+                report.deadlockTrace.clear();
+                for (int t : parents.trace(at - explicitStates.begin()))
+                    report.deadlockTrace.push_back(net.transitions[t].id);
+                report.shortestTrace = true;
+            }
+        }
+        report.deadlockDone = true;
+    }
+
+    // CTL needs the whole reachable set, in both directions
+    report.ctlSkipped =
+        !formulas.empty() && report.symbolicPartial && !opt.reduce;
+    if (!formulas.empty() && !report.ctlSkipped) {
+        TaskTimer timer(report, "ctl");
+        // on the original net: the shared reachable set unless it is the
+        // reduced one
+        DdManager* mgr = ctx.mgr;
+        DdNode* R = ctx.R;
+        // the encoding follows the bounds of the original net
+        bool safe = opt.encoding != "auto" || netBounds().oneSafe();
+        PlaceEncoding ctlEnc = safe ? oneBitEncoding(report.places)
+                                    : boundedEncoding(netBounds());
+        ReachableContext full;
+        EncodedReachable fullEr;
+        if (opt.reduce) {
+            if (safe) {
+                full = buildReachableContext(net);
+                mgr = full.mgr;
+                R = full.R;
+            } else {
+                fullEr = symbolicReachability(net, ctlEnc);
+                mgr = fullEr.mgr;
+                R = fullEr.R;
+            }
+        }
+        TransitionRelations tr =
+            buildTransitionRelations(mgr, net, ctlEnc, safe);
+        for (const CtlResult& res : checkCtl(net, tr, R, formulas)) {
+            CtlReport c;
+            c.formula = res.formula;
+            c.holds = res.holds;
+            c.states = res.states;
+            c.hasPath = res.hasPath;
+            for (int t : res.trace) c.trace.push_back(net.transitions[t].id);
+            if (res.hasPath) c.marking = res.path.back();
+            report.ctl.push_back(c);
+        }
+        freeTransitionRelations(tr);
+        if (fullEr.mgr != nullptr) {
+            freeEncodedReachable(fullEr);
+        } else {
+            freeReachableContext(full);
+        }
+    }
+
+    if (tasks.count(5)) {
+        TaskTimer timer(report, "task5_optimization");
+        vector<int> costs = opt.costs;
+        if (costs.empty()) costs.assign(report.places, 1);
+        costs.resize(report.places, 0);
+        // the encoding follows the bounds of the original net, which the
+        // shared set (unreduced) was built with as well
+        bool fullEncoded = opt.encoding == "auto" && !netBounds().oneSafe();
+        AddObjective objective = linearObjective(costs);
+        objective.pairwise = opt.costPairs;
+        bool linear = opt.costPairs.empty();
+        bool queries = opt.optTopK > 0 || !opt.paretoObjectives.empty();
+        bool sweep = !opt.costSweep.empty();
+        if ((queries || sweep) && (zddTask5 || fullEncoded)) {
+            report.optQuerySkipped =
+                "top-k, Pareto and sweep queries need one BDD variable per "
+                "place (a 1-safe net, opt=recursive or add)";
+        } else if (queries && !linear) {
+            report.optQuerySkipped =
+                "top-k and Pareto queries rank linear costs (no "
+                "--costs-pair)";
+        }
+        if (zddTask5) {
+            report.opt = zddOptimization(zr, costs);
+        } else {
+            ReachableContext full;
+            EncodedReachable fullEr;
+            PlaceEncoding fullEnc = enc;
+            if (opt.reduce && fullEncoded) {
+                fullEnc = boundedEncoding(netBounds());
+                fullEr = symbolicReachability(net, fullEnc);
+                full.mgr = fullEr.mgr;
+                full.R = fullEr.R;
+            } else if (opt.reduce) {
+                full = buildReachableContext(net);
+            }
+            ReachableContext& use = opt.reduce ? full : ctx;
+            report.optLowerBound = !opt.reduce && report.symbolicPartial;
+            if (fullEncoded) {
+                // the recursive engine reads one bit per place
+                report.opt =
+                    optimizationADD(use.mgr, use.R, fullEnc, objective);
+            } else if (opt.optEngine == "add" || !linear) {
+                // and sums linear costs only
+                report.opt = optimizationADD(use.mgr, use.R,
+                                             oneBitEncoding(report.places),
+                                             objective);
+            } else {
+                report.opt = optimizationTask5Function(use.mgr, use.R, costs);
+            }
+            // both walk the BDD with one variable per place
+            bool walk = !fullEncoded && linear;
+            if (walk && opt.optTopK > 0) {
+                report.optTopK =
+                    optimizationTopK(use.mgr, use.R, costs, opt.optTopK).best;
+            }
+            if (walk && !opt.paretoObjectives.empty()) {
+                vector<vector<int>> objectives = opt.paretoObjectives;
+                for (auto& o : objectives) o.resize(report.places, 0);
+                report.optPareto =
+                    optimizationPareto(use.mgr, use.R, objectives).front;
+            }
+            // every costs vector of the sweep in one traversal
+            if (!fullEncoded && sweep) {
+                vector<vector<int>> matrix = opt.costSweep;
+                for (auto& c : matrix) c.resize(report.places, 0);
+                report.optSweep = optimizationBatch(use.mgr, use.R, matrix);
+            }
+            if (fullEr.mgr != nullptr) {
+                freeEncodedReachable(fullEr);
+            } else {
+                freeReachableContext(full);
+            }
+        }
+        report.optDone = true;
+    }
+
+    if (er.mgr != nullptr) {
+        freeEncodedReachable(er);
+    } else if (needBDD) {
+        freeReachableContext(ctx);
+    }
+    freeZddReachable(zr);
+    return report;
+}
+
+AnalysisReport analyzeFile(const string& fileName,
+                           const AnalysisOptions& opt) {
+    PetriNet net;
+    double parseMs = 0;
+    {
+        MuteCout mute(!opt.verbose);
+        Prof::Scope scope("task1_parse");
+        auto start = chrono::steady_clock::now();
+        RawData raw = toRaw(fileName);
+        if (raw.Blocks.empty()) {
+            AnalysisReport failed;
+            failed.file = fileName;
+            failed.error = "failed to parse data or file is empty";
+            return failed;
+        }
+        net = toPetriNet(raw);
+        parseMs = chrono::duration<double, milli>(
+                      chrono::steady_clock::now() - start)
+                      .count();
+    }
+
+    AnalysisReport report = analyzeNet(net, opt);
+    report.file = fileName;
+    report.taskMs.insert(report.taskMs.begin(), {"task1_parse", parseMs});
+    return report;
+}
+
+string csvHeader() {
+    return "file,places,transitions,explicit_states,symbolic_states,"
+           "bdd_nodes,deadlock,dead_marking,max_value,optimal_marking,"
+           "total_ms,error\n";
+}
+
+string formatReport(const AnalysisReport& r, OutputFormat format) {
+    ostringstream out;
+    double totalMs = 0;
+    for (const auto& t : r.taskMs) totalMs += t.second;
+
+    if (format == OutputFormat::CSV) {
+        // markings are space-separated to stay inside one CSV field
+        auto cell = [](const Marking& M) {
+            string s;
+            for (size_t i = 0; i < M.size(); ++i)
+                s += (i ? " " : "") + to_string(M[i]);
+            return s;
+        };
+        out << r.file << "," << r.places << "," << r.transitions << ",";
+        if (r.explicitDone) out << r.explicitStates;
+        out << ",";
+        if (r.symbolicDone) out << r.symbolicStates;
+        out << ",";
+        if (r.symbolicDone) out << r.bddNodes;
+        out << ",";
+        if (r.deadlockDone) out << (r.deadlockFound ? "yes" : "no");
+        out << "," << cell(r.deadMarking) << ",";
+        if (r.optDone && r.opt.found) out << r.opt.maxValue;
+        out << "," << cell(r.opt.optimalMarking) << "," << totalMs << ","
+            << r.error << "\n";
+        return out.str();
+    }
+
+    if (format == OutputFormat::JSON) {
+        out << "{\"file\": " << jsonString(r.file);
+        if (!r.error.empty()) {
+            out << ", \"error\": " << jsonString(r.error) << "}\n";
+            return out.str();
+        }
+        out << ", \"places\": " << r.places
+            << ", \"transitions\": " << r.transitions
+            << ", \"initial_marking\": " << markingString(r.initialMarking);
+        if (r.reduced) {
+            out << ", \"reduction\": {\"places\": " << r.reducedPlaces
+                << ", \"transitions\": " << r.reducedTransitions
+                << ", \"exact_counts\": "
+                << (r.countsExact ? "true" : "false")
+                << ", \"rules\": {";
+            for (size_t i = 0; i < r.reductionRules.size(); ++i) {
+                out << (i ? ", " : "") << jsonString(r.reductionRules[i].first)
+                    << ": " << r.reductionRules[i].second;
+            }
+            out << "}}";
+        }
+        if (r.boundsDone) {
+            out << ", \"bounds\": {\"max\": " << r.maxBound
+                << ", \"safe\": " << (r.oneSafe ? "true" : "false")
+                << ", \"encoding\": " << jsonString(r.encoding)
+                << ", \"bits\": " << r.encodingBits
+                << ", \"width\": " << r.markingWidth << "}";
+        }
+        if (r.compressed) {
+            out << ", \"invariants\": {\"p\": " << r.pInvariants
+                << ", \"t\": " << r.tInvariants
+                << ", \"implied_places\": " << r.impliedPlaces << "}";
+        }
+        if (r.coverabilityDone) {
+            out << ", \"coverability\": {\"basis\": " << r.coverBasis
+                << ", \"nodes\": " << r.coverNodes << ", \"unbounded\": [";
+            for (size_t i = 0; i < r.unboundedPlaces.size(); ++i) {
+                out << (i ? ", " : "") << jsonString(r.unboundedPlaces[i]);
+            }
+            out << "], \"samples\": [";
+            for (size_t i = 0; i < r.samples.size(); ++i)
+                out << (i ? ", " : "") << coverString(r.samples[i], true);
+            out << "]";
+            if (r.coverQueried) {
+                out << ", \"coverable\": "
+                    << (r.coverable ? "true" : "false");
+            }
+            out << "}";
+        }
+        if (!r.skippedTasks.empty()) {
+            out << ", \"skipped_tasks\": [";
+            for (size_t i = 0; i < r.skippedTasks.size(); ++i)
+                out << (i ? ", " : "") << r.skippedTasks[i];
+            out << "]";
+        }
+        if (r.explicitDone) {
+            out << ", \"explicit\": {\"states\": " << r.explicitStates;
+            if (r.explicitPartial) {
+                out << ", \"partial\": true, \"frontier\": "
+                    << r.explicitFrontier;
+            }
+            if (r.parentBytes > 0)
+                out << ", \"parent_bytes\": " << r.parentBytes;
+            if (!r.explicitKernel.empty())
+                out << ", \"kernel\": " << jsonString(r.explicitKernel);
+            if (r.stateWords > 0) out << ", \"state_words\": " << r.stateWords;
+            if (!r.jitStatus.empty())
+                out << ", \"jit\": " << jsonString(r.jitStatus);
+            if (r.explicitCheckpointed) {
+                out << ", \"checkpoint\": "
+                    << checkpointJson(r.explicitCheckpoint);
+            }
+            out << ", \"samples\": [";
+            for (size_t i = 0; i < r.samples.size(); ++i)
+                out << (i ? ", " : "") << markingString(r.samples[i]);
+            out << "]}";
+        }
+        if (r.graphDone) {
+            auto ids = [&](const vector<string>& list) {
+                out << "[";
+                for (size_t i = 0; i < list.size(); ++i)
+                    out << (i ? ", " : "") << jsonString(list[i]);
+                out << "]";
+            };
+            out << ", \"graph\": {\"states\": " << r.graphStates
+                << ", \"edges\": " << r.graphEdges << ", \"sccs\": " << r.sccs
+                << ", \"bottom_sccs\": " << r.bottomSccs << ", \"reversible\": "
+                << (r.reversible ? "true" : "false")
+                << ", \"home_states\": " << r.homeStates;
+            if (r.homeStates > 0)
+                out << ", \"home_state\": " << markingString(r.homeState);
+            out << ", \"live\": " << (r.notLive.empty() ? "true" : "false")
+                << ", \"not_live\": ";
+            ids(r.notLive);
+            out << ", \"never_fired\": ";
+            ids(r.neverFired);
+            if (r.graphBytes > 0) out << ", \"bytes\": " << r.graphBytes;
+            out << "}";
+        }
+        if (r.targetSearch.done)
+            out << ", \"search\": " << searchJson(r.targetSearch);
+        if (r.symbolicDone) {
+            out << ", \"symbolic\": {\"states\": " << r.symbolicStates
+                << (r.zddNodes ? ", \"zdd_nodes\": "
+                               : ", \"bdd_nodes\": ")
+                << r.bddNodes;
+            if (r.symbolicPartial) {
+                out << ", \"partial\": true, \"levels\": "
+                    << r.symbolicLevels
+                    << ", \"frontier\": " << r.symbolicFrontier;
+            }
+            if (r.parallel.threads > 0)
+                out << ", \"parallel\": " << parallelJson(r.parallel);
+            if (r.symbolicCheckpointed) {
+                out << ", \"checkpoint\": "
+                    << checkpointJson(r.symbolicCheckpoint);
+            }
+            out << "}";
+        }
+        if (r.deadlockDone) {
+            out << ", \"deadlock\": {\"found\": "
+                << (r.deadlockFound ? "true" : "false");
+            if (r.deadlockFound)
+                out << ", \"marking\": " << markingString(r.deadMarking);
+            if (r.simWalks > 0) {
+                out << ", \"walks\": " << r.simWalks
+                    << ", \"firings\": " << r.simFirings;
+            }
+            if (r.prefixDone) {
+                out << ", \"unfolding\": {\"events\": " << r.prefixEvents
+                    << ", \"conditions\": " << r.prefixConditions
+                    << ", \"cutoffs\": " << r.prefixCutoffs
+                    << ", \"complete\": "
+                    << (r.prefixComplete ? "true" : "false")
+                    << ", \"sat_conflicts\": " << r.satConflicts << "}";
+            }
+            if (r.simWalks > 0 || r.prefixDone || r.shortestTrace ||
+                !r.deadlockTrace.empty()) {
+                out << ", \"trace\": [";
+                for (size_t i = 0; i < r.deadlockTrace.size(); ++i)
+                    out << (i ? ", " : "") << jsonString(r.deadlockTrace[i]);
+                out << "]";
+                if (r.shortestTrace) out << ", \"shortest\": true";
+            }
+            if (r.deadlockSearch.done)
+                out << ", \"search\": " << searchJson(r.deadlockSearch);
+            out << "}";
+        }
+        if (r.ctlSkipped) out << ", \"ctl_skipped\": true";
+        if (!r.ctl.empty()) {
+            out << ", \"ctl\": [";
+            for (size_t i = 0; i < r.ctl.size(); ++i) {
+                const CtlReport& c = r.ctl[i];
+                out << (i ? ", " : "") << "{\"formula\": "
+                    << jsonString(c.formula) << ", \"holds\": "
+                    << (c.holds ? "true" : "false")
+                    << ", \"states\": " << c.states;
+                if (c.hasPath) {
+                    out << ", \"trace\": [";
+                    for (size_t j = 0; j < c.trace.size(); ++j)
+                        out << (j ? ", " : "") << jsonString(c.trace[j]);
+                    out << "], \"marking\": " << markingString(c.marking);
+                }
+                out << "}";
+            }
+            out << "]";
+        }
+        if (r.optDone) {
+            out << ", \"optimization\": {\"found\": "
+                << (r.opt.found ? "true" : "false");
+            if (r.opt.found) {
+                out << ", \"max_value\": " << r.opt.maxValue
+                    << ", \"marking\": " << markingString(r.opt.optimalMarking);
+            }
+            if (r.optLowerBound) out << ", \"lower_bound\": true";
+            if (!r.optTopK.empty()) {
+                out << ", \"top_k\": [";
+                for (size_t i = 0; i < r.optTopK.size(); ++i) {
+                    out << (i ? ", " : "") << "{\"value\": "
+                        << r.optTopK[i].value << ", \"marking\": "
+                        << markingString(r.optTopK[i].marking) << "}";
+                }
+                out << "]";
+            }
+            if (!r.optPareto.empty()) {
+                out << ", \"pareto\": [";
+                for (size_t i = 0; i < r.optPareto.size(); ++i) {
+                    out << (i ? ", " : "") << "{\"values\": [";
+                    const auto& values = r.optPareto[i].values;
+                    for (size_t j = 0; j < values.size(); ++j)
+                        out << (j ? ", " : "") << values[j];
+                    out << "], \"marking\": "
+                        << markingString(r.optPareto[i].marking) << "}";
+                }
+                out << "]";
+            }
+            const OptimizationBatchResult& sweep = r.optSweep;
+            if (!sweep.maxValues.empty()) {
+                out << ", \"sweep\": {\"vectors_per_second\": "
+                    << sweep.vectorsPerSecond << ", \"results\": [";
+                for (size_t m = 0; m < sweep.maxValues.size(); ++m) {
+                    out << (m ? ", " : "");
+                    if (sweep.optimalMarkings[m].empty()) {
+                        out << "null";
+                        continue;
+                    }
+                    out << "{\"max_value\": " << sweep.maxValues[m]
+                        << ", \"marking\": "
+                        << markingString(sweep.optimalMarkings[m]) << "}";
+                }
+                out << "]}";
+            }
+            if (!r.optQuerySkipped.empty()) {
+                out << ", \"queries_skipped\": "
+                    << jsonString(r.optQuerySkipped);
+            }
+            out << "}";
+        }
+        if (r.budgetStopped) {
+            out << ", \"budget\": {\"reason\": " << jsonString(r.budgetReason);
+            if (r.fallback == "bitstate") {
+                out << ", \"fallback\": \"bitstate\", \"states\": "
+                    << r.fallbackStates << ", \"complete\": "
+                    << (r.fallbackComplete ? "true" : "false")
+                    << ", \"hash_factor\": " << r.hashFactor;
+            } else if (r.fallback == "sim") {
+                out << ", \"fallback\": \"sim\", \"walks\": "
+                    << r.fallbackWalks << ", \"firings\": "
+                    << r.fallbackFirings;
+            }
+            if (!r.fallback.empty()) {
+                out << ", \"deadlock\": "
+                    << (r.fallbackDeadlock ? "true" : "false");
+            }
+            out << "}";
+        }
+        out << ", \"ms\": {";
+        for (size_t i = 0; i < r.taskMs.size(); ++i) {
+            out << (i ? ", " : "") << jsonString(r.taskMs[i].first) << ": "
+                << r.taskMs[i].second;
+        }
+        out << "}}\n";
+        return out.str();
+    }
+
+    // Human
+    out << "File: " << r.file << "\n";
+    if (!r.error.empty()) {
+        out << "Error: " << r.error << "\n";
+        return out.str();
+    }
+    out << "Places: " << r.places << ", Transitions: " << r.transitions
+        << "\nInitial Marking M0: " << markingString(r.initialMarking)
+        << "\n";
+    if (r.reduced) {
+        out << "Reduced to " << r.reducedPlaces << " places, "
+            << r.reducedTransitions << " transitions (";
+        for (size_t i = 0; i < r.reductionRules.size(); ++i) {
+            out << (i ? ", " : "") << r.reductionRules[i].first << " x"
+                << r.reductionRules[i].second;
+        }
+        out << ")"
+            << (r.countsExact ? "" : ", state counts are of the reduced net")
+            << "\n";
+    }
+    if (r.boundsDone) {
+        out << "Max tokens per place: ";
+        if (r.maxBound >= 0) {
+            out << r.maxBound;
+        } else {
+            out << "unknown";
+        }
+        out << (r.oneSafe ? " (1-safe)" : "") << ", encoding: " << r.encoding
+            << " (" << r.encodingBits << " BDD variables, "
+            << r.markingWidth << " byte(s) per place in Task 2)\n";
+    }
+    if (r.compressed) {
+        out << "P-invariants: " << r.pInvariants
+            << ", T-invariants: " << r.tInvariants << ", implied places: "
+            << r.impliedPlaces << " (dropped by the engines)\n";
+    }
+    if (r.coverabilityDone) {
+        out << "\n--- Task 2: Coverability (Karp-Miller) ---\n"
+            << "Minimal coverability set: " << r.coverBasis << " markings ("
+            << r.coverNodes << " tree nodes)\nUnbounded places:";
+        for (const auto& id : r.unboundedPlaces) out << " " << id;
+        if (r.unboundedPlaces.empty()) out << " none";
+        out << "\n";
+        for (size_t i = 0; i < r.samples.size(); ++i) {
+            out << "Marking " << i + 1 << ": "
+                << coverString(r.samples[i], false) << "\n";
+        }
+        if (r.coverQueried) {
+            out << "Target marking is "
+                << (r.coverable ? "coverable" : "not coverable") << "\n";
+        }
+    }
+    if (!r.skippedTasks.empty()) {
+        out << "Skipped on an unbounded net: Task";
+        for (int t : r.skippedTasks) out << " " << t;
+        out << "\n";
+    }
+    if (r.explicitDone) {
+        out << "\n--- Task 2: Explicit Reachability ---\n"
+            << "Total reachable markings found: " << r.explicitStates << "\n";
+        if (r.explicitPartial) {
+            out << "Stopped by the budget: at least "
+                << r.explicitStates + r.explicitFrontier << " reachable ("
+                << r.explicitFrontier << " found but not expanded)\n";
+        }
+        if (r.parentBytes > 0)
+            out << "Parent pointers: " << r.parentBytes << " bytes\n";
+        if (!r.explicitKernel.empty())
+            out << "Batch kernel: " << r.explicitKernel << "\n";
+        if (r.stateWords > 0)
+            out << "Fixed-size states: " << r.stateWords << " word(s)\n";
+        if (!r.jitStatus.empty())
+            out << "Compiled net: " << r.jitStatus << "\n";
+        if (r.explicitCheckpointed)
+            out << checkpointHuman(r.explicitCheckpoint, "markings");
+        for (size_t i = 0; i < r.samples.size(); ++i) {
+            out << "Marking " << i + 1 << ": " << markingString(r.samples[i])
+                << "\n";
+        }
+    }
+    if (r.graphDone) {
+        out << "\n--- Reachability graph ---\n"
+            << r.graphStates << " states, " << r.graphEdges << " edges, "
+            << r.sccs << " SCCs (" << r.bottomSccs << " terminal)\n"
+            << "Reversible: " << (r.reversible ? "yes" : "no") << "\n";
+        if (r.homeStates > 0) {
+            out << "Home states: " << r.homeStates << ", e.g. "
+                << markingString(r.homeState) << "\n";
+        } else {
+            out << "Home states: none\n";
+        }
+        if (r.notLive.empty()) {
+            out << "Live: every transition\n";
+        } else {
+            out << "Not live:";
+            for (const auto& t : r.notLive) out << " " << t;
+            out << "\n";
+        }
+        if (!r.neverFired.empty()) {
+            out << "Never fired:";
+            for (const auto& t : r.neverFired) out << " " << t;
+            out << "\n";
+        }
+        if (r.graphBytes > 0)
+            out << "Graph written (" << r.graphBytes << " bytes)\n";
+    }
+    if (r.targetSearch.done) {
+        const SearchReport& ts = r.targetSearch;
+        out << "\n--- Target search (" << ts.goal << ") ---\n";
+        if (ts.found) {
+            out << "Found: " << markingString(ts.marking) << "\n";
+        } else {
+            out << "Not found.\n";
+        }
+        out << searchHuman(ts);
+    }
+    if (r.symbolicDone) {
+        out << "\n--- Task 3: Symbolic Reachability ---\n"
+            << "Number of reachable markings ("
+            << (r.zddNodes ? "ZDD" : "BDD") << "): " << r.symbolicStates
+            << " (" << r.bddNodes << " nodes)\n";
+        if (r.symbolicPartial) {
+            out << "Stopped by the budget after " << r.symbolicLevels
+                << " BFS levels: a lower bound (" << r.symbolicFrontier
+                << " markings in the last level)\n";
+        }
+        const ParallelImageStats& ps = r.parallel;
+        if (ps.threads > 0) {
+            out << "Parallel images: " << ps.threads << " threads, "
+                << ps.iterations.size() << " levels; image speedup "
+                << ps.speedup() << "x, transfers "
+                << 100 * ps.transferShare() << "% of worker time\n";
+        }
+        if (r.symbolicCheckpointed)
+            out << checkpointHuman(r.symbolicCheckpoint, "iterations");
+    }
+    if (r.deadlockDone) {
+        out << "\n--- Task 4: Deadlock detection ---\n";
+        if (r.deadlockFound) {
+            out << "Deadlock: " << markingString(r.deadMarking) << "\n";
+        } else {
+            out << "No deadlock is found.\n";
+        }
+        if (!r.deadlockExhaustive && r.symbolicPartial)
+            out << "The reachable set is partial: not a proof of freedom.\n";
+        if (r.simWalks > 0) {
+            out << "Random walks: " << r.simWalks << ", firings: "
+                << r.simFirings
+                << (r.deadlockFound ? "" : " (not a proof of freedom)")
+                << "\n";
+        }
+        if (r.prefixDone) {
+            out << "Unfolding prefix: " << r.prefixEvents << " events ("
+                << r.prefixCutoffs << " cut-offs), " << r.prefixConditions
+                << " conditions"
+                << (r.prefixComplete ? "" : ", stopped at the event limit")
+                << "; SAT conflicts: " << r.satConflicts << "\n";
+            if (!r.deadlockExhaustive && !r.deadlockFound)
+                out << "The prefix is incomplete: not a proof of freedom.\n";
+        }
+        if (r.deadlockFound && !r.deadlockTrace.empty()) {
+            out << (r.shortestTrace ? "Shortest trace (" : "Trace (")
+                << r.deadlockTrace.size() << " firings):";
+            for (const auto& t : r.deadlockTrace) out << " " << t;
+            out << "\n";
+        }
+        if (r.deadlockSearch.done) out << searchHuman(r.deadlockSearch);
+    }
+    if (r.ctlSkipped) {
+        out << "\n--- CTL ---\nSkipped: the budget ran out before the "
+               "reachable set was complete.\n";
+    }
+    if (!r.ctl.empty()) {
+        out << "\n--- CTL ---\n";
+        for (const CtlReport& c : r.ctl) {
+            out << c.formula << ": " << (c.holds ? "true" : "false") << " ("
+                << c.states << " reachable markings satisfy it)\n";
+            if (!c.hasPath) continue;
+            out << "  " << (c.holds ? "Witness" : "Counterexample") << " ("
+                << c.trace.size() << " firings):";
+            for (const auto& t : c.trace) out << " " << t;
+            out << " -> " << markingString(c.marking) << "\n";
+        }
+    }
+    if (r.optDone) {
+        out << "\n--- Task 5: Linear optimization ---\n";
+        if (r.opt.found) {
+            out << "this marking is a maximizer:\n"
+                << markingString(r.opt.optimalMarking)
+                << " Max value: " << r.opt.maxValue
+                << (r.optLowerBound ? " (over a partial reachable set: a "
+                                      "lower bound)"
+                                    : "")
+                << "\n";
+        } else {
+            out << "No reachable marking.\n";
+        }
+        if (!r.optTopK.empty()) out << "Top " << r.optTopK.size() << ":\n";
+        for (size_t i = 0; i < r.optTopK.size(); ++i) {
+            out << "#" << i + 1 << ": " << markingString(r.optTopK[i].marking)
+                << " value: " << r.optTopK[i].value << "\n";
+        }
+        if (!r.optPareto.empty()) {
+            out << "Pareto front (" << r.optPareto.size() << " points):\n";
+        }
+        for (const auto& p : r.optPareto) {
+            out << "(";
+            for (size_t j = 0; j < p.values.size(); ++j)
+                out << (j ? ", " : "") << p.values[j];
+            out << ") " << markingString(p.marking) << "\n";
+        }
+        const OptimizationBatchResult& sweep = r.optSweep;
+        for (size_t m = 0; m < sweep.maxValues.size(); ++m) {
+            if (sweep.optimalMarkings[m].empty()) continue;
+            out << "costs #" << m << ": "
+                << markingString(sweep.optimalMarkings[m])
+                << " Max value: " << sweep.maxValues[m] << "\n";
+        }
+        if (!sweep.maxValues.empty()) {
+            out << "Sweep: " << sweep.maxValues.size() << " costs vectors in "
+                << sweep.seconds * 1000 << " ms (" << sweep.vectorsPerSecond
+                << " vectors/s)\n";
+        }
+        if (!r.optQuerySkipped.empty())
+            out << "Skipped: " << r.optQuerySkipped << "\n";
+    }
+    if (r.budgetStopped) {
+        out << "\n--- Budget ---\nRan out of " << r.budgetReason << "\n";
+        if (r.fallback == "bitstate") {
+            out << "Fallback bitstate search: " << r.fallbackStates
+                << " markings (a lower bound), hash factor " << r.hashFactor
+                << (r.fallbackComplete ? "" : ", stopped by its budget")
+                << "\n";
+        } else if (r.fallback == "sim") {
+            out << "Fallback random walks: " << r.fallbackWalks
+                << ", firings: " << r.fallbackFirings << "\n";
+        }
+        if (!r.fallback.empty()) {
+            out << "Fallback " << (r.fallbackDeadlock ? "found" : "found no")
+                << " deadlock\n";
+        }
+    }
+    out << "\n";
+    for (const auto& t : r.taskMs) {
+        out << "[" << t.first << "] " << t.second << " ms\n";
+    }
+    return out.str();
+}
@@ -0,0 +1,256 @@
+#include "batch.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <thread>
+
+#include "budget.h"
+#include "profiler.h"
+#include "reachability.h"
+#include "thread_pool.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+// A fresh CUDD manager with the default tables, measured with
+// Cudd_ReadMemoryInUse (see bench/baseline.csv, symbolic stage)
+const size_t CUDD_MANAGER_BYTES = 24u << 20;
+// Rough allowance per reachable state for the BDDs of the fixpoint
+const size_t BDD_BYTES_PER_STATE = 64;
+
+size_t physicalMemory() {
+#if defined(_SC_PHYS_PAGES) && defined(_SC_PAGE_SIZE)
+    long pages = sysconf(_SC_PHYS_PAGES);
+    long pageSize = sysconf(_SC_PAGE_SIZE);
+    if (pages > 0 && pageSize > 0) return (size_t)pages * (size_t)pageSize;
+#endif
+    return size_t(4) << 30;
+}
+
+struct BatchJob {
+    size_t index = 0;  // position in the input list
+    string file;
+    PetriNet net;
+    double parseMs = 0;
+    string error;
+    NetEstimate estimate;
+};
+
+// Lets loaded jobs run so that the reserved memory stays within budget.
+class Admission {
+   public:
+    explicit Admission(size_t budget)
+        : budget_(budget), baseRss_(residentBytes()) {}
+
+    // Blocks until the job fits, or nothing else runs.
+    void acquire(const BatchJob& job) {
+        unique_lock<mutex> lock(mutex_);
+        while (true) {
+            size_t rss = residentBytes();
+            size_t used = max(reserved_, rss > baseRss_ ? rss - baseRss_ : 0);
+            if (running_ == 0 || used + job.estimate.bytes <= budget_) {
+                reserved_ += job.estimate.bytes;
+                peakReserved_ = max(peakReserved_, reserved_);
+                ++running_;
+                return;
+            }
+            // RSS also drops when a net's manager is freed, so poll as well
+            released_.wait_for(lock, chrono::milliseconds(50));
+        }
+    }
+
+    void release(const BatchJob& job) {
+        {
+            lock_guard<mutex> lock(mutex_);
+            reserved_ -= job.estimate.bytes;
+            --running_;
+        }
+        released_.notify_all();
+    }
+
+    size_t peakReserved() {
+        lock_guard<mutex> lock(mutex_);
+        return peakReserved_;
+    }
+
+   private:
+    size_t budget_;
+    size_t baseRss_;
+    size_t reserved_ = 0;
+    size_t peakReserved_ = 0;
+    int running_ = 0;
+    mutex mutex_;
+    condition_variable released_;
+};
+
+void loadJob(BatchJob& job, const BatchOptions& options) {
+    MuteCout mute(!options.analysis.verbose);
+    auto start = chrono::steady_clock::now();
+    RawData raw = toRaw(job.file);
+    if (raw.Blocks.empty()) {
+        job.error = "failed to parse data or file is empty";
+        return;
+    }
+    job.net = toPetriNet(raw);
+    job.parseMs =
+        chrono::duration<double, milli>(chrono::steady_clock::now() - start)
+            .count();
+    job.estimate = estimateNet(job.net, options.analysis, options.probeStates);
+}
+
+// formatReport's JSON line with the scheduling details appended
+string batchLine(const AnalysisReport& report, const BatchJob& job) {
+    string line = formatReport(report, OutputFormat::JSON);
+    line.erase(line.find_last_of('}'));  // reopen the outer object
+    line += ", \"batch\": {\"index\": " + to_string(job.index) +
+            ", \"estimated_states\": " + to_string(job.estimate.states) +
+            ", \"estimate_exact\": " +
+            (job.estimate.exact ? "true" : "false") +
+            ", \"estimated_kb\": " + to_string(job.estimate.bytes / 1024) +
+            "}}\n";
+    return line;
+}
+
+}  // namespace
+
+NetEstimate estimateNet(const PetriNet& net, const AnalysisOptions& opt,
+                        size_t probeStates) {
+    int P = static_cast<int>(net.places.size());
+    int T = static_cast<int>(net.transitions.size());
+
+    set<Marking> seen = {net.initialMarking};
+    queue<Marking> frontier;
+    frontier.push(net.initialMarking);
+    while (!frontier.empty() && seen.size() < probeStates) {
+        Marking M = frontier.front();
+        frontier.pop();
+        for (int t = 0; t < T; ++t) {
+            if (!is_enabled(M, t, net)) continue;
+            Marking next = fire_transition(M, t, net);
+            if (seen.insert(next).second) frontier.push(next);
+        }
+    }
+
+    NetEstimate e;
+    e.exact = frontier.empty();
+    e.states = seen.size();
+    if (!e.exact) {
+        double bound = P < 63 ? ldexp(1.0, P) : 9.2e18;
+        e.states = static_cast<size_t>(
+            min(bound, static_cast<double>(seen.size()) * max(P, 1)));
+    }
+
+    // explicitReachability keeps every marking twice (set + result list)
+    if (opt.tasks.count(2)) {
+        e.bytes += e.states * 2 * (P * sizeof(int) + 3 * sizeof(void*) + 32);
+    }
+    bool needBDD = opt.tasks.count(3) || opt.tasks.count(5) ||
+                   opt.tasks.count(4);  // the ILP path builds R as well
+    if (needBDD) e.bytes += CUDD_MANAGER_BYTES + e.states * BDD_BYTES_PER_STATE;
+    return e;
+}
+
+vector<string> collectBatchInputs(const string& path) {
+    namespace fs = std::filesystem;
+    vector<string> files;
+    error_code ec;
+    if (fs::is_directory(path, ec)) {
+        for (const auto& entry : fs::recursive_directory_iterator(path, ec)) {
+            if (entry.is_regular_file() && entry.path().extension() == ".pnml")
+                files.push_back(entry.path().string());
+        }
+        sort(files.begin(), files.end());
+        return files;
+    }
+    if (fs::path(path).extension() == ".pnml") return {path};
+
+    ifstream manifest(path);
+    if (!manifest.is_open()) return files;
+    fs::path base = fs::path(path).parent_path();
+    string line;
+    while (getline(manifest, line)) {
+        size_t first = line.find_first_not_of(" \t\r");
+        size_t last = line.find_last_not_of(" \t\r");
+        line = first == string::npos ? "" : line.substr(first, last - first + 1);
+        if (line.empty() || line[0] == '#') continue;
+        // relative to the working directory, else to the manifest
+        if (!fs::exists(line) && fs::exists(base / line))
+            line = (base / line).string();
+        files.push_back(line);
+    }
+    return files;
+}
+
+int runBatch(const vector<string>& files, const BatchOptions& options,
+             ostream& out) {
+    PROFILE_SCOPE("runBatch");
+    auto start = chrono::steady_clock::now();
+    int jobs = options.jobs > 0 ? options.jobs
+                                : max(1u, thread::hardware_concurrency());
+    size_t budget = options.memoryBudget > 0 ? options.memoryBudget
+                                             : physicalMemory() / 4 * 3;
+
+    Admission admission(budget);
+    atomic<size_t> next{0};  // next input to load
+    mutex outLock;
+    int failures = 0;
+    {
+        ThreadPool pool(jobs);
+        for (int w = 0; w < jobs; ++w) {
+            pool.submit([&] {
+                for (size_t i = next++; i < files.size(); i = next++) {
+                    // parsed and probed by the worker that runs it, and
+                    // gone once its line is out
+                    BatchJob job;
+                    job.index = i;
+                    job.file = files[i];
+                    loadJob(job, options);
+                    admission.acquire(job);
+                    AnalysisReport report;
+                    if (job.error.empty()) {
+                        try {
+                            report = analyzeNet(job.net, options.analysis);
+                        } catch (const exception& e) {
+                            report = AnalysisReport();
+                            report.error = e.what();
+                        }
+                        report.taskMs.insert(report.taskMs.begin(),
+                                             {"task1_parse", job.parseMs});
+                    } else {
+                        report.error = job.error;
+                    }
+                    report.file = job.file;
+                    job.net = PetriNet();  // done with it
+                    admission.release(job);
+
+                    string line = batchLine(report, job);
+                    lock_guard<mutex> guard(outLock);
+                    if (!report.error.empty()) ++failures;
+                    out << line << flush;
+                }
+            });
+        }
+        pool.wait();
+    }
+
+    double seconds =
+        chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cerr << "Batch: " << files.size() << " nets, " << failures
+         << " failed, " << jobs << " workers, " << seconds << " s, peak "
+         << admission.peakReserved() / (1 << 20) << " of " << budget / (1 << 20)
+         << " MB reserved\n";
+    return failures;
+}
@@ -1,188 +1,584 @@
 #include "bdd.h"
 
+#include <chrono>
+#include <filesystem>
 #include <iostream>
+#include <map>
 #include <vector>
 
-#include "heap_counter.h"
+#include "profiler.h"
 
 using std::cout;
 using std::endl;
+using std::map;
+using std::pair;
 using std::vector;
 
-DdNode* compute_post(DdManager* mgr, DdNode* R,
-                     const vector<vector<int>>& incidence, int t,
-                     const vector<DdNode*>& x, const vector<DdNode*>& x_next) {
-    int P = static_cast<int>(incidence.size());
+DdNode* symbolicReachability(const PetriNet& net) {
+    PROFILE_SCOPE("symbolicReachability");
+    int P = static_cast<int>(net.places.size());
 
-    // 1) enabled(x)  =  ∧_{p | C[p][t] < 0} x[p]
-    DdNode* enabled = Cudd_ReadOne(mgr);
-    Cudd_Ref(enabled);
-    for (int p = 0; p < P; ++p) {
-        if (incidence[p][t] < 0) {  // cần token ở place p
-            DdNode* tmp = Cudd_bddAnd(mgr, enabled, x[p]);
-            Cudd_Ref(tmp);
-            Cudd_RecursiveDeref(mgr, enabled);
-            enabled = tmp;
-        }
+    DdManager* mgr = Cudd_Init(0, 0, CUDD_UNIQUE_SLOTS, CUDD_CACHE_SLOTS, 0);
+
+    // Tạo biến trạng thái x[0..P-1]
+    vector<DdNode*> x(P);
+    for (int i = 0; i < P; ++i) {
+        DdNode* v = Cudd_bddNewVar(mgr);
+        Cudd_Ref(v);
+        x[i] = v;
     }
 
-    // 2) relation(x, x') mô tả hiệu ứng bắn t trên mọi place:
-    //    - C[p][t] == 0  ->  x'_p <-> x_p  (giữ nguyên)
-    //    - C[p][t] > 0   ->  x'_p = 1      (place nhận token)
-    //    - C[p][t] < 0   ->  x'_p = 0      (place mất token)
-    DdNode* relation = Cudd_ReadOne(mgr);
-    Cudd_Ref(relation);
-    for (int p = 0; p < P; ++p) {
-        int c = incidence[p][t];
-        DdNode* clause = nullptr;
-
-        if (c == 0) {
-            // x_next[p] <-> x[p]
-            clause = Cudd_bddXnor(mgr, x_next[p], x[p]);
-            Cudd_Ref(clause);
-        } else if (c > 0) {
-            // place nhận token: x_next[p] = 1
-            clause = x_next[p];
-            Cudd_Ref(clause);
-        } else {
-            // place mất token: x_next[p] = 0
-            clause = Cudd_Not(x_next[p]);
-            Cudd_Ref(clause);
-        }
+    // R ban đầu = {M0}, rồi bao đóng theo các quan hệ chuyển đã cache
+    TransitionRelations tr =
+        buildTransitionRelations(mgr, net, oneBitEncoding(P), true);
+    DdNode* M0 = make_marking(mgr, x.data(), net.initialMarking, P);
+    DdNode* R = forwardClosure(tr, M0);
+    Cudd_RecursiveDeref(mgr, M0);
+    freeTransitionRelations(tr);
+
+    cout << "\n--- Task 3 Results (Symbolic Reachability with BDDs) ---"
+         << endl;
+    double num = Cudd_CountMinterm(mgr, R, P);  // R chỉ phụ thuộc vào P biến x
+    cout << "Number of reachable markings (BDD): " << num << endl;
+    PROFILE_CUDD(mgr);
 
-        DdNode* tmp = Cudd_bddAnd(mgr, relation, clause);
+    return R;
+}
+
+DdNode* make_marking(DdManager* mgr, DdNode** x, const std::vector<int>& bits,
+                     int n) {
+    DdNode* res = Cudd_ReadOne(mgr);
+    Cudd_Ref(res);
+    for (int i = 0; i < n; ++i) {
+        DdNode* lit = bits[i] ? x[i] : Cudd_Not(x[i]);
+        DdNode* tmp = Cudd_bddAnd(mgr, res, lit);
         Cudd_Ref(tmp);
+        Cudd_RecursiveDeref(mgr, res);
+        res = tmp;
+    }
 
-        Cudd_RecursiveDeref(mgr, relation);
-        Cudd_RecursiveDeref(mgr, clause);
-        relation = tmp;
+    return res;
+}
+
+// sum of coefficient * var == target, Ref'd. terms in variable order.
+static DdNode* linearEquals(DdManager* mgr,
+                            const vector<pair<DdNode*, long long>>& terms,
+                            size_t i, long long target,
+                            map<pair<size_t, long long>, DdNode*>& memo) {
+    if (i == terms.size()) {
+        DdNode* leaf =
+            target == 0 ? Cudd_ReadOne(mgr) : Cudd_ReadLogicZero(mgr);
+        Cudd_Ref(leaf);
+        return leaf;
+    }
+    auto it = memo.find({i, target});
+    if (it != memo.end()) {
+        Cudd_Ref(it->second);
+        return it->second;
     }
+    DdNode* hi =
+        linearEquals(mgr, terms, i + 1, target - terms[i].second, memo);
+    DdNode* lo = linearEquals(mgr, terms, i + 1, target, memo);
+    DdNode* res = Cudd_bddIte(mgr, terms[i].first, hi, lo);
+    Cudd_Ref(res);
+    Cudd_RecursiveDeref(mgr, hi);
+    Cudd_RecursiveDeref(mgr, lo);
+    Cudd_Ref(res);  // held by memo
+    memo[{i, target}] = res;
+    return res;
+}
 
-    // 3) chỉ xét các marking trong R mà t đang enabled
-    DdNode* cond = Cudd_bddAnd(mgr, R, enabled);
-    Cudd_Ref(cond);
-    Cudd_RecursiveDeref(mgr, enabled);
+CompressedReachable symbolicReachability(const PetriNet& net,
+                                         const PlaceCompression& pc) {
+    PROFILE_SCOPE("symbolicReachabilityCompressed");
+    int P = static_cast<int>(net.places.size());
+    int T = static_cast<int>(net.transitions.size());
+    int K = static_cast<int>(pc.kept.size());
+    const vector<vector<int>>& C = net.incidenceMatrix;
 
-    DdNode* trans = Cudd_bddAnd(mgr, cond, relation);
-    Cudd_Ref(trans);
-    Cudd_RecursiveDeref(mgr, cond);
-    Cudd_RecursiveDeref(mgr, relation);
+    CompressedReachable cr;
+    cr.mgr = Cudd_Init(0, 0, CUDD_UNIQUE_SLOTS, CUDD_CACHE_SLOTS, 0);
+    DdManager* mgr = cr.mgr;
+    vector<int> position(P, -1);
+    cr.x.resize(K);
+    for (int i = 0; i < K; ++i) {
+        cr.x[i] = Cudd_bddIthVar(mgr, i);
+        Cudd_Ref(cr.x[i]);
+        position[pc.kept[i]] = i;
+    }
 
-    // 4) Tồn tại hóa các biến trạng thái hiện tại x:
-    //    post_xprime(x') = ∃x. trans(x, x')
-    DdNode* cube = Cudd_ReadOne(mgr);
-    Cudd_Ref(cube);
+    // "implied place holds a token" (1-safe) as a BDD over kept places
+    vector<DdNode*> marked(P, nullptr);
     for (int p = 0; p < P; ++p) {
-        DdNode* tmp = Cudd_bddAnd(
-            mgr, cube, x[p]);  // phase không quan trọng, chỉ cần chứa biến
-        Cudd_Ref(tmp);
-        Cudd_RecursiveDeref(mgr, cube);
-        cube = tmp;
+        if (position[p] >= 0) marked[p] = cr.x[position[p]];
+    }
+    for (const auto& ip : pc.implied) {
+        vector<pair<DdNode*, long long>> terms;
+        for (const auto& term : ip.terms) {
+            terms.push_back({cr.x[position[term.first]], term.second});
+        }
+        map<pair<size_t, long long>, DdNode*> memo;
+        marked[ip.place] =
+            linearEquals(mgr, terms, 0, ip.constant - ip.divisor, memo);
+        for (auto& entry : memo) Cudd_RecursiveDeref(mgr, entry.second);
     }
 
-    DdNode* post_xprime = Cudd_bddExistAbstract(mgr, trans, cube);
-    Cudd_Ref(post_xprime);
-    Cudd_RecursiveDeref(mgr, trans);
-    Cudd_RecursiveDeref(mgr, cube);
+    // Per transition: guard, cube of the kept places it changes and their
+    // values after firing. Image = (exists changed. R & guard) & values,
+    // no next-state variables needed.
+    vector<DdNode*> guard(T), changed(T), values(T);
+    for (int t = 0; t < T; ++t) {
+        guard[t] = Cudd_ReadOne(mgr);
+        changed[t] = Cudd_ReadOne(mgr);
+        values[t] = Cudd_ReadOne(mgr);
+        Cudd_Ref(guard[t]);
+        Cudd_Ref(changed[t]);
+        Cudd_Ref(values[t]);
+        for (int p = 0; p < P; ++p) {
+            int c = C[p][t];
+            if (c == 0) continue;
+            auto conjoin = [&](DdNode*& acc, DdNode* f) {
+                DdNode* tmp = Cudd_bddAnd(mgr, acc, f);
+                Cudd_Ref(tmp);
+                Cudd_RecursiveDeref(mgr, acc);
+                acc = tmp;
+            };
+            if (c < 0) conjoin(guard[t], marked[p]);
+            if (position[p] >= 0) {
+                DdNode* v = cr.x[position[p]];
+                conjoin(changed[t], v);
+                conjoin(values[t], c > 0 ? v : Cudd_Not(v));
+            }
+        }
+    }
+    for (const auto& ip : pc.implied) {
+        Cudd_RecursiveDeref(mgr, marked[ip.place]);
+    }
 
-    // 5) Đổi tên x' -> x để kết quả quay về không gian biến x
-    vector<DdNode*> from(P), to(P);
-    for (int i = 0; i < P; ++i) {
-        from[i] = x_next[i];
-        to[i] = x[i];
+    DdNode* R = make_marking(mgr, cr.x.data(),
+                             pc.compress(net.initialMarking), K);
+    DdNode* frontier = R;
+    Cudd_Ref(frontier);
+    while (frontier != Cudd_ReadLogicZero(mgr)) {
+        DdNode* image = Cudd_ReadLogicZero(mgr);
+        Cudd_Ref(image);
+        for (int t = 0; t < T; ++t) {
+            DdNode* pre = Cudd_bddAndAbstract(mgr, frontier, guard[t],
+                                              changed[t]);
+            Cudd_Ref(pre);
+            DdNode* post = Cudd_bddAnd(mgr, pre, values[t]);
+            Cudd_Ref(post);
+            Cudd_RecursiveDeref(mgr, pre);
+            DdNode* tmp = Cudd_bddOr(mgr, image, post);
+            Cudd_Ref(tmp);
+            Cudd_RecursiveDeref(mgr, image);
+            Cudd_RecursiveDeref(mgr, post);
+            image = tmp;
+        }
+        Cudd_RecursiveDeref(mgr, frontier);
+        frontier = Cudd_bddAnd(mgr, image, Cudd_Not(R));
+        Cudd_Ref(frontier);
+        Cudd_RecursiveDeref(mgr, image);
+
+        DdNode* tmp = Cudd_bddOr(mgr, R, frontier);
+        Cudd_Ref(tmp);
+        Cudd_RecursiveDeref(mgr, R);
+        R = tmp;
+    }
+    Cudd_RecursiveDeref(mgr, frontier);
+    for (int t = 0; t < T; ++t) {
+        Cudd_RecursiveDeref(mgr, guard[t]);
+        Cudd_RecursiveDeref(mgr, changed[t]);
+        Cudd_RecursiveDeref(mgr, values[t]);
     }
 
-    DdNode* post =
-        Cudd_bddSwapVariables(mgr, post_xprime, from.data(), to.data(), P);
-    Cudd_Ref(post);
+    cr.R = R;
+    cout << "\n--- Task 3 Results (Symbolic Reachability, " << K
+         << " of " << P << " places as BDD variables) ---" << endl;
+    cout << "Number of reachable markings (BDD): "
+         << Cudd_CountMinterm(mgr, R, K) << endl;
+    PROFILE_CUDD(mgr);
+    return cr;
+}
 
-    Cudd_RecursiveDeref(mgr, post_xprime);
+void freeCompressedReachable(CompressedReachable& cr) {
+    if (cr.mgr == nullptr) return;
+    Cudd_RecursiveDeref(cr.mgr, cr.R);
+    for (auto v : cr.x) Cudd_RecursiveDeref(cr.mgr, v);
+    Cudd_Quit(cr.mgr);
+    cr = CompressedReachable();
+}
 
-    return post;
+DdNode* valueAtLeast(DdManager* mgr, const vector<int>& bits, long long k) {
+    int n = static_cast<int>(bits.size());
+    if (k <= 0 || n >= 62 || k >= (1LL << n)) {
+        DdNode* leaf = (k <= 0) ? Cudd_ReadOne(mgr) : Cudd_ReadLogicZero(mgr);
+        Cudd_Ref(leaf);
+        return leaf;
+    }
+    // from the least significant bit up: res = (value mod 2^(i+1)) >= k
+    // restricted to those bits
+    DdNode* res = (k & 1) ? Cudd_bddIthVar(mgr, bits[0]) : Cudd_ReadOne(mgr);
+    Cudd_Ref(res);
+    for (int i = 1; i < n; ++i) {
+        DdNode* v = Cudd_bddIthVar(mgr, bits[i]);
+        DdNode* tmp = ((k >> i) & 1) ? Cudd_bddAnd(mgr, v, res)
+                                     : Cudd_bddOr(mgr, v, res);
+        Cudd_Ref(tmp);
+        Cudd_RecursiveDeref(mgr, res);
+        res = tmp;
+    }
+    return res;
 }
 
-DdNode* symbolicReachability(const PetriNet& net) {
+// Bit functions of value(bits) + d mod 2^n (ripple carry), Ref'd
+static vector<DdNode*> addConstant(DdManager* mgr, const vector<int>& bits,
+                                   long long d) {
+    vector<DdNode*> sum(bits.size());
+    DdNode* carry = Cudd_ReadLogicZero(mgr);
+    Cudd_Ref(carry);
+    for (size_t i = 0; i < bits.size(); ++i) {
+        DdNode* v = Cudd_bddIthVar(mgr, bits[i]);
+        bool one = (d >> i) & 1;
+        sum[i] = one ? Cudd_bddXnor(mgr, v, carry) : Cudd_bddXor(mgr, v, carry);
+        Cudd_Ref(sum[i]);
+        DdNode* next =
+            one ? Cudd_bddOr(mgr, v, carry) : Cudd_bddAnd(mgr, v, carry);
+        Cudd_Ref(next);
+        Cudd_RecursiveDeref(mgr, carry);
+        carry = next;
+    }
+    Cudd_RecursiveDeref(mgr, carry);
+    return sum;
+}
+
+PlaceEncoding oneBitEncoding(int P) {
+    PlaceEncoding enc;
+    enc.bits.resize(P);
+    for (int p = 0; p < P; ++p) enc.bits[p] = {p};
+    return enc;
+}
+
+TransitionRelations buildTransitionRelations(DdManager* mgr,
+                                             const PetriNet& net,
+                                             const PlaceEncoding& enc,
+                                             bool safe) {
+    PROFILE_SCOPE("buildTransitionRelations");
     int P = static_cast<int>(net.places.size());
     int T = static_cast<int>(net.transitions.size());
-
     const vector<vector<int>>& C = net.incidenceMatrix;
-
-    DdManager* mgr = Cudd_Init(0, 0, CUDD_UNIQUE_SLOTS, CUDD_CACHE_SLOTS, 0);
-
-    // Tạo biến trạng thái hiện tại x[0..P-1] và biến trạng thái tiếp theo
-    // x_next[0..P-1]
-    vector<DdNode*> x(P), x_next(P);
-    for (int i = 0; i < P; ++i) {
-        DdNode* v = Cudd_bddNewVar(mgr);
+    int size = Cudd_ReadSize(mgr);
+
+    TransitionRelations tr;
+    tr.mgr = mgr;
+    tr.enc = enc;
+    tr.safe = safe;
+    for (const auto& b : enc.bits) tr.nvars += static_cast<int>(b.size());
+
+    auto one = [&]() {
+        DdNode* f = Cudd_ReadOne(mgr);
+        Cudd_Ref(f);
+        return f;
+    };
+    auto conjoin = [&](DdNode*& acc, DdNode* f) {  // consumes f
+        DdNode* tmp = Cudd_bddAnd(mgr, acc, f);
+        Cudd_Ref(tmp);
+        Cudd_RecursiveDeref(mgr, acc);
+        Cudd_RecursiveDeref(mgr, f);
+        acc = tmp;
+    };
+    auto variable = [&](int index) {
+        DdNode* v = Cudd_bddIthVar(mgr, index);
         Cudd_Ref(v);
-        x[i] = v;
+        return v;
+    };
+
+    tr.guard.resize(T);
+    if (safe) {
+        tr.changed.resize(T);
+        tr.values.resize(T);
+    } else {
+        tr.range.resize(T);
+        tr.fires.resize(T);
+        tr.backward.resize(T);
+        tr.forward.resize(T);
     }
-    for (int i = 0; i < P; ++i) {
-        DdNode* v = Cudd_bddNewVar(mgr);
-        Cudd_Ref(v);
-        x_next[i] = v;
+    for (int t = 0; t < T; ++t) {
+        tr.guard[t] = one();
+        if (safe) {
+            tr.changed[t] = one();
+            tr.values[t] = one();
+            for (int p = 0; p < P; ++p) {
+                int c = C[p][t];
+                if (c == 0) continue;
+                int v = enc.bits[p][0];
+                if (c < 0) conjoin(tr.guard[t], variable(v));
+                conjoin(tr.changed[t], variable(v));
+                conjoin(tr.values[t],
+                        c > 0 ? variable(v) : Cudd_Not(variable(v)));
+            }
+            continue;
+        }
+        tr.range[t] = one();
+        tr.fires[t] = one();
+        tr.backward[t].resize(size);
+        tr.forward[t].resize(size);
+        for (int v = 0; v < size; ++v) {
+            tr.backward[t][v] = variable(v);
+            tr.forward[t][v] = variable(v);
+        }
+        for (int p = 0; p < P; ++p) {
+            int c = C[p][t];
+            if (c == 0) continue;
+            const vector<int>& bits = enc.bits[p];
+            long long modulus = 1LL << bits.size();
+            if (c < 0) conjoin(tr.guard[t], valueAtLeast(mgr, bits, -c));
+            if (c > 0) {
+                conjoin(tr.range[t], valueAtLeast(mgr, bits, c));
+                conjoin(tr.fires[t],
+                        Cudd_Not(valueAtLeast(mgr, bits, modulus - c)));
+            } else {
+                conjoin(tr.range[t],
+                        Cudd_Not(valueAtLeast(mgr, bits, modulus + c)));
+            }
+            long long up = (c % modulus + modulus) % modulus;
+            vector<DdNode*> back = addConstant(mgr, bits, modulus - up);
+            vector<DdNode*> ahead = addConstant(mgr, bits, up);
+            for (size_t i = 0; i < bits.size(); ++i) {
+                Cudd_RecursiveDeref(mgr, tr.backward[t][bits[i]]);
+                Cudd_RecursiveDeref(mgr, tr.forward[t][bits[i]]);
+                tr.backward[t][bits[i]] = back[i];
+                tr.forward[t][bits[i]] = ahead[i];
+            }
+        }
+        Cudd_Ref(tr.guard[t]);
+        conjoin(tr.fires[t], tr.guard[t]);
     }
+    return tr;
+}
 
-    // R ban đầu = {M0}
-    DdNode* R = make_marking(mgr, x.data(), net.initialMarking, P);
-    // make_marking đã Cudd_Ref nên ở đây KHÔNG cần Cudd_Ref(R) nữa
-
-    bool changed = true;
+void freeTransitionRelations(TransitionRelations& tr) {
+    if (tr.mgr == nullptr) return;
+    DdManager* mgr = tr.mgr;
+    for (auto* list : {&tr.guard, &tr.changed, &tr.values, &tr.range,
+                       &tr.fires}) {
+        for (DdNode* f : *list) Cudd_RecursiveDeref(mgr, f);
+    }
+    for (auto* vectors : {&tr.backward, &tr.forward}) {
+        for (const auto& v : *vectors) {
+            for (DdNode* f : v) Cudd_RecursiveDeref(mgr, f);
+        }
+    }
+    tr = TransitionRelations();
+}
 
-    while (changed) {
-        changed = false;
+// f Ref'd, unless an operation gave up under a manager limit (budget.h)
+static DdNode* refOrNull(DdNode* f) {
+    if (f) Cudd_Ref(f);
+    return f;
+}
 
-        // newStates = 0
-        DdNode* newStates = Cudd_ReadLogicZero(mgr);
-        Cudd_Ref(newStates);
+DdNode* postImage(const TransitionRelations& tr, DdNode* S, int t) {
+    DdManager* mgr = tr.mgr;
+    if (tr.safe) {
+        DdNode* pre = refOrNull(
+            Cudd_bddAndAbstract(mgr, S, tr.guard[t], tr.changed[t]));
+        if (!pre) return nullptr;
+        DdNode* post = refOrNull(Cudd_bddAnd(mgr, pre, tr.values[t]));
+        Cudd_RecursiveDeref(mgr, pre);
+        return post;
+    }
+    DdNode* pre = refOrNull(Cudd_bddAnd(mgr, S, tr.guard[t]));
+    if (!pre) return nullptr;
+    DdNode* shifted = refOrNull(Cudd_bddVectorCompose(
+        mgr, pre, const_cast<DdNode**>(tr.backward[t].data())));
+    Cudd_RecursiveDeref(mgr, pre);
+    if (!shifted) return nullptr;
+    DdNode* post = refOrNull(Cudd_bddAnd(mgr, shifted, tr.range[t]));
+    Cudd_RecursiveDeref(mgr, shifted);
+    return post;
+}
 
-        // Hợp post_t(R) cho mọi transition
-        for (int t = 0; t < T; ++t) {
-            DdNode* post =
-                compute_post(mgr, R, C, t, x, x_next);  // đã Ref bên trong
-            DdNode* tmp = Cudd_bddOr(mgr, newStates, post);
-            Cudd_Ref(tmp);
-            Cudd_RecursiveDeref(mgr, newStates);
-            newStates = tmp;
-            Cudd_RecursiveDeref(mgr, post);
-        }
+DdNode* preImage(const TransitionRelations& tr, DdNode* S, int t) {
+    DdManager* mgr = tr.mgr;
+    DdNode* moved =
+        tr.safe ? Cudd_bddAndAbstract(mgr, S, tr.values[t], tr.changed[t])
+                : Cudd_bddVectorCompose(
+                      mgr, S, const_cast<DdNode**>(tr.forward[t].data()));
+    Cudd_Ref(moved);
+    DdNode* pre =
+        Cudd_bddAnd(mgr, moved, tr.safe ? tr.guard[t] : tr.fires[t]);
+    Cudd_Ref(pre);
+    Cudd_RecursiveDeref(mgr, moved);
+    return pre;
+}
 
-        // diff = newStates & !R  (các marking thực sự mới)
-        DdNode* notR = Cudd_Not(R);  // không cần Ref
-        DdNode* diff = Cudd_bddAnd(mgr, newStates, notR);
-        Cudd_Ref(diff);
+// Successors of frontier outside R, Ref'd; NULL under a manager limit
+static DdNode* newStates(const TransitionRelations& tr, DdNode* frontier,
+                         DdNode* R) {
+    DdManager* mgr = tr.mgr;
+    DdNode* image = Cudd_ReadLogicZero(mgr);
+    Cudd_Ref(image);
+    for (int t = 0; t < (int)tr.guard.size() && image; ++t) {
+        DdNode* post = postImage(tr, frontier, t);
+        DdNode* tmp = post ? refOrNull(Cudd_bddOr(mgr, image, post)) : nullptr;
+        Cudd_RecursiveDeref(mgr, image);
+        if (post) Cudd_RecursiveDeref(mgr, post);
+        image = tmp;
+    }
+    if (!image) return nullptr;
+    DdNode* fresh = refOrNull(Cudd_bddAnd(mgr, image, Cudd_Not(R)));
+    Cudd_RecursiveDeref(mgr, image);
+    return fresh;
+}
 
-        if (diff != Cudd_ReadLogicZero(mgr)) {
-            changed = true;
-            DdNode* tmp = Cudd_bddOr(mgr, R, diff);
-            Cudd_Ref(tmp);
-            Cudd_RecursiveDeref(mgr, R);
-            R = tmp;
+DdNode* forwardClosure(const TransitionRelations& tr, DdNode* S,
+                       const CheckpointOptions* checkpoint,
+                       CheckpointStats* stats, BudgetMonitor* budget) {
+    using Clock = chrono::steady_clock;
+    auto msSince = [](Clock::time_point t) {
+        return chrono::duration<double, milli>(Clock::now() - t).count();
+    };
+    auto start = Clock::now();
+    DdManager* mgr = tr.mgr;
+    DdNode* R = nullptr;
+    DdNode* frontier = nullptr;
+    uint32_t iteration = 0;
+
+    // the relations take part in the fingerprint: another encoding of the
+    // same net numbers the variables differently
+    string path;
+    uint64_t fingerprint = 0;
+    CheckpointStats local;
+    CheckpointStats& st = stats ? *stats : local;
+    if (checkpoint) {
+        st = CheckpointStats();
+        path = checkpoint->path + ".bdd";
+        fingerprint = checkpoint->fingerprint ^ (tr.safe ? 1 : 2);
+        for (const auto& bits : tr.enc.bits)
+            fingerprint = fingerprint * 0x100000001b3ULL + bits.size();
+        st.resumed = readBddSnapshot(path, fingerprint, mgr, tr.nvars, R,
+                                     frontier, iteration);
+        st.resumedAt = iteration;
+        if (st.resumed) st.bytes = filesystem::file_size(path);
+    }
+    if (!st.resumed) {
+        R = S;
+        Cudd_Ref(R);
+        frontier = S;
+        Cudd_Ref(frontier);
+    }
+    auto snapshot = [&] {
+        auto begin = Clock::now();
+        size_t bytes = writeBddSnapshot(path, fingerprint, tr.nvars, R,
+                                        frontier, iteration);
+        if (bytes > 0) st.bytes = bytes;
+        st.writes++;
+        st.writeMs += msSince(begin);
+    };
+    auto last = Clock::now();
+    bool saved = st.resumed;  // the file holds the current state
+    // an iteration given up under the budget leaves R and the frontier of
+    // the previous one
+    if (budget) budget->limit(mgr);
+    while (frontier != Cudd_ReadLogicZero(mgr)) {
+        if (budget && budget->exhausted()) break;
+        DdNode* fresh = newStates(tr, frontier, R);
+        DdNode* tmp = fresh ? refOrNull(Cudd_bddOr(mgr, R, fresh)) : nullptr;
+        if (!tmp) {
+            if (fresh) Cudd_RecursiveDeref(mgr, fresh);
+            break;
+        }
+        Cudd_RecursiveDeref(mgr, R);
+        R = tmp;
+        Cudd_RecursiveDeref(mgr, frontier);
+        frontier = fresh;
+        ++iteration;
+        saved = false;
+        if (checkpoint && msSince(last) >= checkpoint->seconds * 1000) {
+            snapshot();
+            saved = true;
+            last = Clock::now();
         }
-
-        Cudd_RecursiveDeref(mgr, newStates);
-        Cudd_RecursiveDeref(mgr, diff);
     }
-
-    cout << "\n--- Task 3 Results (Symbolic Reachability with BDDs) ---"
-         << endl;
-    double num = Cudd_CountMinterm(mgr, R, P);  // R chỉ phụ thuộc vào P biến x
-    cout << "Number of reachable markings (BDD): " << num << endl;
-
+    if (budget) {
+        budget->release(mgr);
+        if (budget->stopped()) {
+            budget->progress(iteration,
+                             Cudd_CountMinterm(mgr, frontier, tr.nvars));
+        }
+    }
+    if (checkpoint && !saved) snapshot();
+    st.runMs = msSince(start);
+    Cudd_RecursiveDeref(mgr, frontier);
     return R;
 }
 
-DdNode* make_marking(DdManager* mgr, DdNode** x, const std::vector<int>& bits,
-                     int n) {
+DdNode* markingBDD(DdManager* mgr, const PlaceEncoding& enc, const Marking& M) {
     DdNode* res = Cudd_ReadOne(mgr);
     Cudd_Ref(res);
-    for (int i = 0; i < n; ++i) {
-        DdNode* lit = bits[i] ? x[i] : Cudd_Not(x[i]);
-        DdNode* tmp = Cudd_bddAnd(mgr, res, lit);
-        Cudd_Ref(tmp);
-        Cudd_RecursiveDeref(mgr, res);
-        res = tmp;
+    for (size_t p = 0; p < enc.bits.size(); ++p) {
+        for (size_t i = 0; i < enc.bits[p].size(); ++i) {
+            DdNode* v = Cudd_bddIthVar(mgr, enc.bits[p][i]);
+            DdNode* lit = ((M[p] >> i) & 1) ? v : Cudd_Not(v);
+            DdNode* tmp = Cudd_bddAnd(mgr, res, lit);
+            Cudd_Ref(tmp);
+            Cudd_RecursiveDeref(mgr, res);
+            res = tmp;
+        }
     }
-
     return res;
 }
+
+EncodedReachable symbolicReachability(const PetriNet& net,
+                                      const PlaceEncoding& enc,
+                                      const CheckpointOptions* checkpoint,
+                                      CheckpointStats* stats,
+                                      BudgetMonitor* budget) {
+    PROFILE_SCOPE("symbolicReachabilityEncoded");
+    int P = static_cast<int>(net.places.size());
+
+    EncodedReachable er;
+    er.enc = enc;
+    for (const auto& b : enc.bits) er.nvars += static_cast<int>(b.size());
+    er.mgr = Cudd_Init(er.nvars, 0, CUDD_UNIQUE_SLOTS, CUDD_CACHE_SLOTS, 0);
+    DdManager* mgr = er.mgr;
+    int nvars = er.nvars;
+
+    TransitionRelations tr = buildTransitionRelations(mgr, net, enc, false);
+    DdNode* M0 = markingBDD(mgr, enc, net.initialMarking);
+    CheckpointOptions cp;
+    if (checkpoint) {
+        cp = *checkpoint;
+        cp.fingerprint = netFingerprint(net);
+    }
+    DdNode* R =
+        forwardClosure(tr, M0, checkpoint ? &cp : nullptr, stats, budget);
+    Cudd_RecursiveDeref(mgr, M0);
+    freeTransitionRelations(tr);
+
+    er.R = R;
+    cout << "\n--- Task 3 Results (Symbolic Reachability, " << nvars
+         << " BDD variables for " << P << " places) ---" << endl;
+    cout << "Number of reachable markings (BDD): "
+         << Cudd_CountMinterm(mgr, R, nvars) << endl;
+    PROFILE_CUDD(mgr);
+    return er;
+}
+
+void freeEncodedReachable(EncodedReachable& er) {
+    if (er.mgr == nullptr) return;
+    Cudd_RecursiveDeref(er.mgr, er.R);
+    Cudd_Quit(er.mgr);
+    er = EncodedReachable();
+}
+
+Marking decodeMarking(const PlaceEncoding& enc, const vector<char>& cube) {
+    Marking m(enc.bits.size(), 0);
+    for (size_t p = 0; p < enc.bits.size(); ++p) {
+        for (size_t i = 0; i < enc.bits[p].size(); ++i) {
+            if (cube[enc.bits[p][i]] == 1) m[p] |= 1 << i;
+        }
+    }
+    return m;
+}
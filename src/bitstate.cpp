@@ -0,0 +1,125 @@
+#include "bitstate.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "profiler.h"
+#include "simulation.h"
+
+using namespace std;
+
+namespace {
+
+uint64_t hashMarking(const int* m, int places) {
+    uint64_t h = 0x9e3779b97f4a7c15ull;
+    for (int p = 0; p < places; ++p) {
+        h ^= static_cast<uint32_t>(m[p]);
+        h *= 0xbf58476d1ce4e5b9ull;
+        h ^= h >> 31;
+    }
+    h ^= h >> 29;
+    h *= 0x94d049bb133111ebull;
+    return h ^ (h >> 32);
+}
+
+class BitTable {
+   public:
+    BitTable(int log2Bits, int hashes)
+        : words_((size_t(1) << log2Bits) / 64 + 1),
+          mask_((uint64_t(1) << log2Bits) - 1),
+          hashes_(hashes) {}
+
+    // Sets the bits of h; true when some of them were clear (new marking).
+    // Probe i is h1 + i * h2 (double hashing).
+    bool insert(uint64_t h) {
+        uint64_t h1 = h, h2 = (h >> 32 | h << 32) | 1;
+        bool fresh = false;
+        for (int i = 0; i < hashes_; ++i) {
+            uint64_t bit = (h1 + i * h2) & mask_;
+            uint64_t& word = words_[bit >> 6];
+            uint64_t b = uint64_t(1) << (bit & 63);
+            if (!(word & b)) {
+                word |= b;
+                fresh = true;
+            }
+        }
+        return fresh;
+    }
+    double bits() const { return double(mask_) + 1; }
+
+   private:
+    vector<uint64_t> words_;
+    uint64_t mask_;
+    int hashes_;
+};
+
+}  // namespace
+
+BitstateResult bitstateReachability(const PetriNet& net,
+                                    const BitstateOptions& opt,
+                                    BudgetMonitor* budget) {
+    PROFILE_SCOPE("bitstateReachability");
+    CompactNet cn = compactNet(net);
+    int P = cn.places;
+    int log2Bits = max(10, opt.log2Bits);
+    if (budget && budget->budget().memoryMB > 0) {
+        size_t bits = budget->budget().memoryMB << 22;  // half, in bits
+        while (log2Bits > 10 && (size_t(1) << log2Bits) > bits) --log2Bits;
+    }
+    BitTable table(log2Bits, max(1, opt.hashes));
+    BitstateResult result;
+
+    // DFS stack: the tokens of frame d at d * P, the next transition to
+    // try, whether one was enabled, and the transition that led to d + 1
+    vector<int> tokens(cn.initial.begin(), cn.initial.end());
+    vector<int> next(1, 0), via;
+    vector<char> enabledSeen(1, 0);
+    table.insert(hashMarking(tokens.data(), P));
+    result.states = 1;
+    vector<int> scratch(P);
+
+    auto enabled = [&](const int* m, int t) {
+        for (int i = cn.preStart[t]; i < cn.preStart[t + 1]; ++i)
+            if (m[cn.prePlace[i]] < cn.preWeight[i]) return false;
+        return true;
+    };
+
+    size_t steps = 0;
+    while (!next.empty()) {
+        if (budget && (++steps & 1023) == 0 && budget->exhausted()) {
+            budget->progress(result.states, double(next.size()));
+            break;
+        }
+        size_t d = next.size() - 1;
+        const int* m = tokens.data() + d * P;
+        int t = next[d];
+        while (t < cn.transitions && !enabled(m, t)) ++t;
+        if (t == cn.transitions) {
+            if (!enabledSeen[d] && !result.deadlockFound) {
+                result.deadlockFound = true;
+                result.deadMarking.assign(m, m + P);
+                result.trace = via;
+            }
+            next.pop_back();
+            enabledSeen.pop_back();
+            tokens.resize(d * P);
+            if (!via.empty()) via.pop_back();
+            continue;
+        }
+        next[d] = t + 1;
+        enabledSeen[d] = 1;
+        copy(m, m + P, scratch.begin());
+        for (int i = cn.deltaStart[t]; i < cn.deltaStart[t + 1]; ++i)
+            scratch[cn.deltaPlace[i]] += cn.deltaValue[i];
+        if (!table.insert(hashMarking(scratch.data(), P))) continue;
+        ++result.states;
+        tokens.insert(tokens.end(), scratch.begin(), scratch.end());
+        next.push_back(0);
+        enabledSeen.push_back(0);
+        via.push_back(t);
+        result.maxDepth = max(result.maxDepth, next.size() - 1);
+    }
+    result.complete = next.empty();
+    result.hashFactor = table.bits() / result.states;
+    return result;
+}
@@ -0,0 +1,255 @@
+#include "bounds.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <numeric>
+#include <queue>
+#include <unordered_map>
+
+#include "coverability.h"
+#include "invariants.h"
+#include "profiler.h"
+#include "reachability.h"
+#include "simplex.h"
+
+using namespace std;
+
+bool PlaceBounds::oneSafe() const {
+    for (long long b : bound) {
+        if (b < 0 || b > 1) return false;
+    }
+    return true;
+}
+
+bool PlaceBounds::allBounded() const {
+    for (long long b : bound) {
+        if (b < 0) return false;
+    }
+    return true;
+}
+
+long long PlaceBounds::maxBound() const {
+    long long m = 0;
+    for (long long b : bound) {
+        if (b < 0) return -1;
+        m = max(m, b);
+    }
+    return m;
+}
+
+namespace {
+
+// Adds multiples of the semi-positive vectors to w until no entry is
+// negative; false when some negative entry is covered by none of them or
+// the coefficients would overflow
+bool cancelNegatives(vector<long long>& w,
+                     const vector<vector<long long>>& positive) {
+    const long long LIMIT = LLONG_MAX / 4;
+    for (size_t q = 0; q < w.size(); ++q) {
+        if (w[q] >= 0) continue;
+        auto u = find_if(positive.begin(), positive.end(),
+                         [&](const vector<long long>& y) { return y[q] > 0; });
+        if (u == positive.end()) return false;
+        // w := u[q] w + |w[q]| u, which clears w[q], over the gcd
+        long long a = (*u)[q], b = -w[q], g = 0;
+        for (size_t r = 0; r < w.size(); ++r) {
+            if (llabs(w[r]) > LIMIT / a || (*u)[r] > LIMIT / b) return false;
+            w[r] = a * w[r] + b * (*u)[r];
+            g = gcd(g, llabs(w[r]));
+        }
+        if (g > 1) {
+            for (auto& c : w) c /= g;
+        }
+    }
+    return true;
+}
+
+// M(p) <= y . M0 / y(p) for every semi-positive P-invariant y; -1 where
+// none covers p. The basis vectors are used as they are or negated, and a
+// mixed one once its negative entries are cancelled by adding multiples of
+// the semi-positive ones (token ring: sum idle - sum token plus every
+// idle + crit gives sum token + sum crit).
+vector<long long> invariantBounds(const PetriNet& net) {
+    int P = static_cast<int>(net.places.size());
+    vector<vector<long long>> positive, mixed;
+    for (const SparseVector& y : pInvariantBasis(net.incidenceMatrix).vectors) {
+        vector<long long> v(P, 0);
+        bool pos = true, neg = true;
+        for (const auto& e : y) {
+            v[e.first] = e.second;
+            pos &= e.second > 0;
+            neg &= e.second < 0;
+        }
+        if (neg) {
+            for (auto& c : v) c = -c;
+        }
+        (pos || neg ? positive : mixed).push_back(v);
+    }
+    for (const auto& v : mixed) {
+        for (int sign : {1, -1}) {
+            vector<long long> w = v;
+            for (auto& c : w) c *= sign;
+            if (cancelNegatives(w, positive)) {
+                positive.push_back(w);
+                break;
+            }
+        }
+    }
+
+    vector<long long> bound(P, -1);
+    for (const auto& y : positive) {
+        long long total = 0;
+        for (int p = 0; p < P; ++p) total += y[p] * net.initialMarking[p];
+        for (int p = 0; p < P; ++p) {
+            if (y[p] <= 0) continue;
+            long long b = total / y[p];
+            if (bound[p] < 0 || b < bound[p]) bound[p] = b;
+        }
+    }
+    return bound;
+}
+
+// max M0(p) + C[p] . sigma  s.t.  -C sigma <= M0,  sigma >= 0
+long long stateEquationBound(const PetriNet& net, int p) {
+    int P = static_cast<int>(net.places.size());
+    int T = static_cast<int>(net.transitions.size());
+    LinearProgram lp;
+    lp.A.assign(P, vector<double>(T));
+    lp.b.resize(P);
+    lp.sense.assign(P, '<');
+    lp.c.resize(T);
+    for (int q = 0; q < P; ++q) {
+        for (int t = 0; t < T; ++t) lp.A[q][t] = -net.incidenceMatrix[q][t];
+        lp.b[q] = net.initialMarking[q];
+    }
+    for (int t = 0; t < T; ++t) lp.c[t] = net.incidenceMatrix[p][t];
+
+    LPResult r = solveLP(lp);
+    if (r.status != LPResult::Optimal) return -1;
+    return net.initialMarking[p] + static_cast<long long>(floor(r.value + 1e-7));
+}
+
+struct MarkingHash {
+    size_t operator()(const Marking& M) const {
+        size_t h = 1469598103934665603ull;
+        for (int v : M) h = (h ^ static_cast<size_t>(v)) * 1099511628211ull;
+        return h;
+    }
+};
+
+// BFS keeping parents; true if it finished within cap
+bool sweep(const PetriNet& net, size_t cap, PlaceBounds& b,
+           vector<long long>& seenMax) {
+    int P = static_cast<int>(net.places.size());
+    int T = static_cast<int>(net.transitions.size());
+    vector<Marking> states = {net.initialMarking};
+    vector<int> parent = {-1};
+    unordered_map<Marking, int, MarkingHash> index = {{net.initialMarking, 0}};
+    seenMax.assign(net.initialMarking.begin(), net.initialMarking.end());
+
+    for (size_t i = 0; i < states.size(); ++i) {
+        for (int t = 0; t < T; ++t) {
+            if (!is_enabled(states[i], t, net)) continue;
+            Marking next = fire_transition(states[i], t, net);
+            if (index.count(next)) continue;
+            if (states.size() >= cap) return false;
+
+            // Karp-Miller argument: next >= ancestor, strictly somewhere,
+            // means the difference can be pumped forever.
+            for (int a = static_cast<int>(i); a >= 0; a = parent[a]) {
+                const Marking& old = states[a];
+                bool covers = true, strict = false;
+                for (int p = 0; p < P && covers; ++p) {
+                    covers = next[p] >= old[p];
+                    strict |= next[p] > old[p];
+                }
+                if (covers && strict) {
+                    for (int p = 0; p < P; ++p) {
+                        if (next[p] > old[p]) {
+                            b.unboundedPlace = p;
+                            b.bound[p] = -1;
+                            b.exact[p] = false;
+                        }
+                    }
+                    return false;
+                }
+            }
+
+            for (int p = 0; p < P; ++p) {
+                seenMax[p] = max<long long>(seenMax[p], next[p]);
+            }
+            index[next] = static_cast<int>(states.size());
+            states.push_back(next);
+            parent.push_back(static_cast<int>(i));
+        }
+    }
+    b.sweepStates = states.size();
+    return true;
+}
+
+}  // namespace
+
+PlaceBounds computePlaceBounds(const PetriNet& net, size_t sweepCap) {
+    PROFILE_SCOPE("computePlaceBounds");
+    int P = static_cast<int>(net.places.size());
+    PlaceBounds b;
+    b.bound = invariantBounds(net);
+    b.exact.assign(P, false);
+    for (int p = 0; p < P; ++p) {
+        // one LP per place the invariants leave open
+        if (b.bound[p] < 0) b.bound[p] = stateEquationBound(net, p);
+        b.exact[p] = b.bound[p] == net.initialMarking[p];
+    }
+    if (b.oneSafe()) return b;  // the cheapest encoding is already proved
+
+    vector<long long> seenMax;
+    b.sweepComplete = sweep(net, sweepCap, b, seenMax);
+    if (b.unboundedPlace >= 0) return b;
+    if (!b.sweepComplete) {
+        // too many markings to enumerate: the coverability set decides
+        // boundedness with far fewer nodes on most nets
+        CoverabilitySet cs = coverabilitySet(net, sweepCap);
+        b.coverabilityNodes = cs.nodes;
+        if (cs.complete) {
+            vector<long long> cover = cs.bounds();
+            for (int p = 0; p < P; ++p) {
+                if (cover[p] < 0 && b.unboundedPlace < 0) b.unboundedPlace = p;
+                b.bound[p] = cover[p];
+                b.exact[p] = cover[p] >= 0;
+            }
+            return b;
+        }
+    }
+    for (int p = 0; p < P; ++p) {
+        if (b.sweepComplete) {
+            b.bound[p] = seenMax[p];
+            b.exact[p] = true;
+        } else if (b.bound[p] == seenMax[p]) {
+            b.exact[p] = true;
+        }
+    }
+    if (!b.sweepComplete) b.sweepStates = sweepCap;
+    return b;
+}
+
+PlaceEncoding boundedEncoding(const PlaceBounds& bounds) {
+    PlaceEncoding enc;
+    int var = 0;
+    for (long long bound : bounds.bound) {
+        int bits = 1;
+        while ((1ll << bits) <= bound) ++bits;
+        vector<int> vars(bits);
+        for (int i = 0; i < bits; ++i) vars[i] = var++;
+        enc.bits.push_back(vars);
+    }
+    return enc;
+}
+
+int markingWidth(const PlaceBounds& bounds) {
+    long long m = bounds.maxBound();
+    if (m >= 0 && m <= 0xff) return 1;
+    if (m >= 0 && m <= 0xffff) return 2;
+    return 4;
+}
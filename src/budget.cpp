@@ -0,0 +1,84 @@
+#include "budget.h"
+
+#include <algorithm>
+#include <fstream>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+size_t residentBytes() {
+#ifndef _WIN32
+    ifstream statm("/proc/self/statm");
+    size_t size = 0, resident = 0;
+    if (statm >> size >> resident) return resident * sysconf(_SC_PAGE_SIZE);
+#endif
+    return 0;
+}
+
+BudgetMonitor::BudgetMonitor(const Budget& budget)
+    : budget_(budget), start_(chrono::steady_clock::now()) {}
+
+double BudgetMonitor::elapsedSeconds() const {
+    return chrono::duration<double>(chrono::steady_clock::now() - start_)
+        .count();
+}
+
+Budget BudgetMonitor::left() const {
+    Budget rest = budget_;
+    if (budget_.seconds > 0)
+        rest.seconds = max(1e-3, budget_.seconds - elapsedSeconds());
+    return rest;
+}
+
+bool BudgetMonitor::exhausted() {
+    if (stopped_) return true;
+    if (budget_.seconds > 0 && elapsedSeconds() >= budget_.seconds) {
+        reason_ = "time";
+        return stopped_ = true;
+    }
+    if (budget_.memoryMB > 0 && residentBytes() >= budget_.memoryMB << 20) {
+        reason_ = "memory";
+        return stopped_ = true;
+    }
+    return false;
+}
+
+void BudgetMonitor::limit(DdManager* mgr) const {
+    if (budget_.seconds > 0) {
+        double left = budget_.seconds - elapsedSeconds();
+        Cudd_ResetStartTime(mgr);
+        Cudd_SetTimeLimit(mgr, left > 0 ? (unsigned long)(left * 1000) : 0);
+    }
+    if (budget_.memoryMB > 0) {
+        // CUDD counts its own allocations only, so the rest of the process
+        // comes off the budget
+        size_t cap = budget_.memoryMB << 20;
+        size_t rss = residentBytes();
+        size_t used = Cudd_ReadMemoryInUse(mgr);
+        size_t other = rss > used ? rss - used : 0;
+        Cudd_SetMaxMemory(mgr, cap > other ? cap - other : 0);
+    }
+    if (budget_.bddNodes > 0) Cudd_SetMaxLive(mgr, budget_.bddNodes);
+}
+
+void BudgetMonitor::release(DdManager* mgr) {
+    Cudd_ErrorType error = Cudd_ReadErrorCode(mgr);
+    if (!stopped_ && error != CUDD_NO_ERROR) {
+        stopped_ = true;
+        reason_ = error == CUDD_TIMEOUT_EXPIRED   ? "time"
+                  : error == CUDD_TOO_MANY_NODES ? "nodes"
+                                                 : "memory";
+    }
+    Cudd_ClearErrorCode(mgr);
+    Cudd_UnsetTimeLimit(mgr);
+    Cudd_SetMaxMemory(mgr, ~size_t(0));
+    Cudd_SetMaxLive(mgr, ~0u);
+}
+
+void BudgetMonitor::progress(size_t done, double frontier) {
+    done_ = done;
+    frontier_ = frontier;
+}
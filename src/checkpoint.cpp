@@ -0,0 +1,268 @@
+#include "checkpoint.h"
+
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+#include <unordered_map>
+
+using namespace std;
+
+namespace {
+
+const char STATE_MAGIC[4] = {'P', 'N', 'S', 'T'};
+const char BDD_MAGIC[4] = {'P', 'N', 'B', 'D'};
+const uint32_t VERSION = 1;
+const uint64_t BLOCK_TAG = 0x9e3779b97f4a7c15ULL;
+
+struct StateHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t fingerprint;
+    uint32_t places;
+    uint32_t unused;
+};
+
+struct BddHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t fingerprint;
+    uint32_t variables;
+    uint32_t iteration;
+    uint64_t nodes;
+};
+
+struct BddNodeRecord {
+    uint32_t variable;
+    uint32_t unused;
+    uint64_t then;
+    uint64_t otherwise;
+};
+
+void fnv(uint64_t& h, int64_t v) {
+    for (int i = 0; i < 8; ++i) {
+        h ^= (v >> (8 * i)) & 0xff;
+        h *= 0x100000001b3ULL;
+    }
+}
+
+template <typename T>
+bool readValue(ifstream& in, T& v) {
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&v), sizeof(T)));
+}
+
+template <typename T>
+void writeValue(ofstream& out, const T& v) {
+    out.write(reinterpret_cast<const char*>(&v), sizeof(T));
+}
+
+// Post-order numbering of the nodes under a root, see checkpoint.h
+class NodeTable {
+   public:
+    explicit NodeTable(ofstream& out) : out_(out) {}
+
+    uint64_t ref(DdNode* f) {
+        DdNode* node = Cudd_Regular(f);
+        uint64_t comp = Cudd_IsComplement(f) ? 1 : 0;
+        if (Cudd_IsConstant(node)) return comp;
+        auto it = ids_.find(node);
+        if (it != ids_.end()) return it->second << 1 | comp;
+        BddNodeRecord rec;
+        rec.then = ref(Cudd_T(node));
+        rec.otherwise = ref(Cudd_E(node));
+        rec.variable = Cudd_NodeReadIndex(node);
+        rec.unused = 0;
+        writeValue(out_, rec);
+        uint64_t id = ids_.size() + 1;
+        ids_.emplace(node, id);
+        return id << 1 | comp;
+    }
+    uint64_t nodes() const { return ids_.size(); }
+
+   private:
+    ofstream& out_;
+    unordered_map<DdNode*, uint64_t> ids_;
+};
+
+}  // namespace
+
+uint64_t netFingerprint(const PetriNet& net) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    fnv(h, net.places.size());
+    fnv(h, net.transitions.size());
+    for (const auto& row : net.incidenceMatrix)
+        for (int c : row) fnv(h, c);
+    for (int m : net.initialMarking) fnv(h, m);
+    return h;
+}
+
+bool loadStateLog(const string& path, uint64_t fingerprint, int places,
+                  StateLog& log) {
+    log = StateLog();
+    ifstream in(path, ios::binary);
+    StateHeader h;
+    if (!readValue(in, h)) return false;
+    if (memcmp(h.magic, STATE_MAGIC, 4) != 0 || h.version != VERSION ||
+        h.fingerprint != fingerprint || h.places != (uint32_t)places)
+        return false;
+
+    error_code ec;
+    uintmax_t size = filesystem::file_size(path, ec);
+    if (ec) return false;
+    uint64_t good = sizeof(h);
+    size_t perState = places * sizeof(int32_t) + 2 * sizeof(uint32_t);
+    vector<int32_t> row(places);
+    for (;;) {
+        uint64_t count, expanded, tag;
+        if (!readValue(in, count) || !readValue(in, expanded)) break;
+        uint64_t blockBytes = 3 * sizeof(uint64_t) + count * perState;
+        if (count > size || good + blockBytes > size) break;
+        size_t first = log.states.size();
+        for (uint64_t i = 0; i < count; ++i) {
+            in.read(reinterpret_cast<char*>(row.data()),
+                    places * sizeof(int32_t));
+            log.states.emplace_back(row.begin(), row.end());
+        }
+        log.parent.resize(first + count);
+        log.via.resize(first + count);
+        in.read(reinterpret_cast<char*>(log.parent.data() + first),
+                count * sizeof(uint32_t));
+        in.read(reinterpret_cast<char*>(log.via.data() + first),
+                count * sizeof(uint32_t));
+        if (!readValue(in, tag) || tag != (count ^ expanded ^ BLOCK_TAG) ||
+            expanded > log.states.size()) {
+            log.states.resize(first);
+            log.parent.resize(first);
+            log.via.resize(first);
+            break;
+        }
+        log.expanded = expanded;
+        good += blockBytes;
+    }
+    in.close();
+    if (good < size) filesystem::resize_file(path, good, ec);
+    return !ec && !log.states.empty();
+}
+
+bool StateLogWriter::open(const string& path, uint64_t fingerprint,
+                          int places, bool resume) {
+    places_ = places;
+    if (resume) {
+        out_.open(path, ios::binary | ios::app);
+        bytes_ = out_ ? static_cast<size_t>(filesystem::file_size(path)) : 0;
+        return static_cast<bool>(out_);
+    }
+    out_.open(path, ios::binary | ios::trunc);
+    StateHeader h;
+    memcpy(h.magic, STATE_MAGIC, 4);
+    h.version = VERSION;
+    h.fingerprint = fingerprint;
+    h.places = places;
+    h.unused = 0;
+    writeValue(out_, h);
+    out_.flush();
+    bytes_ = sizeof(h);
+    return static_cast<bool>(out_);
+}
+
+bool StateLogWriter::append(const vector<Marking>& states, size_t from,
+                            const vector<uint32_t>& parent,
+                            const vector<uint32_t>& via, size_t expanded) {
+    uint64_t count = states.size() - from;
+    uint64_t done = expanded;
+    writeValue(out_, count);
+    writeValue(out_, done);
+    vector<int32_t> block;
+    block.reserve(count * places_);
+    for (size_t i = from; i < states.size(); ++i)
+        block.insert(block.end(), states[i].begin(), states[i].end());
+    out_.write(reinterpret_cast<const char*>(block.data()),
+               block.size() * sizeof(int32_t));
+    out_.write(reinterpret_cast<const char*>(parent.data() + from),
+               count * sizeof(uint32_t));
+    out_.write(reinterpret_cast<const char*>(via.data() + from),
+               count * sizeof(uint32_t));
+    writeValue(out_, count ^ done ^ BLOCK_TAG);
+    out_.flush();
+    bytes_ += 3 * sizeof(uint64_t) + count * (places_ * sizeof(int32_t) +
+                                              2 * sizeof(uint32_t));
+    return static_cast<bool>(out_);
+}
+
+size_t writeBddSnapshot(const string& path, uint64_t fingerprint,
+                        int variables, DdNode* R, DdNode* frontier,
+                        uint32_t iteration) {
+    string tmp = path + ".tmp";
+    size_t bytes;
+    {
+        ofstream out(tmp, ios::binary | ios::trunc);
+        if (!out) return 0;
+        BddHeader h;
+        memcpy(h.magic, BDD_MAGIC, 4);
+        h.version = VERSION;
+        h.fingerprint = fingerprint;
+        h.variables = variables;
+        h.iteration = iteration;
+        h.nodes = 0;
+        writeValue(out, h);  // node count patched below
+        NodeTable table(out);
+        uint64_t roots[2] = {table.ref(R), table.ref(frontier)};
+        writeValue(out, roots);
+        h.nodes = table.nodes();
+        bytes = static_cast<size_t>(out.tellp());
+        out.seekp(0);
+        writeValue(out, h);
+        if (!out) return 0;
+    }
+    error_code ec;
+    filesystem::rename(tmp, path, ec);
+    return ec ? 0 : bytes;
+}
+
+bool readBddSnapshot(const string& path, uint64_t fingerprint,
+                     DdManager* mgr, int variables, DdNode*& R,
+                     DdNode*& frontier, uint32_t& iteration) {
+    ifstream in(path, ios::binary);
+    BddHeader h;
+    if (!readValue(in, h)) return false;
+    if (memcmp(h.magic, BDD_MAGIC, 4) != 0 || h.version != VERSION ||
+        h.fingerprint != fingerprint || h.variables != (uint32_t)variables)
+        return false;
+    error_code ec;
+    uintmax_t size = filesystem::file_size(path, ec);
+    if (ec || sizeof(h) + h.nodes * sizeof(BddNodeRecord) +
+                      2 * sizeof(uint64_t) != size)
+        return false;
+
+    // node i + 1 of the file, Ref'd while the snapshot is rebuilt
+    vector<DdNode*> nodes(1, Cudd_ReadOne(mgr));
+    nodes.reserve(h.nodes + 1);
+    auto resolve = [&](uint64_t ref) -> DdNode* {
+        if ((ref >> 1) >= nodes.size()) return nullptr;
+        DdNode* f = nodes[ref >> 1];
+        return (ref & 1) ? Cudd_Not(f) : f;
+    };
+    bool ok = true;
+    for (uint64_t i = 0; i < h.nodes && ok; ++i) {
+        BddNodeRecord rec;
+        DdNode *t = nullptr, *e = nullptr;
+        ok = readValue(in, rec) && (int)rec.variable < variables &&
+             (t = resolve(rec.then)) && (e = resolve(rec.otherwise));
+        if (!ok) break;
+        DdNode* node =
+            Cudd_bddIte(mgr, Cudd_bddIthVar(mgr, rec.variable), t, e);
+        Cudd_Ref(node);
+        nodes.push_back(node);
+    }
+    uint64_t roots[2];
+    ok = ok && readValue(in, roots) && resolve(roots[0]) && resolve(roots[1]);
+    if (ok) {
+        R = resolve(roots[0]);
+        frontier = resolve(roots[1]);
+        Cudd_Ref(R);
+        Cudd_Ref(frontier);
+        iteration = h.iteration;
+    }
+    for (size_t i = 1; i < nodes.size(); ++i)
+        Cudd_RecursiveDeref(mgr, nodes[i]);
+    return ok;
+}
@@ -0,0 +1,228 @@
+#include "coverability.h"
+
+#include <deque>
+#include <map>
+#include <utility>
+
+#include "profiler.h"
+
+using namespace std;
+
+namespace {
+
+// Antichain of the active markings, ordered by (number of OMEGAs, sum of
+// the finite counts). Both grow with the covering order and two markings
+// with the same key cover each other only when equal, so covering
+// candidates of m lie strictly above its key, covered ones strictly below,
+// plus an exact match looked up directly.
+class AntichainStore {
+   public:
+    using Key = pair<int, long long>;
+
+    static Key key(const Marking& m) {
+        Key k{0, 0};
+        for (int v : m) {
+            if (v == OMEGA) {
+                ++k.first;
+            } else {
+                k.second += v;
+            }
+        }
+        return k;
+    }
+
+    void insert(int id, const Marking& m) {
+        if (static_cast<int>(where_.size()) <= id) where_.resize(id + 1);
+        where_[id] = index_.emplace(key(m), id);
+        exact_[m] = id;
+    }
+
+    void erase(int id, const Marking& m) {
+        index_.erase(where_[id]);
+        exact_.erase(m);
+    }
+
+    // Some stored marking >= m
+    template <typename Nodes>
+    bool covers(const Marking& m, const Nodes& nodes) const {
+        if (exact_.count(m)) return true;
+        for (auto it = index_.upper_bound(key(m)); it != index_.end(); ++it) {
+            if (coveredBy(m, nodes[it->second].m)) return true;
+        }
+        return false;
+    }
+
+    // Ids of the stored markings <= m
+    template <typename Nodes>
+    vector<int> coveredIds(const Marking& m, const Nodes& nodes) const {
+        vector<int> out;
+        auto end = index_.lower_bound(key(m));
+        for (auto it = index_.begin(); it != end; ++it) {
+            if (coveredBy(nodes[it->second].m, m)) out.push_back(it->second);
+        }
+        auto same = exact_.find(m);
+        if (same != exact_.end()) out.push_back(same->second);
+        return out;
+    }
+
+    vector<int> ids() const {
+        vector<int> out;
+        for (const auto& entry : index_) out.push_back(entry.second);
+        return out;
+    }
+
+   private:
+    multimap<Key, int> index_;
+    vector<multimap<Key, int>::iterator> where_;
+    map<Marking, int> exact_;
+};
+
+struct Node {
+    Marking m;
+    AntichainStore::Key key;
+    int parent;
+    bool active = true;
+    vector<int> children;
+};
+
+bool enabled(const Marking& m, int t, const PetriNet& net) {
+    for (size_t p = 0; p < m.size(); ++p) {
+        int pre = -net.incidenceMatrix[p][t];
+        if (pre > 0 && m[p] != OMEGA && m[p] < pre) return false;
+    }
+    return true;
+}
+
+Marking fire(const Marking& m, int t, const PetriNet& net) {
+    Marking next = m;
+    for (size_t p = 0; p < m.size(); ++p) {
+        if (next[p] != OMEGA) next[p] += net.incidenceMatrix[p][t];
+    }
+    return next;
+}
+
+}  // namespace
+
+bool coveredBy(const Marking& m1, const Marking& m2) {
+    for (size_t p = 0; p < m1.size(); ++p) {
+        if (m2[p] != OMEGA && (m1[p] == OMEGA || m1[p] > m2[p])) return false;
+    }
+    return true;
+}
+
+bool CoverabilitySet::bounded() const {
+    for (bool u : unbounded) {
+        if (u) return false;
+    }
+    return true;
+}
+
+vector<long long> CoverabilitySet::bounds() const {
+    vector<long long> b(unbounded.size(), 0);
+    for (const auto& m : basis) {
+        for (size_t p = 0; p < m.size(); ++p) {
+            if (m[p] == OMEGA) {
+                b[p] = -1;
+            } else if (b[p] >= 0 && m[p] > b[p]) {
+                b[p] = m[p];
+            }
+        }
+    }
+    return b;
+}
+
+bool CoverabilitySet::covers(const Marking& target) const {
+    for (const auto& m : basis) {
+        if (coveredBy(target, m)) return true;
+    }
+    return false;
+}
+
+CoverabilitySet coverabilitySet(const PetriNet& net, size_t maxNodes) {
+    PROFILE_SCOPE("coverabilitySet");
+    int P = static_cast<int>(net.places.size());
+    int T = static_cast<int>(net.transitions.size());
+    CoverabilitySet cs;
+
+    vector<Node> nodes;
+    nodes.push_back({net.initialMarking,
+                     AntichainStore::key(net.initialMarking), -1});
+    AntichainStore store;
+    store.insert(0, nodes[0].m);
+    // breadth first keeps the ancestor chains, walked for every successor,
+    // short
+    deque<int> work = {0};
+
+    // Deactivates root and its active subtree; the nodes stay in the tree
+    // as ancestors for acceleration but are no longer expanded. Inactive
+    // nodes get no children, so their subtrees are inactive already.
+    auto deactivate = [&](int root) {
+        vector<int> stack = {root};
+        while (!stack.empty()) {
+            int n = stack.back();
+            stack.pop_back();
+            if (!nodes[n].active) continue;
+            nodes[n].active = false;
+            store.erase(n, nodes[n].m);
+            ++cs.deactivated;
+            for (int c : nodes[n].children) stack.push_back(c);
+        }
+    };
+
+    cs.complete = true;
+    while (!work.empty()) {
+        int n = work.front();
+        work.pop_front();
+        for (int t = 0; t < T && nodes[n].active; ++t) {
+            if (!enabled(nodes[n].m, t, net)) continue;
+            Marking next = fire(nodes[n].m, t, net);
+
+            // omega-acceleration against every ancestor, active or not;
+            // a strictly covered ancestor has a strictly smaller key
+            bool accelerated = false;
+            AntichainStore::Key nextKey = AntichainStore::key(next);
+            for (int a = n; a >= 0; a = nodes[a].parent) {
+                const Marking& old = nodes[a].m;
+                if (!(nodes[a].key < nextKey) || !coveredBy(old, next))
+                    continue;
+                for (int p = 0; p < P; ++p) {
+                    if (old[p] != OMEGA && next[p] != OMEGA &&
+                        old[p] < next[p]) {
+                        next[p] = OMEGA;
+                        accelerated = true;
+                    }
+                }
+                nextKey = AntichainStore::key(next);
+            }
+            if (accelerated) ++cs.accelerations;
+
+            if (store.covers(next, nodes)) {
+                ++cs.pruned;
+                continue;
+            }
+            if (maxNodes > 0 && nodes.size() >= maxNodes) {
+                cs.complete = false;
+                work.clear();
+                break;
+            }
+            int id = static_cast<int>(nodes.size());
+            nodes.push_back({next, nextKey, n});
+            for (int y : store.coveredIds(next, nodes)) {
+                if (nodes[y].active) deactivate(y);
+            }
+            nodes[n].children.push_back(id);
+            store.insert(id, next);
+            work.push_back(id);
+        }
+    }
+
+    cs.nodes = nodes.size();
+    cs.unbounded.assign(P, false);
+    for (int id : store.ids()) {
+        cs.basis.push_back(nodes[id].m);
+        for (int p = 0; p < P; ++p) {
+            if (nodes[id].m[p] == OMEGA) cs.unbounded[p] = true;
+        }
+    }
+    return cs;
+}
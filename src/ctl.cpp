@@ -0,0 +1,561 @@
+#include "ctl.h"
+
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <map>
+
+#include "profiler.h"
+
+using namespace std;
+
+namespace {
+
+bool plainChar(char c) {
+    return isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '.';
+}
+
+class Parser {
+   public:
+    Parser(const string& text, const PetriNet& net) : text_(text) {
+        for (const Place& p : net.places) places_[p.id] = p.index;
+        for (size_t t = 0; t < net.transitions.size(); ++t)
+            transitions_[net.transitions[t].id] = static_cast<int>(t);
+    }
+
+    bool parse(CtlFormula& f, string& error) {
+        f = implies();
+        skip();
+        if (error_.empty() && pos_ < text_.size()) fail("unexpected input");
+        if (error_.empty()) return true;
+        error = error_;
+        return false;
+    }
+
+   private:
+    void skip() {
+        while (pos_ < text_.size() &&
+               isspace(static_cast<unsigned char>(text_[pos_])))
+            ++pos_;
+    }
+
+    bool match(const string& token) {
+        skip();
+        if (text_.compare(pos_, token.size(), token) != 0) return false;
+        pos_ += token.size();
+        return true;
+    }
+
+    void expect(const string& token) {
+        if (!match(token)) fail("expected '" + token + "'");
+    }
+
+    void fail(const string& message) {
+        if (error_.empty())
+            error_ = message + " at column " + to_string(pos_ + 1);
+    }
+
+    // plain word or quoted id; empty when neither
+    string word(bool& quoted) {
+        skip();
+        quoted = false;
+        if (pos_ < text_.size() && text_[pos_] == '"') {
+            size_t end = text_.find('"', pos_ + 1);
+            if (end == string::npos) {
+                fail("unterminated quote");
+                return "";
+            }
+            string id = text_.substr(pos_ + 1, end - pos_ - 1);
+            pos_ = end + 1;
+            quoted = true;
+            return id;
+        }
+        size_t start = pos_;
+        while (pos_ < text_.size() && plainChar(text_[pos_])) ++pos_;
+        return text_.substr(start, pos_ - start);
+    }
+
+    static CtlFormula node(CtlOp op, vector<CtlFormula> args = {}) {
+        CtlFormula f;
+        f.op = op;
+        f.args = move(args);
+        return f;
+    }
+
+    CtlFormula implies() {
+        CtlFormula lhs = disjunction();
+        if (!match("->")) return lhs;
+        return node(CtlOp::Implies, {lhs, implies()});
+    }
+
+    CtlFormula disjunction() {
+        CtlFormula f = conjunction();
+        while (error_.empty() && match("|"))
+            f = node(CtlOp::Or, {f, conjunction()});
+        return f;
+    }
+
+    CtlFormula conjunction() {
+        CtlFormula f = unary();
+        while (error_.empty() && match("&"))
+            f = node(CtlOp::And, {f, unary()});
+        return f;
+    }
+
+    CtlFormula unary() {
+        if (!error_.empty()) return CtlFormula();
+        if (match("!")) return node(CtlOp::Not, {unary()});
+        if (match("(")) {
+            CtlFormula f = implies();
+            expect(")");
+            return f;
+        }
+        size_t start = pos_;
+        bool quoted;
+        string w = word(quoted);
+        if (w.empty() && !quoted) {
+            fail("expected a formula");
+            return CtlFormula();
+        }
+        if (!quoted) {
+            static const map<string, CtlOp> temporal = {
+                {"EX", CtlOp::EX}, {"AX", CtlOp::AX}, {"EF", CtlOp::EF},
+                {"AF", CtlOp::AF}, {"EG", CtlOp::EG}, {"AG", CtlOp::AG}};
+            auto op = temporal.find(w);
+            if (op != temporal.end()) return node(op->second, {unary()});
+            if ((w == "E" || w == "A") && match("[")) {
+                CtlFormula lhs = implies();
+                expect("U");
+                CtlFormula rhs = implies();
+                expect("]");
+                return node(w == "E" ? CtlOp::EU : CtlOp::AU, {lhs, rhs});
+            }
+            if (w == "true") return node(CtlOp::True);
+            if (w == "false") return node(CtlOp::False);
+            if (w == "deadlock") return node(CtlOp::Deadlock);
+            if (w == "initial") return node(CtlOp::Initial);
+            if (w == "en" && match("(")) {
+                string id = word(quoted);
+                auto t = transitions_.find(id);
+                if (t == transitions_.end()) {
+                    fail("unknown transition '" + id + "'");
+                    return CtlFormula();
+                }
+                expect(")");
+                CtlFormula f = node(CtlOp::Enabled);
+                f.index = t->second;
+                return f;
+            }
+        }
+        auto p = places_.find(w);
+        if (p == places_.end()) {
+            pos_ = start;
+            skip();
+            fail("unknown place '" + w + "'");
+            return CtlFormula();
+        }
+        CtlFormula f = node(CtlOp::Atom);
+        f.index = p->second;
+        f.cmp = ">=";
+        f.value = 1;
+        for (const char* cmp : {">=", "<=", "!=", ">", "<", "="}) {
+            if (!match(cmp)) continue;
+            f.cmp = cmp;
+            skip();
+            size_t digits = pos_;
+            long long count = 0;  // saturates just past INT_MAX
+            while (pos_ < text_.size() &&
+                   isdigit(static_cast<unsigned char>(text_[pos_]))) {
+                count = min(count * 10 + (text_[pos_] - '0'), INT_MAX + 1LL);
+                ++pos_;
+            }
+            if (digits == pos_) {
+                fail("expected a token count");
+                return CtlFormula();
+            }
+            if (count > INT_MAX) {
+                fail("token count out of range");
+                return CtlFormula();
+            }
+            f.value = static_cast<int>(count);
+            break;
+        }
+        return f;
+    }
+
+    const string& text_;
+    size_t pos_ = 0;
+    string error_;
+    map<string, int> places_, transitions_;
+};
+
+string idString(const string& id) {
+    bool plain = !id.empty();
+    for (char c : id) plain = plain && plainChar(c);
+    return plain ? id : "\"" + id + "\"";
+}
+
+// Sets of reachable markings per subformula, memoized on ctlString
+class Checker {
+   public:
+    Checker(const PetriNet& net, const TransitionRelations& tr, DdNode* R)
+        : net_(net), tr_(tr), mgr_(tr.mgr), R_(R) {
+        m0_ = markingBDD(mgr_, tr.enc, net.initialMarking);
+        dead_ = R_;
+        Cudd_Ref(dead_);
+        for (DdNode* g : tr.guard) dead_ = andDeref(dead_, Cudd_Not(g));
+    }
+
+    ~Checker() {
+        for (auto& entry : memo_) Cudd_RecursiveDeref(mgr_, entry.second);
+        Cudd_RecursiveDeref(mgr_, m0_);
+        Cudd_RecursiveDeref(mgr_, dead_);
+    }
+
+    CtlResult check(const CtlFormula& f) {
+        CtlResult res;
+        res.formula = ctlString(f, net_);
+        DdNode* S = sat(f);
+        res.states = Cudd_CountMinterm(mgr_, S, tr_.nvars);
+        res.holds = !Cudd_bddLeq(mgr_, m0_, Cudd_Not(S));
+
+        DdNode* through = nullptr;
+        DdNode* target = nullptr;
+        bool oneStep = f.op == CtlOp::EX || f.op == CtlOp::AX;
+        if (res.holds && (f.op == CtlOp::EX || f.op == CtlOp::EF)) {
+            through = ref(R_);
+            target = ref(sat(f.args[0]));
+        } else if (res.holds && f.op == CtlOp::EU) {
+            through = ref(sat(f.args[0]));
+            target = ref(sat(f.args[1]));
+        } else if (!res.holds && (f.op == CtlOp::AX || f.op == CtlOp::AG)) {
+            through = ref(R_);
+            target = outside(sat(f.args[0]));
+        }
+        if (through != nullptr) {
+            res.hasPath = path(through, target, oneStep, res);
+            Cudd_RecursiveDeref(mgr_, through);
+            Cudd_RecursiveDeref(mgr_, target);
+        }
+        return res;
+    }
+
+   private:
+    DdNode* ref(DdNode* f) {
+        Cudd_Ref(f);
+        return f;
+    }
+
+    // a & b; Derefs a, returns a Ref'd node
+    DdNode* andDeref(DdNode* a, DdNode* b) {
+        DdNode* res = Cudd_bddAnd(mgr_, a, b);
+        Cudd_Ref(res);
+        Cudd_RecursiveDeref(mgr_, a);
+        return res;
+    }
+
+    DdNode* orDeref(DdNode* a, DdNode* b) {
+        DdNode* res = Cudd_bddOr(mgr_, a, b);
+        Cudd_Ref(res);
+        Cudd_RecursiveDeref(mgr_, a);
+        Cudd_RecursiveDeref(mgr_, b);
+        return res;
+    }
+
+    // R & !S, Ref'd
+    DdNode* outside(DdNode* S) {
+        DdNode* res = Cudd_bddAnd(mgr_, R_, Cudd_Not(S));
+        Cudd_Ref(res);
+        return res;
+    }
+
+    // R & OR_t pre_t(S), Ref'd
+    DdNode* ex(DdNode* S) {
+        DdNode* res = ref(Cudd_ReadLogicZero(mgr_));
+        for (size_t t = 0; t < tr_.guard.size(); ++t)
+            res = orDeref(res, preImage(tr_, S, static_cast<int>(t)));
+        return andDeref(res, R_);
+    }
+
+    // mu Z. b | (a & EX Z), growing Z by the predecessors of its frontier
+    DdNode* eu(DdNode* a, DdNode* b) {
+        DdNode* Z = ref(b);
+        DdNode* frontier = ref(b);
+        while (frontier != Cudd_ReadLogicZero(mgr_)) {
+            DdNode* pre = ex(frontier);
+            Cudd_RecursiveDeref(mgr_, frontier);
+            pre = andDeref(pre, a);
+            frontier = andDeref(pre, Cudd_Not(Z));
+            Z = orDeref(Z, ref(frontier));
+        }
+        Cudd_RecursiveDeref(mgr_, frontier);
+        return Z;
+    }
+
+    // nu Z. a & (EX Z | dead)
+    DdNode* eg(DdNode* a) {
+        DdNode* Z = ref(a);
+        while (true) {
+            DdNode* next = orDeref(ex(Z), ref(dead_));
+            next = andDeref(next, a);
+            bool fixed = next == Z;
+            Cudd_RecursiveDeref(mgr_, Z);
+            Z = next;
+            if (fixed) return Z;
+        }
+    }
+
+    DdNode* atom(const CtlFormula& f) {
+        const vector<int>& bits = tr_.enc.bits[f.index];
+        auto atLeast = [&](long long k) {
+            return valueAtLeast(mgr_, bits, k);
+        };
+        long long k = f.value;
+        DdNode* res;
+        if (f.cmp == ">=" || f.cmp == ">") {
+            res = atLeast(f.cmp == ">" ? k + 1 : k);
+        } else if (f.cmp == "<=" || f.cmp == "<") {
+            res = Cudd_Not(atLeast(f.cmp == "<=" ? k + 1 : k));
+        } else {
+            DdNode* low = atLeast(k);
+            DdNode* high = atLeast(k + 1);
+            res = Cudd_bddAnd(mgr_, low, Cudd_Not(high));
+            Cudd_Ref(res);
+            Cudd_RecursiveDeref(mgr_, low);
+            Cudd_RecursiveDeref(mgr_, high);
+            if (f.cmp == "!=") res = Cudd_Not(res);
+        }
+        return andDeref(res, R_);
+    }
+
+    // Reachable markings satisfying f, owned by the memo
+    DdNode* sat(const CtlFormula& f) {
+        string key = ctlString(f, net_);
+        auto found = memo_.find(key);
+        if (found != memo_.end()) return found->second;
+
+        auto arg = [&](size_t i) { return sat(f.args[i]); };
+        DdNode* res = nullptr;
+        switch (f.op) {
+            case CtlOp::True:
+                res = ref(R_);
+                break;
+            case CtlOp::False:
+                res = ref(Cudd_ReadLogicZero(mgr_));
+                break;
+            case CtlOp::Atom:
+                res = atom(f);
+                break;
+            case CtlOp::Initial:
+                res = Cudd_bddAnd(mgr_, m0_, R_);
+                Cudd_Ref(res);
+                break;
+            case CtlOp::Deadlock:
+                res = ref(dead_);
+                break;
+            case CtlOp::Enabled:
+                res = Cudd_bddAnd(mgr_, R_, tr_.guard[f.index]);
+                Cudd_Ref(res);
+                break;
+            case CtlOp::Not:
+                res = outside(arg(0));
+                break;
+            case CtlOp::And:
+                res = Cudd_bddAnd(mgr_, arg(0), arg(1));
+                Cudd_Ref(res);
+                break;
+            case CtlOp::Or:
+                res = Cudd_bddOr(mgr_, arg(0), arg(1));
+                Cudd_Ref(res);
+                break;
+            case CtlOp::Implies:
+                res = orDeref(outside(arg(0)), ref(arg(1)));
+                break;
+            case CtlOp::EX:
+                res = ex(arg(0));
+                break;
+            case CtlOp::AX: {
+                DdNode* bad = outside(arg(0));
+                DdNode* some = ex(bad);
+                res = outside(some);
+                Cudd_RecursiveDeref(mgr_, bad);
+                Cudd_RecursiveDeref(mgr_, some);
+                break;
+            }
+            case CtlOp::EF:
+                res = eu(R_, arg(0));
+                break;
+            case CtlOp::AF: {
+                DdNode* bad = outside(arg(0));
+                DdNode* forever = eg(bad);
+                res = outside(forever);
+                Cudd_RecursiveDeref(mgr_, bad);
+                Cudd_RecursiveDeref(mgr_, forever);
+                break;
+            }
+            case CtlOp::EG:
+                res = eg(arg(0));
+                break;
+            case CtlOp::AG: {
+                DdNode* bad = outside(arg(0));
+                DdNode* reach = eu(R_, bad);
+                res = outside(reach);
+                Cudd_RecursiveDeref(mgr_, bad);
+                Cudd_RecursiveDeref(mgr_, reach);
+                break;
+            }
+            case CtlOp::EU:
+                res = eu(arg(0), arg(1));
+                break;
+            case CtlOp::AU: {
+                DdNode* notF = outside(arg(0));
+                DdNode* notG = outside(arg(1));
+                DdNode* neither = Cudd_bddAnd(mgr_, notF, notG);
+                Cudd_Ref(neither);
+                DdNode* fails = orDeref(eu(notG, neither), eg(notG));
+                res = outside(fails);
+                for (DdNode* g : {notF, notG, neither, fails})
+                    Cudd_RecursiveDeref(mgr_, g);
+                break;
+            }
+        }
+        memo_[key] = res;
+        return res;
+    }
+
+    Marking pick(DdNode* S) {
+        vector<char> cube(Cudd_ReadSize(mgr_));
+        Cudd_bddPickOneCube(mgr_, S, cube.data());
+        return decodeMarking(tr_.enc, cube);
+    }
+
+    // Shortest path from M0 through markings of `through` to one of
+    // `target` (exactly one step when oneStep), by forward layers and a
+    // backward walk picking one predecessor per layer
+    bool path(DdNode* through, DdNode* target, bool oneStep, CtlResult& res) {
+        int T = static_cast<int>(tr_.guard.size());
+        vector<DdNode*> layers{ref(m0_)};
+        DdNode* visited = ref(m0_);
+        int hit = -1;
+        while (true) {
+            int k = static_cast<int>(layers.size()) - 1;
+            if ((!oneStep || k == 1) &&
+                !Cudd_bddLeq(mgr_, layers[k], Cudd_Not(target))) {
+                hit = k;
+                break;
+            }
+            if (oneStep && k == 1) break;
+            DdNode* from = Cudd_bddAnd(mgr_, layers[k], through);
+            Cudd_Ref(from);
+            DdNode* next = ref(Cudd_ReadLogicZero(mgr_));
+            for (int t = 0; t < T; ++t)
+                next = orDeref(next, postImage(tr_, from, t));
+            Cudd_RecursiveDeref(mgr_, from);
+            if (!oneStep) next = andDeref(next, Cudd_Not(visited));
+            if (next == Cudd_ReadLogicZero(mgr_)) {
+                Cudd_RecursiveDeref(mgr_, next);
+                break;
+            }
+            visited = orDeref(visited, ref(next));
+            layers.push_back(next);
+        }
+
+        if (hit >= 0) {
+            DdNode* end = Cudd_bddAnd(mgr_, layers[hit], target);
+            Cudd_Ref(end);
+            Marking M = pick(end);
+            Cudd_RecursiveDeref(mgr_, end);
+            res.path.push_back(M);
+            for (int i = hit; i > 0; --i) {
+                DdNode* state = markingBDD(mgr_, tr_.enc, M);
+                for (int t = 0; t < T; ++t) {
+                    DdNode* pre = preImage(tr_, state, t);
+                    pre = andDeref(pre, layers[i - 1]);
+                    pre = andDeref(pre, through);
+                    bool found = pre != Cudd_ReadLogicZero(mgr_);
+                    if (found) {
+                        M = pick(pre);
+                        res.trace.push_back(t);
+                        res.path.push_back(M);
+                    }
+                    Cudd_RecursiveDeref(mgr_, pre);
+                    if (found) break;
+                }
+                Cudd_RecursiveDeref(mgr_, state);
+            }
+            reverse(res.trace.begin(), res.trace.end());
+            reverse(res.path.begin(), res.path.end());
+        }
+        for (DdNode* layer : layers) Cudd_RecursiveDeref(mgr_, layer);
+        Cudd_RecursiveDeref(mgr_, visited);
+        return hit >= 0;
+    }
+
+    const PetriNet& net_;
+    const TransitionRelations& tr_;
+    DdManager* mgr_;
+    DdNode* R_;
+    DdNode* m0_;
+    DdNode* dead_;  // reachable markings enabling nothing
+    map<string, DdNode*> memo_;
+};
+
+}  // namespace
+
+bool parseCtl(const string& text, const PetriNet& net, CtlFormula& f,
+              string& error) {
+    return Parser(text, net).parse(f, error);
+}
+
+string ctlString(const CtlFormula& f, const PetriNet& net) {
+    auto arg = [&](size_t i) { return ctlString(f.args[i], net); };
+    switch (f.op) {
+        case CtlOp::True:
+            return "true";
+        case CtlOp::False:
+            return "false";
+        case CtlOp::Atom:
+            return idString(net.places[f.index].id) + " " + f.cmp + " " +
+                   to_string(f.value);
+        case CtlOp::Initial:
+            return "initial";
+        case CtlOp::Deadlock:
+            return "deadlock";
+        case CtlOp::Enabled:
+            return "en(" + idString(net.transitions[f.index].id) + ")";
+        case CtlOp::Not:
+            return "!" + arg(0);
+        case CtlOp::And:
+            return "(" + arg(0) + " & " + arg(1) + ")";
+        case CtlOp::Or:
+            return "(" + arg(0) + " | " + arg(1) + ")";
+        case CtlOp::Implies:
+            return "(" + arg(0) + " -> " + arg(1) + ")";
+        case CtlOp::EX:
+            return "EX " + arg(0);
+        case CtlOp::AX:
+            return "AX " + arg(0);
+        case CtlOp::EF:
+            return "EF " + arg(0);
+        case CtlOp::AF:
+            return "AF " + arg(0);
+        case CtlOp::EG:
+            return "EG " + arg(0);
+        case CtlOp::AG:
+            return "AG " + arg(0);
+        case CtlOp::EU:
+            return "E[" + arg(0) + " U " + arg(1) + "]";
+        case CtlOp::AU:
+            return "A[" + arg(0) + " U " + arg(1) + "]";
+    }
+    return "";
+}
+
+vector<CtlResult> checkCtl(const PetriNet& net, const TransitionRelations& tr,
+                           DdNode* R, const vector<CtlFormula>& formulas) {
+    PROFILE_SCOPE("checkCtl");
+    Checker checker(net, tr, R);
+    vector<CtlResult> results;
+    for (const CtlFormula& f : formulas) results.push_back(checker.check(f));
+    return results;
+}
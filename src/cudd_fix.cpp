@@ -1,4 +1,5 @@
 // File: cudd_fix.cpp
+#include <chrono>
 #include <cstdio>
 #include <ctime>
 
@@ -6,7 +7,13 @@
 extern "C" {
 
 // 1. Hàm tính thời gian CPU (thay thế cho sys/times.h)
-long util_cpu_time(void) { return (long)clock(); }
+// CUDD đo bằng mili giây (Cudd_SetTimeLimit). Wall time, the clock of
+// BudgetMonitor, so that both limits of a budget agree
+long util_cpu_time(void) {
+    return (long)std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
 
 // 2. Hàm lấy giới hạn bộ nhớ (thay thế cho sys/resource.h)
 // Trả về số lớn tượng trưng cho "vô cực"
@@ -1,10 +1,13 @@
 #include "deadlock_ILP.h"
 
+#include <atomic>
 #include <fstream>
 #include <iostream>
 
 #include "bdd.h"
-#include "heap_counter.h"
+#include "bounds.h"
+#include "invariants.h"
+#include "profiler.h"
 
 using namespace std;
 
@@ -37,7 +40,8 @@ bool isMarkingDead(const vector<int>& marking, const PetriNet& net) {
 
 // Hàm sinh file mô hình ILP (định dạng CPLEX LP standard)
 void generateDeadlockILP(const PetriNet& net, const string& purename,
-                         vector<vector<int>> forbidden) {
+                         vector<vector<int>> forbidden,
+                         const PlaceBounds* bounds) {
     string filename = "generated_files/" + purename + ".lp";
     ofstream file(filename);
     if (!file.is_open()) {
@@ -48,6 +52,16 @@ void generateDeadlockILP(const PetriNet& net, const string& purename,
     int P = net.places.size();
     int T = net.transitions.size();
 
+    // Variable domains: Binary for places bounded by 1, General otherwise
+    PlaceBounds computed;
+    if (bounds == nullptr) {
+        computed = computePlaceBounds(net);
+        bounds = &computed;
+    }
+    const vector<long long>& bound = bounds->bound;
+    vector<bool> binary(P);
+    for (int p = 0; p < P; ++p) binary[p] = bound[p] >= 0 && bound[p] <= 1;
+
     // 1. OBJECTIVE FUNCTION
     // Ta chỉ cần tìm 1 nghiệm khả thi (Feasibility), hàm mục tiêu có thể để
     // trống hoặc dummy
@@ -81,27 +95,57 @@ void generateDeadlockILP(const PetriNet& net, const string& purename,
         file << " = " << net.initialMarking[p] << "\n";
     }
 
+    // --- P-invariants: y . x = y . M0 ---
+    // Implied by the state equation, but as rows over x only they let the
+    // solver's presolve fix and drop places without looking at sigma.
+    InvariantBasis invariants = pInvariantBasis(net.incidenceMatrix);
+    for (int k = 0; k < invariants.dimension(); ++k) {
+        const SparseVector& y = invariants.vectors[k];
+        long long rhs = 0;
+        file << " c_inv_" << k << ":";
+        for (size_t i = 0; i < y.size(); ++i) {
+            const auto& e = y[i];
+            const char* sign = e.second < 0 ? " -" : (i ? " +" : "");
+            file << sign << " " << llabs(e.second) << " x" << e.first;
+            rhs += e.second * net.initialMarking[e.first];
+        }
+        file << " = " << rhs << "\n";
+    }
+
     // --- Ràng buộc 2: Điều kiện Deadlock (Disablement Constraints) ---
     // Với mỗi transition t, nó phải bị disabled.
     // Đối với mạng 1-safe: Disabled <=> Tồn tại p thuộc input(t) sao cho x_p =
     // 0. Công thức ILP: Sum_{p in input(t)} (1 - x_p) >= 1
     // <=> Sum ( -x_p ) >= 1 - Count(input_places)
     // <=> Sum ( x_p ) <= Count(input_places) - 1
+    //
+    // Places that may hold more than one token are General: then t is
+    // disabled iff some input place has x_p <= pre - 1, written with one
+    // binary selector z_t_p per input place and a big-M taken from the
+    // place bound: x_p + M z_t_p <= pre - 1 + M, sum_p z_t_p >= 1.
+    const long long UNKNOWN_BOUND_M = 1000000;  // place without a bound
+    vector<string> selectors;
 
     for (int t = 0; t < T; ++t) {
         vector<int> inputPlaces;
+        bool safeInputs = true;
+        bool neverEnabled = false;
         for (int p = 0; p < P; ++p) {
-            if (net.incidenceMatrix[p][t] < 0) {
+            int pre = -net.incidenceMatrix[p][t];
+            if (pre > 0) {
                 inputPlaces.push_back(p);
+                if (!binary[p] || pre != 1) safeInputs = false;
+                if (bound[p] >= 0 && bound[p] < pre) neverEnabled = true;
             }
         }
+        if (neverEnabled) continue;  // some input place can never cover it
 
         // Nếu transition không có đầu vào (Source transition) -> Luôn enabled
         // -> Hệ thống không bao giờ Deadlock Ta vẫn in constraint nhưng nó sẽ
         // vô nghiệm (0 <= -1), đúng logic.
         if (inputPlaces.empty()) {
             file << " c_dead_" << t << ": 0 >= 1\n";  // Vô lý -> Vô nghiệm
-        } else {
+        } else if (safeInputs) {
             file << " c_dead_" << t << ": ";
             for (size_t i = 0; i < inputPlaces.size(); ++i) {
                 file << "x" << inputPlaces[i];
@@ -110,6 +154,22 @@ void generateDeadlockILP(const PetriNet& net, const string& purename,
             // Tổng token ở các chỗ đầu vào phải bé hơn tổng số chỗ đầu vào (tức
             // là ít nhất 1 chỗ bằng 0)
             file << " <= " << (inputPlaces.size() - 1) << "\n";
+        } else {
+            file << " c_dead_" << t << ":";
+            for (size_t i = 0; i < inputPlaces.size(); ++i) {
+                string z = "z" + to_string(t) + "_" + to_string(inputPlaces[i]);
+                file << (i ? " + " : " ") << z;
+                selectors.push_back(z);
+            }
+            file << " >= 1\n";
+            for (int p : inputPlaces) {
+                long long pre = -net.incidenceMatrix[p][t];
+                long long bigM =
+                    bound[p] >= 0 ? bound[p] - pre + 1 : UNKNOWN_BOUND_M;
+                file << " c_dead_" << t << "_" << p << ": x" << p << " + "
+                     << bigM << " z" << t << "_" << p
+                     << " <= " << pre - 1 + bigM << "\n";
+            }
         }
     }
 
@@ -134,17 +194,27 @@ void generateDeadlockILP(const PetriNet& net, const string& purename,
         file << " s" << t << " >= 0\n";
     }
 
+    for (int p = 0; p < P; ++p) {
+        if (!binary[p] && bound[p] >= 0) {
+            file << " 0 <= x" << p << " <= " << bound[p] << "\n";
+        }
+    }
+
     file << "\nBinaries\n";  // Khai báo biến nhị phân (Binary) cho x_p (mạng
                              // 1-safe)
     for (int p = 0; p < P; ++p) {
-        file << " x" << p << "\n";
+        if (binary[p]) file << " x" << p << "\n";
     }
+    for (const string& z : selectors) file << " " << z << "\n";
 
     // (Nếu không phải 1-safe thì dùng Generals và Bounds cho x_p)
     file << "Generals\n";  // Khai báo biến nguyên cho Sigma
     for (int t = 0; t < T; ++t) {
         file << " s" << t << "\n";
     }
+    for (int p = 0; p < P; ++p) {
+        if (!binary[p]) file << " x" << p << "\n";
+    }
 
     file << "End\n";
     file.close();
@@ -176,8 +246,13 @@ bool solveILP(const string& purename) {
     // incomplete function
 }
 
-ILPResult cplex(const PetriNet& net, vector<vector<int>> forbidden) {
-    string purename = "auto_named";
+ILPResult cplex(const PetriNet& net, vector<vector<int>> forbidden,
+                const PlaceBounds* bounds) {
+    // one file pair per thread, batch mode runs several nets at once
+    static atomic<int> threadCount{0};
+    thread_local int threadId = threadCount++;
+    string purename =
+        threadId == 0 ? "auto_named" : "auto_named_" + to_string(threadId);
     string solFile = "generated_files/" + purename + ".sol";
     if (filesystem::exists(solFile)) {
         if (filesystem::remove(solFile)) {
@@ -189,7 +264,7 @@ ILPResult cplex(const PetriNet& net, vector<vector<int>> forbidden) {
         cout << "File does not exist.\n";
     }
     // This ensure old tests cannot affect new tests
-    generateDeadlockILP(net, purename, forbidden);
+    generateDeadlockILP(net, purename, forbidden, bounds);
     bool solved = solveILP(purename);
     ILPResult output;
     if (!solved) {
@@ -259,9 +334,32 @@ bool is_marking_in_R(DdManager* mgr, DdNode* R, const std::vector<DdNode*>& x,
 
 // FUNCTION ABOVE WAS IN DEBUGGING SESSION
 
-vector<int> findDeadlock(const PetriNet& net) {
+vector<int> findDeadlock(const PetriNet& net, const PlaceBounds* bounds,
+                         string* error) {
+    PROFILE_SCOPE("findDeadlock");
     int P = static_cast<int>(net.places.size());
 
+    // Nets that are not 1-safe check candidates against a reachable set
+    // over binary counters instead, which needs every bound
+    PlaceBounds computed;
+    if (bounds == nullptr) {
+        computed = computePlaceBounds(net);
+        bounds = &computed;
+    }
+    if (!bounds->allBounded()) {
+        string message = "deadlock=ilp needs a token bound for every place";
+        if (error) {
+            *error = message;
+        } else {
+            cerr << "Error: " << message << "\n";
+        }
+        return {};
+    }
+    EncodedReachable er;
+    if (!bounds->oneSafe()) {
+        er = symbolicReachability(net, boundedEncoding(*bounds));
+    }
+
     // Initialize BDD manager
     DdManager* mgr = Cudd_Init(0, 0, CUDD_UNIQUE_SLOTS, CUDD_CACHE_SLOTS, 0);
 
@@ -275,15 +373,32 @@ vector<int> findDeadlock(const PetriNet& net) {
     }
 
     // Compute reachable set R once
-    DdNode* R =
-        symbolicReachability_in_mgr(mgr, net, x, x_next);  // updated function
+    DdNode* R = er.mgr != nullptr
+                    ? Cudd_ReadLogicZero(mgr)
+                    : symbolicReachability_in_mgr(mgr, net, x,
+                                                  x_next);  // updated function
+    if (er.mgr != nullptr) Cudd_Ref(R);
+    auto reachable = [&](const vector<int>& M) {
+        if (er.mgr == nullptr) return is_marking_in_R(mgr, R, x, M);
+        vector<int> bits(er.nvars, 0);
+        vector<DdNode*> vars(er.nvars);
+        for (int v = 0; v < er.nvars; ++v) vars[v] = Cudd_bddIthVar(er.mgr, v);
+        for (int p = 0; p < P; ++p) {
+            const vector<int>& b = er.enc.bits[p];
+            for (size_t i = 0; i < b.size(); ++i) bits[b[i]] = (M[p] >> i) & 1;
+        }
+        DdNode* cube = make_marking(er.mgr, vars.data(), bits, er.nvars);
+        bool in = Cudd_bddLeq(er.mgr, cube, er.R);
+        Cudd_RecursiveDeref(er.mgr, cube);
+        return in;
+    };
 
     // Forbidden list for ILP
     vector<vector<int>> forbidden;
 
     while (true) {
         // Run ILP with current forbidden markings
-        ILPResult res = cplex(net, forbidden);
+        ILPResult res = cplex(net, forbidden, bounds);
 
         if (!res.hasSolution) {
             cout << "No deadlock found (ILP infeasible)\n";
@@ -291,16 +406,18 @@ vector<int> findDeadlock(const PetriNet& net) {
         }
 
         // Check if candidate marking is reachable
-        if (is_marking_in_R(mgr, R, x, res.deadMarking)) {
+        if (reachable(res.deadMarking)) {
             cout << "Deadlock found!\n";
 
             // Cleanup BDDs
+            PROFILE_CUDD(mgr);
             Cudd_RecursiveDeref(mgr, R);
             for (int i = 0; i < P; ++i) {
                 Cudd_RecursiveDeref(mgr, x[i]);
                 Cudd_RecursiveDeref(mgr, x_next[i]);
             }
             Cudd_Quit(mgr);
+            freeEncodedReachable(er);
             return res.deadMarking;
         } else {
             cout << "Candidate marking not reachable, adding to forbidden "
@@ -310,22 +427,53 @@ vector<int> findDeadlock(const PetriNet& net) {
     }
 
     // Cleanup if no deadlock found
+    PROFILE_CUDD(mgr);
     Cudd_RecursiveDeref(mgr, R);
     for (int i = 0; i < P; ++i) {
         Cudd_RecursiveDeref(mgr, x[i]);
         Cudd_RecursiveDeref(mgr, x_next[i]);
     }
     Cudd_Quit(mgr);
+    freeEncodedReachable(er);
 
     return {};  // empty = no deadlock
 }
 
+DdNode* deadMarkingsBDD(DdManager* mgr, const PetriNet& net,
+                        const vector<DdNode*>& x) {
+    int P = static_cast<int>(net.places.size());
+    int T = static_cast<int>(net.transitions.size());
+
+    DdNode* dead = Cudd_ReadOne(mgr);
+    Cudd_Ref(dead);
+    for (int t = 0; t < T; ++t) {
+        // enabled_t = AND of the input places (1-safe)
+        DdNode* enabled = Cudd_ReadOne(mgr);
+        Cudd_Ref(enabled);
+        for (int p = 0; p < P; ++p) {
+            if (net.incidenceMatrix[p][t] < 0) {
+                DdNode* tmp = Cudd_bddAnd(mgr, enabled, x[p]);
+                Cudd_Ref(tmp);
+                Cudd_RecursiveDeref(mgr, enabled);
+                enabled = tmp;
+            }
+        }
+        DdNode* tmp = Cudd_bddAnd(mgr, dead, Cudd_Not(enabled));
+        Cudd_Ref(tmp);
+        Cudd_RecursiveDeref(mgr, dead);
+        Cudd_RecursiveDeref(mgr, enabled);
+        dead = tmp;
+    }
+    return dead;
+}
+
 DdNode* symbolicReachability_in_mgr(DdManager* mgr, const PetriNet& net,
                                     vector<DdNode*>& x,
-                                    vector<DdNode*>& x_next) {
+                                    vector<DdNode*>& x_next,
+                                    const CheckpointOptions* checkpoint,
+                                    CheckpointStats* stats,
+                                    BudgetMonitor* budget) {
     int P = static_cast<int>(net.places.size());
-    int T = static_cast<int>(net.transitions.size());
-    const auto& C = net.incidenceMatrix;
 
     // Create current and next state variables
     for (int i = 0; i < P; ++i) {
@@ -335,41 +483,19 @@ DdNode* symbolicReachability_in_mgr(DdManager* mgr, const PetriNet& net,
         Cudd_Ref(x_next[i]);
     }
 
-    // R0 = initial marking
-    DdNode* R = make_marking(mgr, x.data(), net.initialMarking, P);
-    // make_marking already Ref'd
-    bool changed = true;
-
-    while (changed) {
-        changed = false;
-
-        DdNode* newStates = Cudd_ReadLogicZero(mgr);
-        Cudd_Ref(newStates);
-
-        for (int t = 0; t < T; ++t) {
-            DdNode* post = compute_post(
-                mgr, R, C, t, x, x_next);  // assumed already Ref'd inside
-            DdNode* tmp = Cudd_bddOr(mgr, newStates, post);
-            Cudd_Ref(tmp);
-            Cudd_RecursiveDeref(mgr, newStates);
-            newStates = tmp;
-            Cudd_RecursiveDeref(mgr, post);
-        }
-
-        DdNode* diff = Cudd_bddAnd(mgr, newStates, Cudd_Not(R));
-        Cudd_Ref(diff);
-
-        if (diff != Cudd_ReadLogicZero(mgr)) {
-            changed = true;
-            DdNode* tmp = Cudd_bddOr(mgr, R, diff);
-            Cudd_Ref(tmp);
-            Cudd_RecursiveDeref(mgr, R);
-            R = tmp;
-        }
-
-        Cudd_RecursiveDeref(mgr, newStates);
-        Cudd_RecursiveDeref(mgr, diff);
+    // R = closure of the initial marking under the cached relations
+    TransitionRelations tr =
+        buildTransitionRelations(mgr, net, oneBitEncoding(P), true);
+    DdNode* M0 = make_marking(mgr, x.data(), net.initialMarking, P);
+    CheckpointOptions cp;
+    if (checkpoint) {
+        cp = *checkpoint;
+        cp.fingerprint = netFingerprint(net);
     }
+    DdNode* R =
+        forwardClosure(tr, M0, checkpoint ? &cp : nullptr, stats, budget);
+    Cudd_RecursiveDeref(mgr, M0);
+    freeTransitionRelations(tr);
 
     /*
     double num = Cudd_CountMinterm(mgr, R, P);
@@ -380,4 +506,33 @@ DdNode* symbolicReachability_in_mgr(DdManager* mgr, const PetriNet& net,
     // left here to indicate this function is a derivative of its origin
 
     return R;
-}
\ No newline at end of file
+}
+
+DdNode* deadMarkingsBDD(DdManager* mgr, const PetriNet& net,
+                        const PlaceEncoding& enc) {
+    int P = static_cast<int>(net.places.size());
+    int T = static_cast<int>(net.transitions.size());
+
+    DdNode* dead = Cudd_ReadOne(mgr);
+    Cudd_Ref(dead);
+    for (int t = 0; t < T; ++t) {
+        DdNode* enabled = Cudd_ReadOne(mgr);
+        Cudd_Ref(enabled);
+        for (int p = 0; p < P; ++p) {
+            int pre = -net.incidenceMatrix[p][t];
+            if (pre <= 0) continue;
+            DdNode* covered = valueAtLeast(mgr, enc.bits[p], pre);
+            DdNode* tmp = Cudd_bddAnd(mgr, enabled, covered);
+            Cudd_Ref(tmp);
+            Cudd_RecursiveDeref(mgr, enabled);
+            Cudd_RecursiveDeref(mgr, covered);
+            enabled = tmp;
+        }
+        DdNode* tmp = Cudd_bddAnd(mgr, dead, Cudd_Not(enabled));
+        Cudd_Ref(tmp);
+        Cudd_RecursiveDeref(mgr, dead);
+        Cudd_RecursiveDeref(mgr, enabled);
+        dead = tmp;
+    }
+    return dead;
+}
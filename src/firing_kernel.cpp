@@ -0,0 +1,420 @@
+#include "firing_kernel.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include "profiler.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define FIRING_KERNEL_X86 1
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+const int BLOCK = 16;  // int32 lanes per bounded block (one AVX-512 vector)
+
+int32_t lane(const uint64_t* row, int p) {
+    int32_t v;
+    memcpy(&v, reinterpret_cast<const char*>(row) + 4 * p, 4);
+    return v;
+}
+
+// Bits past the last transition come from padding: clear them
+void clearPadding(const FiringKernel& k, uint64_t* enabled) {
+    if (k.transitions % 64 == 0) return;
+    enabled[k.transitions / 64] &= (uint64_t(1) << (k.transitions % 64)) - 1;
+}
+
+void enabledScalar(const FiringKernel& k, const uint64_t* rows, size_t count,
+                   uint64_t* enabled) {
+    int lanes = 2 * k.rowWords;
+    vector<int32_t> m(k.safe ? 0 : lanes);
+    for (size_t i = 0; i < count; ++i) {
+        const uint64_t* M = rows + i * k.rowWords;
+        uint64_t* e = enabled + i * k.maskWords;
+        if (!k.safe) memcpy(m.data(), M, 4 * lanes);
+        for (int t = 0; t < k.transitions; ++t) {
+            bool ok = true;
+            if (k.safe) {
+                for (int w = 0; w < k.rowWords && ok; ++w)
+                    ok = !(k.pre[w * k.paddedT + t] & ~M[w]);
+            } else {
+                const int32_t* need = k.need.data() + size_t(t) * lanes;
+                for (int j = k.needStart[t]; j < k.needStart[t + 1] && ok;
+                     ++j) {
+                    int base = k.needBlock[j] * BLOCK;
+                    for (int l = base; l < base + BLOCK; ++l)
+                        if (need[l] > m[l]) ok = false;
+                }
+            }
+            if (ok) e[t / 64] |= uint64_t(1) << (t % 64);
+        }
+    }
+}
+
+#ifdef FIRING_KERNEL_X86
+
+__attribute__((target("avx2"))) void enabledAVX2(const FiringKernel& k,
+                                                 const uint64_t* rows,
+                                                 size_t count,
+                                                 uint64_t* enabled) {
+    int lanes = 2 * k.rowWords;
+    const __m256i zero = _mm256_setzero_si256();
+    for (size_t i = 0; i < count; ++i) {
+        const uint64_t* M = rows + i * k.rowWords;
+        uint64_t* e = enabled + i * k.maskWords;
+        if (k.safe) {
+            // 4 transitions per step: pre & ~M over every word
+            for (int tb = 0; tb < k.paddedT; tb += 4) {
+                __m256i acc = zero;
+                for (int w = 0; w < k.rowWords; ++w) {
+                    __m256i pre =
+                        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(
+                            k.pre.data() + size_t(w) * k.paddedT + tb));
+                    __m256i m = _mm256_set1_epi64x((long long)M[w]);
+                    acc = _mm256_or_si256(acc, _mm256_andnot_si256(m, pre));
+                }
+                uint64_t bits = _mm256_movemask_pd(
+                    _mm256_castsi256_pd(_mm256_cmpeq_epi64(acc, zero)));
+                e[tb / 64] |= bits << (tb % 64);
+            }
+            continue;
+        }
+        for (int t = 0; t < k.transitions; ++t) {
+            const int32_t* need = k.need.data() + size_t(t) * lanes;
+            bool ok = true;
+            for (int j = k.needStart[t]; j < k.needStart[t + 1] && ok; ++j) {
+                int base = k.needBlock[j] * BLOCK;
+                const __m256i* n =
+                    reinterpret_cast<const __m256i*>(need + base);
+                const __m256i* m = reinterpret_cast<const __m256i*>(
+                    reinterpret_cast<const int32_t*>(M) + base);
+                __m256i gt = _mm256_or_si256(
+                    _mm256_cmpgt_epi32(_mm256_loadu_si256(n),
+                                       _mm256_loadu_si256(m)),
+                    _mm256_cmpgt_epi32(_mm256_loadu_si256(n + 1),
+                                       _mm256_loadu_si256(m + 1)));
+                ok = _mm256_testz_si256(gt, gt);
+            }
+            if (ok) e[t / 64] |= uint64_t(1) << (t % 64);
+        }
+    }
+}
+
+__attribute__((target("avx512f"))) void enabledAVX512(const FiringKernel& k,
+                                                     const uint64_t* rows,
+                                                     size_t count,
+                                                     uint64_t* enabled) {
+    int lanes = 2 * k.rowWords;
+    for (size_t i = 0; i < count; ++i) {
+        const uint64_t* M = rows + i * k.rowWords;
+        uint64_t* e = enabled + i * k.maskWords;
+        if (k.safe) {
+            // 8 transitions per step
+            for (int tb = 0; tb < k.paddedT; tb += 8) {
+                __m512i acc = _mm512_setzero_si512();
+                for (int w = 0; w < k.rowWords; ++w) {
+                    __m512i pre = _mm512_loadu_si512(
+                        k.pre.data() + size_t(w) * k.paddedT + tb);
+                    __m512i free = _mm512_set1_epi64((long long)~M[w]);
+                    acc = _mm512_or_si512(acc, _mm512_and_si512(free, pre));
+                }
+                uint64_t bits =
+                    static_cast<uint8_t>(~_mm512_test_epi64_mask(acc, acc));
+                e[tb / 64] |= bits << (tb % 64);
+            }
+            continue;
+        }
+        for (int t = 0; t < k.transitions; ++t) {
+            const int32_t* need = k.need.data() + size_t(t) * lanes;
+            bool ok = true;
+            for (int j = k.needStart[t]; j < k.needStart[t + 1] && ok; ++j) {
+                int base = k.needBlock[j] * BLOCK;
+                ok = !_mm512_cmpgt_epi32_mask(
+                    _mm512_loadu_si512(need + base),
+                    _mm512_loadu_si512(reinterpret_cast<const int32_t*>(M) +
+                                       base));
+            }
+            if (ok) e[t / 64] |= uint64_t(1) << (t % 64);
+        }
+    }
+}
+
+#endif  // FIRING_KERNEL_X86
+
+void fire(const FiringKernel& k, const uint64_t* M, int t, uint64_t* out) {
+    if (k.safe) {
+        for (int w = 0; w < k.rowWords; ++w) {
+            size_t at = size_t(w) * k.paddedT + t;
+            out[w] = (M[w] & ~k.pre[at]) | k.post[at];
+        }
+        return;
+    }
+    memcpy(out, M, 8 * k.rowWords);
+    const int32_t* delta = k.delta.data() + size_t(t) * 2 * k.rowWords;
+    for (int j = k.deltaStart[t]; j < k.deltaStart[t + 1]; ++j) {
+        int base = k.deltaBlock[j] * BLOCK;
+        int32_t m[BLOCK];
+        char* at = reinterpret_cast<char*>(out) + 4 * base;
+        memcpy(m, at, sizeof(m));
+        for (int l = 0; l < BLOCK; ++l) m[l] += delta[base + l];
+        memcpy(at, m, sizeof(m));
+    }
+}
+
+uint64_t hashRow(const uint64_t* row, int words) {
+    uint64_t h = 0x9e3779b97f4a7c15ull;
+    for (int w = 0; w < words; ++w) {
+        h ^= row[w];
+        h *= 0xbf58476d1ce4e5b9ull;
+        h ^= h >> 31;
+    }
+    return h;
+}
+
+}  // namespace
+
+SimdLevel detectSimdLevel() {
+#ifdef FIRING_KERNEL_X86
+    static const SimdLevel level = [] {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) return SimdLevel::AVX512;
+        if (__builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+        return SimdLevel::Scalar;
+    }();
+    return level;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+const char* simdLevelName(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::AVX512:
+            return "avx512";
+        case SimdLevel::AVX2:
+            return "avx2";
+        default:
+            return "scalar";
+    }
+}
+
+bool parseSimdLevel(const string& name, SimdLevel& level) {
+    if (name == "auto") {
+        level = detectSimdLevel();
+    } else if (name == "scalar") {
+        level = SimdLevel::Scalar;
+    } else if (name == "avx2") {
+        level = min(SimdLevel::AVX2, detectSimdLevel());
+    } else if (name == "avx512") {
+        level = min(SimdLevel::AVX512, detectSimdLevel());
+    } else {
+        return false;
+    }
+    return true;
+}
+
+FiringKernel buildFiringKernel(const PetriNet& net, bool safe) {
+    int P = static_cast<int>(net.places.size());
+    int T = static_cast<int>(net.transitions.size());
+    const auto& C = net.incidenceMatrix;
+    FiringKernel k;
+    k.places = P;
+    k.transitions = T;
+    k.paddedT = (T + 7) / 8 * 8;
+    k.maskWords = max(1, (T + 63) / 64);
+
+    bool unit = true;
+    for (int p = 0; p < P; ++p)
+        for (int t = 0; t < T; ++t) unit = unit && abs(C[p][t]) <= 1;
+    k.safe = safe && unit;
+
+    if (k.safe) {
+        k.rowWords = max(1, (P + 63) / 64);
+        k.pre.assign(size_t(k.rowWords) * k.paddedT, 0);
+        k.post.assign(size_t(k.rowWords) * k.paddedT, 0);
+        for (int p = 0; p < P; ++p) {
+            for (int t = 0; t < T; ++t) {
+                size_t at = size_t(p / 64) * k.paddedT + t;
+                uint64_t bit = uint64_t(1) << (p % 64);
+                if (C[p][t] < 0) k.pre[at] |= bit;
+                if (C[p][t] > 0) k.post[at] |= bit;
+            }
+        }
+        return k;
+    }
+
+    int lanes = max(BLOCK, (P + BLOCK - 1) / BLOCK * BLOCK);
+    k.rowWords = lanes / 2;
+    k.need.assign(size_t(T) * lanes, 0);
+    k.delta.assign(size_t(T) * lanes, 0);
+    k.needStart.push_back(0);
+    k.deltaStart.push_back(0);
+    for (int t = 0; t < T; ++t) {
+        int32_t* need = k.need.data() + size_t(t) * lanes;
+        int32_t* delta = k.delta.data() + size_t(t) * lanes;
+        for (int p = 0; p < P; ++p) {
+            need[p] = max(0, -C[p][t]);
+            delta[p] = C[p][t];
+        }
+        for (int b = 0; b < lanes / BLOCK; ++b) {
+            bool reads = false, writes = false;
+            for (int l = b * BLOCK; l < (b + 1) * BLOCK; ++l) {
+                reads = reads || need[l] != 0;
+                writes = writes || delta[l] != 0;
+            }
+            if (reads) k.needBlock.push_back(b);
+            if (writes) k.deltaBlock.push_back(b);
+        }
+        k.needStart.push_back(static_cast<int>(k.needBlock.size()));
+        k.deltaStart.push_back(static_cast<int>(k.deltaBlock.size()));
+    }
+    return k;
+}
+
+void packMarking(const FiringKernel& k, const Marking& M, uint64_t* row) {
+    fill(row, row + k.rowWords, 0);
+    for (int p = 0; p < k.places; ++p) {
+        if (k.safe) {
+            if (M[p]) row[p / 64] |= uint64_t(1) << (p % 64);
+        } else {
+            int32_t v = M[p];
+            memcpy(reinterpret_cast<char*>(row) + 4 * p, &v, 4);
+        }
+    }
+}
+
+Marking unpackMarking(const FiringKernel& k, const uint64_t* row) {
+    Marking M(k.places);
+    for (int p = 0; p < k.places; ++p)
+        M[p] = k.safe ? (row[p / 64] >> (p % 64)) & 1 : lane(row, p);
+    return M;
+}
+
+void enabledBatch(const FiringKernel& k, const uint64_t* rows, size_t count,
+                  uint64_t* enabled, SimdLevel level) {
+    fill(enabled, enabled + count * k.maskWords, 0);
+    level = min(level, detectSimdLevel());
+#ifdef FIRING_KERNEL_X86
+    if (level == SimdLevel::AVX512) {
+        enabledAVX512(k, rows, count, enabled);
+    } else if (level == SimdLevel::AVX2) {
+        enabledAVX2(k, rows, count, enabled);
+    } else {
+        enabledScalar(k, rows, count, enabled);
+    }
+#else
+    enabledScalar(k, rows, count, enabled);
+#endif
+    if (k.safe) {
+        for (size_t i = 0; i < count; ++i)
+            clearPadding(k, enabled + i * k.maskWords);
+    }
+}
+
+size_t successorBatch(const FiringKernel& k, const uint64_t* rows,
+                      size_t count, SimdLevel level, vector<uint64_t>& succ,
+                      vector<uint32_t>& from, vector<int>& via) {
+    vector<uint64_t> enabled(count * k.maskWords);
+    enabledBatch(k, rows, count, enabled.data(), level);
+    size_t before = from.size();
+    for (size_t i = 0; i < count; ++i) {
+        for (int w = 0; w < k.maskWords; ++w) {
+            for (uint64_t bits = enabled[i * k.maskWords + w]; bits;
+                 bits &= bits - 1) {
+                int t = w * 64 + __builtin_ctzll(bits);
+                size_t at = succ.size();
+                succ.resize(at + k.rowWords);
+                fire(k, rows + i * k.rowWords, t, succ.data() + at);
+                from.push_back(static_cast<uint32_t>(i));
+                via.push_back(t);
+            }
+        }
+    }
+    return from.size() - before;
+}
+
+// The rows double as the FIFO queue: rows[head..] are found but not yet
+// expanded. Open addressing over row indices keeps the visited set flat.
+vector<Marking> batchedReachability(const PetriNet& net,
+                                    const FiringKernel& k, SimdLevel level,
+                                    ParentTable* parents,
+                                    BudgetMonitor* budget) {
+    PROFILE_SCOPE("batchedReachability");
+    const size_t CHUNK = 1024;
+    level = min(level, detectSimdLevel());
+    int W = k.rowWords;
+
+    vector<uint64_t> rows;
+    vector<uint32_t> slots(1024, 0);  // row index + 1, 0: empty
+    size_t n = 0;
+    auto insert = [&](const uint64_t* row) {
+        if (2 * (n + 1) > slots.size()) {
+            vector<uint32_t> grown(2 * slots.size(), 0);
+            size_t mask = grown.size() - 1;
+            for (size_t s = 0; s < n; ++s) {
+                size_t h = hashRow(rows.data() + s * W, W) & mask;
+                while (grown[h]) h = (h + 1) & mask;
+                grown[h] = static_cast<uint32_t>(s + 1);
+            }
+            slots.swap(grown);
+        }
+        size_t mask = slots.size() - 1;
+        for (size_t h = hashRow(row, W) & mask;; h = (h + 1) & mask) {
+            if (!slots[h]) {
+                slots[h] = static_cast<uint32_t>(++n);
+                rows.insert(rows.end(), row, row + W);
+                return true;
+            }
+            if (!memcmp(rows.data() + size_t(slots[h] - 1) * W, row, 8 * W))
+                return false;
+        }
+    };
+
+    vector<uint64_t> first(W);
+    packMarking(k, net.initialMarking, first.data());
+    insert(first.data());
+    if (parents) {
+        parents->reset(k.transitions);
+        parents->record(ParentTable::NONE, 0);
+    }
+
+    vector<uint64_t> succ;
+    vector<uint32_t> from;
+    vector<int> via;
+    size_t head = 0;
+    while (head < n) {
+        if (budget && budget->exhausted()) {
+            budget->progress(head, double(n - head));
+            break;
+        }
+        size_t count = min(CHUNK, n - head);
+        succ.clear();
+        from.clear();
+        via.clear();
+        size_t found = successorBatch(k, rows.data() + head * W, count,
+                                      level, succ, from, via);
+        for (size_t j = 0; j < found; ++j) {
+            if (insert(succ.data() + j * W) && parents)
+                parents->record(static_cast<uint32_t>(head + from[j]),
+                                via[j]);
+        }
+        head += count;
+    }
+
+    vector<Marking> reachableMarkings;
+    reachableMarkings.reserve(head);
+    for (size_t s = 0; s < head; ++s)
+        reachableMarkings.push_back(unpackMarking(k, rows.data() + s * W));
+
+    cout << "--- Task 2 Results (Explicit Reachability, batched "
+         << simdLevelName(level) << (k.safe ? " bitset" : " int32")
+         << ") ---" << endl;
+    cout << "Total reachable markings found: " << reachableMarkings.size()
+         << endl;
+    return reachableMarkings;
+}
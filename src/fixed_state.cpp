@@ -0,0 +1,183 @@
+#include "fixed_state.h"
+
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <unordered_map>
+
+#include "profiler.h"
+
+using namespace std;
+
+namespace {
+
+template <int N>
+using State = array<uint64_t, N>;
+
+template <int N>
+struct StateHash {
+    size_t operator()(const State<N>& s) const {
+        uint64_t h = 0x9e3779b97f4a7c15ull;
+        for (int w = 0; w < N; ++w) {
+            h ^= s[w];
+            h *= 0xbf58476d1ce4e5b9ull;
+            h ^= h >> 31;
+        }
+        return static_cast<size_t>(h);
+    }
+};
+
+template <int N>
+State<N> pack(const FieldLayout& L, const Marking& M) {
+    State<N> s{};
+    for (size_t p = 0; p < M.size(); ++p)
+        s[L.word[p]] |= uint64_t(M[p]) << L.shift[p];
+    return s;
+}
+
+template <int N>
+Marking unpack(const FieldLayout& L, const State<N>& s) {
+    Marking M(L.word.size());
+    for (size_t p = 0; p < M.size(); ++p) {
+        uint64_t mask = (uint64_t(1) << L.bits[p]) - 1;
+        M[p] = static_cast<int>((s[L.word[p]] >> L.shift[p]) & mask);
+    }
+    return M;
+}
+
+template <int N>
+vector<Marking> fixedBfs(const PetriNet& net, const FieldLayout& L,
+                         ParentTable* parents, BudgetMonitor* budget,
+                         EdgeTable* edges) {
+    int P = static_cast<int>(net.places.size());
+    int T = static_cast<int>(net.transitions.size());
+
+    // pre(t), post(t) as packed markings, and the guard bits H
+    vector<State<N>> pre(T), post(T);
+    State<N> H{};
+    for (int p = 0; p < P; ++p) {
+        H[L.word[p]] |= uint64_t(1) << (L.shift[p] + L.bits[p] - 1);
+        for (int t = 0; t < T; ++t) {
+            int c = net.incidenceMatrix[p][t];
+            if (c < 0) pre[t][L.word[p]] |= uint64_t(-c) << L.shift[p];
+            if (c > 0) post[t][L.word[p]] |= uint64_t(c) << L.shift[p];
+        }
+    }
+
+    vector<State<N>> states;  // BFS order; states[i..] is the queue
+    unordered_map<State<N>, uint32_t, StateHash<N>> visited;  // to index
+    states.push_back(pack<N>(L, net.initialMarking));
+    visited.emplace(states[0], 0);
+    if (parents) {
+        parents->reset(T);
+        parents->record(ParentTable::NONE, 0);
+    }
+    if (edges) edges->reset();
+
+    size_t i = 0;
+    for (; i < states.size(); ++i) {
+        if (budget && (i & 1023) == 0 && budget->exhausted()) {
+            budget->progress(i, double(states.size() - i));
+            break;
+        }
+        const State<N> M = states[i];
+        for (int t = 0; t < T; ++t) {
+            const State<N>& a = pre[t];
+            bool enabled = true;
+            for (int w = 0; w < N; ++w)
+                enabled &= (((M[w] | H[w]) - a[w]) & H[w]) == H[w];
+            if (!enabled) continue;
+            State<N> next;
+            for (int w = 0; w < N; ++w) next[w] = M[w] - a[w] + post[t][w];
+            uint32_t id = static_cast<uint32_t>(states.size());
+            auto found = visited.try_emplace(next, id);
+            if (found.second) {
+                states.push_back(next);
+                if (parents) parents->record(static_cast<uint32_t>(i), t);
+            }
+            if (edges) edges->add(found.first->second, t);
+        }
+        if (edges) edges->close();
+    }
+
+    vector<Marking> reachableMarkings;
+    reachableMarkings.reserve(i);
+    for (size_t s = 0; s < i; ++s)
+        reachableMarkings.push_back(unpack<N>(L, states[s]));
+    return reachableMarkings;
+}
+
+}  // namespace
+
+FieldLayout fieldLayout(const PetriNet& net, const vector<long long>& bound) {
+    int P = static_cast<int>(net.places.size());
+    int T = static_cast<int>(net.transitions.size());
+    FieldLayout L;
+    L.word.resize(P);
+    L.shift.resize(P);
+    L.bits.resize(P);
+    int used = 64;  // bits taken in the current word
+    for (int p = 0; p < P; ++p) {
+        long long v = bound[p];
+        for (int t = 0; t < T; ++t)
+            v = max<long long>(v, -net.incidenceMatrix[p][t]);
+        int bits = 1;
+        while (bits < 63 && (v >> bits) != 0) ++bits;
+        ++bits;  // the guard bit
+        if (used + bits > 64) {
+            ++L.words;
+            used = 0;
+        }
+        L.word[p] = L.words - 1;
+        L.shift[p] = used;
+        L.bits[p] = bits;
+        used += bits;
+    }
+    L.words = max(1, L.words);
+    return L;
+}
+
+int fixedStateWords(const FieldLayout& layout) {
+    for (int n : {1, 2, 4, 8, 16})
+        if (layout.words <= n) return n;
+    return 0;
+}
+
+vector<Marking> fixedReachability(const PetriNet& net,
+                                  const PlaceBounds& bounds,
+                                  ParentTable* parents, BudgetMonitor* budget,
+                                  int* words, EdgeTable* edges) {
+    PROFILE_SCOPE("fixedReachability");
+    FieldLayout L = fieldLayout(net, bounds.bound);
+    int n = fixedStateWords(L);
+    if (words) *words = n;
+    vector<Marking> reachableMarkings;
+    switch (n) {
+        case 1:
+            reachableMarkings = fixedBfs<1>(net, L, parents, budget, edges);
+            break;
+        case 2:
+            reachableMarkings = fixedBfs<2>(net, L, parents, budget, edges);
+            break;
+        case 4:
+            reachableMarkings = fixedBfs<4>(net, L, parents, budget, edges);
+            break;
+        case 8:
+            reachableMarkings = fixedBfs<8>(net, L, parents, budget, edges);
+            break;
+        case 16:
+            reachableMarkings = fixedBfs<16>(net, L, parents, budget, edges);
+            break;
+        default:
+            if (bounds.oneSafe())
+                return explicitReachability(net, parents, budget, edges);
+            return explicitReachability(net, markingWidth(bounds), parents,
+                                        budget, edges);
+    }
+
+    cout << "--- Task 2 Results (Explicit Reachability, " << n
+         << "-word states) ---" << endl;
+    cout << "Total reachable markings found: " << reachableMarkings.size()
+         << endl;
+    return reachableMarkings;
+}
@@ -0,0 +1,228 @@
+#include "guided_search.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <map>
+#include <queue>
+
+#include "bounds.h"
+#include "profiler.h"
+#include "reachability.h"
+#include "simplex.h"
+
+using namespace std;
+
+namespace {
+
+const int INFEASIBLE = INT_MAX;
+
+// Distance estimate from a marking to the goal
+class Estimator {
+   public:
+    Estimator(const PetriNet& net, const GuidedSearchOptions& opt)
+        : net_(net), opt_(opt) {
+        P_ = static_cast<int>(net.places.size());
+        T_ = static_cast<int>(net.transitions.size());
+        useLP_ = opt.heuristic == SearchHeuristic::StateEquation;
+        if (useLP_ && opt.goal == SearchGoal::Deadlock) {
+            // the disabling rows are only sound when no place exceeds 1
+            useLP_ = opt.bounds ? opt.bounds->oneSafe()
+                                : computePlaceBounds(net).oneSafe();
+        }
+        if (!useLP_) return;
+
+        // sigma >= 0, minimize sum(sigma) as maximize -sum(sigma)
+        const vector<vector<int>>& C = net.incidenceMatrix;
+        lp_.c.assign(T_, -1.0);
+        for (int p = 0; p < P_; ++p) {
+            lp_.A.push_back(vector<double>(C[p].begin(), C[p].end()));
+            lp_.sense.push_back(opt.goal == SearchGoal::Reach ? '=' : '>');
+            lp_.b.push_back(0);
+        }
+        if (opt.goal == SearchGoal::Deadlock) {
+            // sum_{p in pre t} M'(p) <= |pre t| - 1
+            for (int t = 0; t < T_; ++t) {
+                vector<double> row(T_, 0.0);
+                vector<int> pre;
+                for (int p = 0; p < P_; ++p) {
+                    if (C[p][t] >= 0) continue;
+                    pre.push_back(p);
+                    for (int u = 0; u < T_; ++u) row[u] += C[p][u];
+                }
+                disabling_.push_back(pre);
+                lp_.A.push_back(row);
+                lp_.sense.push_back('<');
+                lp_.b.push_back(0);
+            }
+        }
+    }
+
+    // Lower bound on the firings left (LP), a score (Tokens), or
+    // INFEASIBLE when the LP proves the goal unreachable
+    int operator()(const Marking& M) {
+        if (!useLP_) return tokens(M);
+        for (int p = 0; p < P_; ++p) {
+            bool dead = opt_.goal == SearchGoal::Deadlock;
+            lp_.b[p] = (dead ? 0.0 : opt_.target[p]) - M[p];
+        }
+        if (opt_.goal == SearchGoal::Deadlock) {
+            for (int t = 0; t < T_; ++t) {
+                double have = 0;
+                for (int p : disabling_[t]) have += M[p];
+                lp_.b[P_ + t] =
+                    static_cast<double>(disabling_[t].size()) - 1 - have;
+            }
+        }
+        LPResult res = solveLP(lp_);
+        if (res.status == LPResult::Infeasible) return INFEASIBLE;
+        if (res.status != LPResult::Optimal) return 0;
+        return static_cast<int>(ceil(-res.value - 1e-7));
+    }
+
+    // LP estimates are only solved for markings taken off the queue
+    bool costly() const { return useLP_; }
+
+    bool goal(const Marking& M) const {
+        switch (opt_.goal) {
+            case SearchGoal::Reach:
+                return M == opt_.target;
+            case SearchGoal::Cover:
+                for (int p = 0; p < P_; ++p) {
+                    if (M[p] < opt_.target[p]) return false;
+                }
+                return true;
+            default:
+                for (int t = 0; t < T_; ++t) {
+                    if (is_enabled(M, t, net_)) return false;
+                }
+                return true;
+        }
+    }
+
+   private:
+    int tokens(const Marking& M) const {
+        int h = 0;
+        if (opt_.goal == SearchGoal::Deadlock) {
+            for (int t = 0; t < T_; ++t) h += is_enabled(M, t, net_);
+        } else {
+            for (int p = 0; p < P_; ++p) {
+                int d = opt_.target[p] - M[p];
+                if (opt_.goal == SearchGoal::Reach) {
+                    h += abs(d);
+                } else if (d > 0) {
+                    h += d;
+                }
+            }
+        }
+        return h;
+    }
+
+    const PetriNet& net_;
+    const GuidedSearchOptions& opt_;
+    int P_ = 0, T_ = 0;
+    bool useLP_ = false;
+    LinearProgram lp_;
+    vector<vector<int>> disabling_;
+};
+
+struct Entry {
+    int f;
+    int g;
+    int id;
+    // min-heap on f, deeper first among equals
+    bool operator<(const Entry& o) const {
+        return f != o.f ? f > o.f : g < o.g;
+    }
+};
+
+}  // namespace
+
+GuidedSearchResult guidedSearch(const PetriNet& net,
+                                const GuidedSearchOptions& opt) {
+    PROFILE_SCOPE("guidedSearch");
+    GuidedSearchOptions options = opt;
+    options.target.resize(net.places.size(), 0);
+    Estimator estimate(net, options);
+    int T = static_cast<int>(net.transitions.size());
+    GuidedSearchResult res;
+
+    // markings by id, with the best known g, h and the parent link. Until
+    // its LP is solved (solved[id]), h is the parent's minus one: one firing
+    // lowers the LP estimate by at most one, so A* stays admissible.
+    map<Marking, int> ids;
+    vector<const Marking*> marking;
+    vector<int> g, h, parent, via;
+    vector<char> solved;
+    priority_queue<Entry> open;
+    auto priority = [&](int id) {
+        return options.greedy ? h[id] : g[id] + h[id];
+    };
+
+    auto push = [&](const Marking& M, int depth, int from, int t) {
+        auto found = ids.find(M);
+        if (found != ids.end()) {
+            int id = found->second;
+            if (h[id] == INFEASIBLE || depth >= g[id]) return;
+            g[id] = depth;  // shorter path: reopen
+            parent[id] = from;
+            via[id] = t;
+            open.push({priority(id), depth, id});
+            return;
+        }
+        ++res.generated;
+        bool lazy = estimate.costly() && from >= 0;
+        int estimateM = !lazy          ? estimate(M)
+                        : options.greedy ? h[from]
+                                         : max(0, h[from] - 1);
+        int id = static_cast<int>(marking.size());
+        marking.push_back(&ids.emplace(M, id).first->first);
+        g.push_back(depth);
+        h.push_back(estimateM);
+        solved.push_back(!lazy);
+        parent.push_back(from);
+        via.push_back(t);
+        if (estimateM == INFEASIBLE) {
+            ++res.pruned;  // kept in ids so that its LP is not solved again
+            return;
+        }
+        open.push({priority(id), depth, id});
+    };
+
+    push(net.initialMarking, 0, -1, -1);
+    while (!open.empty()) {
+        Entry e = open.top();
+        open.pop();
+        if (e.g != g[e.id] || h[e.id] == INFEASIBLE) continue;  // stale
+        const Marking& M = *marking[e.id];
+        if (!solved[e.id] && !estimate.goal(M)) {
+            solved[e.id] = true;
+            h[e.id] = estimate(M);
+            if (h[e.id] == INFEASIBLE) {
+                ++res.pruned;
+                continue;
+            }
+            if (priority(e.id) > e.f) {
+                open.push({priority(e.id), e.g, e.id});  // back in line
+                continue;
+            }
+        }
+        ++res.expanded;
+        if (estimate.goal(M)) {
+            res.found = true;
+            res.marking = M;
+            for (int id = e.id; parent[id] >= 0; id = parent[id])
+                res.trace.push_back(via[id]);
+            reverse(res.trace.begin(), res.trace.end());
+            return res;
+        }
+        if (res.generated >= options.maxStates) return res;
+        for (int t = 0; t < T; ++t) {
+            if (is_enabled(M, t, net))
+                push(fire_transition(M, t, net), e.g + 1, e.id, t);
+        }
+    }
+    res.exhausted = true;
+    return res;
+}
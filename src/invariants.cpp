@@ -0,0 +1,220 @@
+#include "invariants.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <numeric>
+
+using namespace std;
+
+namespace {
+
+long long coefficientAt(const SparseVector& v, int index) {
+    auto it = lower_bound(v.begin(), v.end(), make_pair(index, LLONG_MIN));
+    return (it != v.end() && it->first == index) ? it->second : 0;
+}
+
+// a * v - b * w
+SparseVector combine(long long a, const SparseVector& v, long long b,
+                     const SparseVector& w) {
+    SparseVector out;
+    out.reserve(v.size() + w.size());
+    size_t i = 0, j = 0;
+    while (i < v.size() || j < w.size()) {
+        int index;
+        long long value;
+        if (j == w.size() || (i < v.size() && v[i].first < w[j].first)) {
+            index = v[i].first;
+            value = a * v[i++].second;
+        } else if (i == v.size() || w[j].first < v[i].first) {
+            index = w[j].first;
+            value = -b * w[j++].second;
+        } else {
+            index = v[i].first;
+            value = a * v[i++].second - b * w[j++].second;
+        }
+        if (value != 0) out.push_back({index, value});
+    }
+    return out;
+}
+
+// Divides by the gcd of the entries
+void normalize(SparseVector& v) {
+    long long g = 0;
+    for (const auto& e : v) g = gcd(g, llabs(e.second));
+    if (g > 1) {
+        for (auto& e : v) e.second /= g;
+    }
+}
+
+// A row of [A | I] during elimination: lhs over the columns of A, rhs over
+// the identity part.
+struct Row {
+    SparseVector lhs;
+    SparseVector rhs;
+};
+
+// Basis of { y | y^T A = 0 } for A given as sparse rows. Each column of A
+// is cleared with the sparsest row that has it as pivot.
+InvariantBasis leftKernel(const vector<SparseVector>& A, int columns) {
+    vector<Row> rows(A.size());
+    for (size_t i = 0; i < A.size(); ++i) {
+        rows[i].lhs = A[i];
+        rows[i].rhs = {{static_cast<int>(i), 1}};
+    }
+    vector<bool> active(rows.size(), true);
+
+    for (int col = 0; col < columns; ++col) {
+        int pivot = -1;
+        size_t best = 0;
+        for (size_t i = 0; i < rows.size(); ++i) {
+            if (!active[i] || coefficientAt(rows[i].lhs, col) == 0) continue;
+            size_t weight = rows[i].lhs.size() + rows[i].rhs.size();
+            if (pivot < 0 || weight < best) {
+                pivot = static_cast<int>(i);
+                best = weight;
+            }
+        }
+        if (pivot < 0) continue;
+        active[pivot] = false;
+
+        long long a = coefficientAt(rows[pivot].lhs, col);
+        for (size_t i = 0; i < rows.size(); ++i) {
+            if (!active[i]) continue;
+            long long b = coefficientAt(rows[i].lhs, col);
+            if (b == 0) continue;
+            long long g = gcd(llabs(a), llabs(b));
+            Row& r = rows[i];
+            r.lhs = combine(a / g, r.lhs, b / g, rows[pivot].lhs);
+            r.rhs = combine(a / g, r.rhs, b / g, rows[pivot].rhs);
+            SparseVector both = r.lhs;
+            both.insert(both.end(), r.rhs.begin(), r.rhs.end());
+            long long d = 0;
+            for (const auto& e : both) d = gcd(d, llabs(e.second));
+            if (d > 1) {
+                for (auto& e : r.lhs) e.second /= d;
+                for (auto& e : r.rhs) e.second /= d;
+            }
+        }
+    }
+
+    InvariantBasis basis;
+    for (size_t i = 0; i < rows.size(); ++i) {
+        if (!active[i]) continue;  // used as a pivot
+        SparseVector y = rows[i].rhs;
+        normalize(y);
+        // first non-zero positive, for stable output
+        if (!y.empty() && y.front().second < 0) {
+            for (auto& e : y) e.second = -e.second;
+        }
+        basis.vectors.push_back(y);
+    }
+    return basis;
+}
+
+vector<SparseVector> sparseRows(const vector<vector<int>>& M, bool transpose) {
+    int rows = static_cast<int>(M.size());
+    int cols = rows ? static_cast<int>(M[0].size()) : 0;
+    vector<SparseVector> out(transpose ? cols : rows);
+    for (int i = 0; i < rows; ++i) {
+        for (int j = 0; j < cols; ++j) {
+            if (M[i][j] == 0) continue;
+            if (transpose) {
+                out[j].push_back({i, M[i][j]});
+            } else {
+                out[i].push_back({j, M[i][j]});
+            }
+        }
+    }
+    return out;
+}
+
+}  // namespace
+
+InvariantBasis pInvariantBasis(const vector<vector<int>>& C) {
+    int T = C.empty() ? 0 : static_cast<int>(C[0].size());
+    return leftKernel(sparseRows(C, false), T);
+}
+
+InvariantBasis tInvariantBasis(const vector<vector<int>>& C) {
+    return leftKernel(sparseRows(C, true), static_cast<int>(C.size()));
+}
+
+Marking PlaceCompression::compress(const Marking& full) const {
+    Marking m(kept.size());
+    for (size_t i = 0; i < kept.size(); ++i) m[i] = full[kept[i]];
+    return m;
+}
+
+Marking PlaceCompression::expand(const Marking& compressed) const {
+    Marking full(places, 0);
+    for (size_t i = 0; i < kept.size(); ++i) full[kept[i]] = compressed[i];
+    for (const auto& ip : implied) {
+        long long value = ip.constant;
+        for (const auto& term : ip.terms) {
+            value -= term.second * full[term.first];
+        }
+        full[ip.place] = static_cast<int>(value / ip.divisor);
+    }
+    return full;
+}
+
+PlaceCompression compressPlaces(const PetriNet& net) {
+    PlaceCompression pc;
+    pc.places = static_cast<int>(net.places.size());
+    vector<SparseVector> rows = pInvariantBasis(net.incidenceMatrix).vectors;
+
+    // Reduce the basis so that every vector owns a pivot place that no
+    // other vector mentions; that place is then implied by the others.
+    vector<int> pivots(rows.size(), -1);
+    for (size_t i = 0; i < rows.size(); ++i) {
+        if (rows[i].empty()) continue;
+        // a unit coefficient keeps the division exact and the BDD guard
+        // small; otherwise the smallest one
+        auto pick = rows[i].begin();
+        for (auto it = rows[i].begin(); it != rows[i].end(); ++it) {
+            if (llabs(it->second) < llabs(pick->second)) pick = it;
+        }
+        int p = pick->first;
+        long long a = pick->second;
+        pivots[i] = p;
+        for (size_t j = 0; j < rows.size(); ++j) {
+            long long b = (j == i) ? 0 : coefficientAt(rows[j], p);
+            if (b == 0) continue;
+            long long g = gcd(llabs(a), llabs(b));
+            rows[j] = combine(a / g, rows[j], b / g, rows[i]);
+            normalize(rows[j]);
+        }
+    }
+
+    vector<bool> isImplied(pc.places, false);
+    for (size_t i = 0; i < rows.size(); ++i) {
+        if (pivots[i] >= 0) isImplied[pivots[i]] = true;
+    }
+    for (int p = 0; p < pc.places; ++p) {
+        if (!isImplied[p]) pc.kept.push_back(p);
+    }
+
+    for (size_t i = 0; i < rows.size(); ++i) {
+        if (pivots[i] < 0) continue;
+        const SparseVector& y = rows[i];
+        ImpliedPlace ip;
+        ip.place = pivots[i];
+        ip.constant = 0;
+        for (const auto& e : y) {
+            ip.constant += e.second * net.initialMarking[e.first];
+        }
+        ip.divisor = coefficientAt(y, ip.place);
+        for (const auto& e : y) {
+            if (e.first != ip.place) ip.terms.push_back(e);
+        }
+        if (ip.divisor < 0) {
+            ip.divisor = -ip.divisor;
+            ip.constant = -ip.constant;
+            for (auto& t : ip.terms) t.second = -t.second;
+        }
+        pc.implied.push_back(ip);
+        pc.invariants.vectors.push_back(y);
+    }
+    return pc;
+}
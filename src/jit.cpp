@@ -0,0 +1,352 @@
+#include "jit.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+#include "profiler.h"
+
+using namespace std;
+
+namespace {
+
+#ifdef _WIN32
+const char* OBJECT_EXT = ".dll";
+#else
+const char* OBJECT_EXT = ".so";
+#endif
+
+uint64_t fnv(const string& s) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (unsigned char c : s) {
+        h ^= c;
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+// Transition ids go into line comments: keep them on one line
+string commentSafe(const string& id) {
+    string out;
+    for (char c : id) out += (c == '\n' || c == '\r') ? ' ' : c;
+    return out;
+}
+
+void* openObject(const string& path, string& error) {
+#ifdef _WIN32
+    HMODULE h = LoadLibraryA(path.c_str());
+    if (!h) error = "cannot load " + path;
+    return reinterpret_cast<void*>(h);
+#else
+    void* h = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!h) error = dlerror();
+    return h;
+#endif
+}
+
+void* findSymbol(void* handle, const char* name) {
+#ifdef _WIN32
+    return reinterpret_cast<void*>(
+        GetProcAddress(reinterpret_cast<HMODULE>(handle), name));
+#else
+    return dlsym(handle, name);
+#endif
+}
+
+void closeObject(void* handle) {
+#ifdef _WIN32
+    FreeLibrary(reinterpret_cast<HMODULE>(handle));
+#else
+    dlclose(handle);
+#endif
+}
+
+uint64_t splitmix(uint64_t& state) {
+    uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+// Table index from the additive hash, whose low bits mix poorly
+uint64_t mix(uint64_t h) {
+    h ^= h >> 32;
+    h *= 0xd6e8feb86659fd93ull;
+    return h ^ (h >> 32);
+}
+
+string hex(uint64_t v) {
+    char s[24];
+    snprintf(s, sizeof(s), "0x%016llxull",
+             static_cast<unsigned long long>(v));
+    return s;
+}
+
+// pre(t) and post(t) - pre(t), per word of the layout; the difference
+// wraps, and adding it to an enabled marking neither borrows nor carries
+void packedArcs(const PetriNet& net, const FieldLayout& L, int t,
+                vector<uint64_t>& pre, vector<uint64_t>& delta) {
+    pre.assign(L.words, 0);
+    delta.assign(L.words, 0);
+    for (size_t p = 0; p < net.places.size(); ++p) {
+        int c = net.incidenceMatrix[p][t];
+        uint64_t field = uint64_t(abs(c)) << L.shift[p];
+        if (c < 0) pre[L.word[p]] |= field;
+        if (c < 0) delta[L.word[p]] -= field;
+        if (c > 0) delta[L.word[p]] += field;
+    }
+}
+
+}  // namespace
+
+string generateNetSource(const PetriNet& net, const FieldLayout& L) {
+    int P = static_cast<int>(net.places.size());
+    int T = static_cast<int>(net.transitions.size());
+    int W = L.words;
+    vector<uint64_t> H(W, 0), pre, delta;
+    for (int p = 0; p < P; ++p)
+        H[L.word[p]] |= uint64_t(1) << (L.shift[p] + L.bits[p] - 1);
+    ostringstream src;
+    src << "// Generated by generateNetSource (jit.h): " << P << " places in "
+        << W << " word(s), " << T << " transitions\n"
+        << "#include <cstdint>\n#include <cstring>\n\n"
+        << "#ifdef _WIN32\n#define PN_EXPORT __declspec(dllexport)\n"
+        << "#else\n#define PN_EXPORT\n#endif\n\n"
+        << "using std::uint64_t;\n\n"
+        << "extern \"C\" {\n\n"
+        << "PN_EXPORT int pn_places() { return " << P << "; }\n"
+        << "PN_EXPORT int pn_words() { return " << W << "; }\n"
+        << "PN_EXPORT int pn_transitions() { return " << T << "; }\n\n"
+        << "PN_EXPORT int pn_successors(const uint64_t* m, uint64_t* out, "
+           "int* via) {\n"
+        << "    int n = 0;\n"
+        << "    uint64_t* o;\n";
+    for (int t = 0; t < T; ++t) {
+        packedArcs(net, L, t, pre, delta);
+        src << "    // " << commentSafe(net.transitions[t].id) << "\n    ";
+        string guard;
+        for (int w = 0; w < W; ++w) {
+            if (!pre[w]) continue;
+            string h = hex(H[w]);
+            guard += (guard.empty() ? "" : " &&\n        ") + string("(((m[") +
+                     to_string(w) + "] | " + h + ") - " + hex(pre[w]) +
+                     ") & " + h + ") == " + h;
+        }
+        if (!guard.empty()) src << "if (" << guard << ") ";
+        src << "{\n"
+            << "        o = out + n * " << W << ";\n"
+            << "        std::memcpy(o, m, sizeof(uint64_t) * " << W << ");\n";
+        for (int w = 0; w < W; ++w) {
+            if (delta[w])
+                src << "        o[" << w << "] += " << hex(delta[w]) << ";\n";
+        }
+        src << "        via[n++] = " << t << ";\n    }\n";
+    }
+    src << "    return n;\n}\n\n}  // extern \"C\"\n";
+    return src.str();
+}
+
+bool loadCompiledNet(const PetriNet& net, const FieldLayout& layout,
+                     const JitOptions& opt, CompiledNet& out,
+                     string& error) {
+    PROFILE_SCOPE("loadCompiledNet");
+    out = CompiledNet();
+    string source = generateNetSource(net, layout);
+    char name[32];
+    snprintf(name, sizeof(name), "net_%016llx",
+             static_cast<unsigned long long>(fnv(source)));
+    filesystem::path dir = opt.cacheDir;
+    string base = (dir / name).string();
+    out.path = base + OBJECT_EXT;
+
+    error_code ec;
+    out.cached = filesystem::exists(out.path, ec);
+    if (!out.cached) {
+        auto start = chrono::steady_clock::now();
+        filesystem::create_directories(dir, ec);
+        // unique temporaries, renamed into place once complete
+        string tag = to_string(
+            chrono::steady_clock::now().time_since_epoch().count());
+        string cpp = base + "." + tag + ".cpp";
+        string tmp = base + "." + tag + OBJECT_EXT;
+        string log = base + "." + tag + ".log";
+        {
+            ofstream f(cpp);
+            f << source;
+            if (!f) {
+                error = "cannot write " + cpp;
+                f.close();
+                filesystem::remove(cpp, ec);
+                return false;
+            }
+        }
+        string cmd = "\"" + opt.compiler +
+                     "\" -std=c++17 -O2 -shared -fPIC -o \"" + tmp +
+                     "\" \"" + cpp + "\" 2> \"" + log + "\"";
+        int status = system(cmd.c_str());
+        if (status != 0 || !filesystem::exists(tmp, ec)) {
+            ifstream in(log);
+            string first;
+            getline(in, first);
+            in.close();
+            error = opt.compiler + " failed" +
+                    (first.empty() ? string() : ": " + first);
+            for (const string& f : {tmp, cpp, log}) filesystem::remove(f, ec);
+            return false;
+        }
+        filesystem::rename(tmp, out.path, ec);
+        filesystem::rename(cpp, base + ".cpp", ec);  // kept for reading
+        filesystem::remove(log, ec);
+        out.compileMs = chrono::duration<double, milli>(
+                            chrono::steady_clock::now() - start)
+                            .count();
+    }
+
+    out.handle = openObject(out.path, error);
+    if (!out.handle) return false;
+    auto places = reinterpret_cast<int (*)()>(
+        findSymbol(out.handle, "pn_places"));
+    auto words = reinterpret_cast<int (*)()>(
+        findSymbol(out.handle, "pn_words"));
+    auto transitions = reinterpret_cast<int (*)()>(
+        findSymbol(out.handle, "pn_transitions"));
+    out.successors = reinterpret_cast<SuccessorsFn>(
+        findSymbol(out.handle, "pn_successors"));
+    if (!places || !words || !transitions || !out.successors ||
+        places() != static_cast<int>(net.places.size()) ||
+        words() != layout.words ||
+        transitions() != static_cast<int>(net.transitions.size())) {
+        error = out.path + " does not match the net";
+        unloadCompiledNet(out);
+        return false;
+    }
+    out.places = places();
+    out.transitions = transitions();
+    out.layout = layout;
+    return true;
+}
+
+void unloadCompiledNet(CompiledNet& cn) {
+    if (cn.handle) closeObject(cn.handle);
+    cn.handle = nullptr;
+    cn.successors = nullptr;
+}
+
+// Markings as rows of layout.words packed words in BFS order, kept in
+// blocks that never move, so the successors are computed straight from a
+// row; open addressing over state indices is the visited set. The hash is
+// additive, sum row[w] * R[w], so firing t adds a constant D[t] to it and
+// a successor is hashed without reading its row.
+vector<Marking> jitReachability(const PetriNet& net, const CompiledNet& cn,
+                                ParentTable* parents, BudgetMonitor* budget) {
+    PROFILE_SCOPE("jitReachability");
+    const FieldLayout& L = cn.layout;
+    int P = cn.places;
+    int T = cn.transitions;
+    int W = L.words;
+    vector<uint64_t> R(W), D(T, 0), pre, delta;
+    uint64_t seed = 0x9e3779b97f4a7c15ull;
+    for (int w = 0; w < W; ++w) R[w] = splitmix(seed);
+    for (int t = 0; t < T; ++t) {
+        packedArcs(net, L, t, pre, delta);
+        for (int w = 0; w < W; ++w) D[t] += delta[w] * R[w];
+    }
+    auto hashOf = [&](const uint64_t* row) {
+        uint64_t h = 0;
+        for (int w = 0; w < W; ++w) h += row[w] * R[w];
+        return h;
+    };
+
+    const int SHIFT = 12;  // 4096 states per block
+    const size_t BLOCK = size_t(1) << SHIFT;
+    vector<vector<uint64_t>> blocks;
+    auto row = [&](size_t s) {
+        return blocks[s >> SHIFT].data() + (s & (BLOCK - 1)) * W;
+    };
+    vector<uint32_t> slots(1024, 0);  // state index + 1, 0: empty
+    size_t n = 0;
+    auto insert = [&](const uint64_t* next, uint64_t hash) {
+        if (2 * (n + 1) > slots.size()) {
+            vector<uint32_t> grown(2 * slots.size(), 0);
+            size_t mask = grown.size() - 1;
+            for (size_t s = 0; s < n; ++s) {
+                size_t h = mix(hashOf(row(s))) & mask;
+                while (grown[h]) h = (h + 1) & mask;
+                grown[h] = static_cast<uint32_t>(s + 1);
+            }
+            slots.swap(grown);
+        }
+        size_t mask = slots.size() - 1;
+        for (size_t h = mix(hash) & mask;; h = (h + 1) & mask) {
+            if (!slots[h]) {
+                if ((n & (BLOCK - 1)) == 0) blocks.emplace_back(BLOCK * W);
+                copy(next, next + W, row(n));
+                slots[h] = static_cast<uint32_t>(++n);
+                return true;
+            }
+            if (!memcmp(row(slots[h] - 1), next, sizeof(uint64_t) * W))
+                return false;
+        }
+    };
+
+    vector<uint64_t> M0(W, 0);
+    for (int p = 0; p < P; ++p)
+        M0[L.word[p]] |= uint64_t(net.initialMarking[p]) << L.shift[p];
+    insert(M0.data(), hashOf(M0.data()));
+    if (parents) {
+        parents->reset(T);
+        parents->record(ParentTable::NONE, 0);
+    }
+
+    vector<uint64_t> succ(size_t(max(1, T)) * W);
+    vector<int> via(max(1, T));
+    size_t head = 0;
+    for (; head < n; ++head) {
+        if (budget && (head & 1023) == 0 && budget->exhausted()) {
+            budget->progress(head, double(n - head));
+            break;
+        }
+        const uint64_t* M = row(head);
+        uint64_t hash = hashOf(M);
+        int found = cn.successors(M, succ.data(), via.data());
+        for (int j = 0; j < found; ++j) {
+            if (insert(succ.data() + size_t(j) * W, hash + D[via[j]]) &&
+                parents)
+                parents->record(static_cast<uint32_t>(head), via[j]);
+        }
+    }
+
+    // unpacked a block at a time, each freed once read
+    vector<uint32_t>().swap(slots);
+    vector<Marking> reachableMarkings;
+    reachableMarkings.reserve(head);
+    for (size_t s = 0; s < head; ++s) {
+        const uint64_t* M = row(s);
+        Marking m(P);
+        for (int p = 0; p < P; ++p) {
+            uint64_t mask = (uint64_t(1) << L.bits[p]) - 1;
+            m[p] = static_cast<int>((M[L.word[p]] >> L.shift[p]) & mask);
+        }
+        reachableMarkings.push_back(move(m));
+        if (((s + 1) & (BLOCK - 1)) == 0)
+            vector<uint64_t>().swap(blocks[s >> SHIFT]);
+    }
+    blocks.clear();
+
+    cout << "--- Task 2 Results (Explicit Reachability, jit) ---" << endl;
+    cout << "Total reachable markings found: " << reachableMarkings.size()
+         << endl;
+    return reachableMarkings;
+}
@@ -1,15 +1,20 @@
 #include <algorithm>  // Required for std::min
 #include <chrono>
+#include <fstream>
 #include <iostream>
 #include <string>
 #include <vector>
 
+#include "analysis.h"      // Non-interactive driver (command line mode)
+#include "batch.h"         // Many nets on a worker pool (--batch)
 #include "bdd.h"           // Contains symbolicReachability (BDD, CUDD)
 #include "deadlock_ILP.h"  // Contains ...
+#include "firing_kernel.h"  // SIMD batch successors (explicit=batch)
 #include "optimization.h"  // Contains ...
 #include "pnml_parser.h"  // Contains RawData, toRaw, toPetriNet structures/functions
 #include "reachability.h"  // Contains explicitReachability
-#include "timer.h"
+#include "server.h"        // Long-running server mode (--serve)
+#include "profiler.h"
 
 using namespace std;
 
@@ -22,29 +27,31 @@ void printMarking(const Marking& M) {
     cout << "]";
 }
 
-int main() {
+// Original interactive mode: asks for N and runs every task on
+// input/input_fileN.pnml
+static int runInteractive() {
     int x;
     cout << "Enter file number (e.g., 1 for input_file1.pnml): ";
 
     // Step 1: Check toRaw function (Task 1: Raw Parsing)
     if (!(cin >> x)) {
-        cerr << "Invalid input." << endl;
+        cerr << "Invalid input." << "\n";
         return 1;
     }
 
     string fileName = string("input/") + "input_file" + to_string(x) + ".pnml";
 
-    TIME_START();
+    Prof::begin("task1_parse");
 
     // --- TASK 1: RAW PARSING ---
     RawData raw = toRaw(fileName);
-    cout << "\n--- Task 1: Raw Data Check ---" << endl;
+    cout << "\n--- Task 1: Raw Data Check ---" << "\n";
     raw.print();  // Print raw data content
-    cout << "\n-----------------------------" << endl;
+    cout << "\n-----------------------------" << "\n";
 
     // Check if RawData is empty (file opening error)
     if (raw.Blocks.empty()) {
-        cerr << "Failed to parse data or file is empty." << endl;
+        cerr << "Failed to parse data or file is empty." << "\n";
         return 1;
     }
 
@@ -52,74 +59,74 @@ int main() {
     // (This calls the toPetriNet function implemented in pnml_parser.cpp)
     PetriNet net = toPetriNet(raw);
 
-    cout << "\n--- Task 1: PetriNet Model Built ---" << endl;
+    cout << "\n--- Task 1: PetriNet Model Built ---" << "\n";
     cout << "Places: " << net.places.size()
-         << ", Transitions: " << net.transitions.size() << endl;
+         << ", Transitions: " << net.transitions.size() << "\n";
     cout << "Initial Marking M0: ";
     printMarking(net.initialMarking);
-    cout << endl;
+    cout << "\n";
 
     // Optional: Print the Incidence Matrix (for debugging)
     /*
-    cout << "Incidence Matrix (P x T):" << endl;
+    cout << "Incidence Matrix (P x T):" << "\n";
     for (const auto& row : net.incidenceMatrix) {
         for (int val : row) {
             cout << val << "\t";
         }
-        cout << endl;
+        cout << "\n";
     }
     */
-    cout << "------------------------------------" << endl;
+    cout << "------------------------------------" << "\n";
 
-    TIME_END();
+    Prof::end();
 
-    TIME_START();
+    Prof::begin("task2_explicit");
 
     // --- TASK 2: EXPLICIT REACHABILITY COMPUTATION (BFS) ---
     vector<Marking> reachableSet = explicitReachability(net);
 
-    cout << "\n--- Task 2 Results (Explicit Reachability) ---" << endl;
-    cout << "Total reachable markings found: " << reachableSet.size() << endl;
+    cout << "\n--- Task 2 Results (Explicit Reachability) ---" << "\n";
+    cout << "Total reachable markings found: " << reachableSet.size() << "\n";
 
     // Display some of the reachable Markings (if any were found)
     if (!reachableSet.empty()) {
-        cout << "\n--- Task 2: Sample Reachable Markings ---" << endl;
+        cout << "\n--- Task 2: Sample Reachable Markings ---" << "\n";
 
         // Print the first 5 Markings (or fewer)
         for (size_t i = 0; i < min((size_t)5, reachableSet.size()); ++i) {
             cout << "Marking " << i + 1 << ": ";
             printMarking(reachableSet[i]);
-            cout << endl;
+            cout << "\n";
         }
     }
 
-    TIME_END();
+    Prof::end();
 
-    TIME_START();
+    Prof::begin("task3_symbolic");
 
     // --- TASK 3: SYMBOLIC REACHABILITY (BDD + CUDD) ---
     // Hàm này đã in số lượng marking reachable bằng BDD ở trong bdd.cpp
     symbolicReachability(net);
 
-    TIME_END();
+    Prof::end();
 
-    TIME_START();
+    Prof::begin("task4_deadlock");
 
-    cout << "\n--- Task 4: Deadlock detection ---" << endl;
+    cout << "\n--- Task 4: Deadlock detection ---" << "\n";
 
     vector<int> deadlock = findDeadlock(net);
     if (deadlock.empty()) {
-        cout << "\nNo deadlock is found.\n" << endl;
+        cout << "\nNo deadlock is found.\n" << "\n";
     } else {
         printMarking(deadlock);
         cout << "\n";
     }
 
-    TIME_END();
+    Prof::end();
 
-    TIME_START();
+    Prof::begin("task5_optimization");
 
-    cout << "\n--- Task 5: Linear optimization ---" << endl;
+    cout << "\n--- Task 5: Linear optimization ---" << "\n";
 
     // dummy costs vector to test
     vector<int> costs(net.places.size(), 1);
@@ -127,7 +134,325 @@ int main() {
 
     task5_output.print();
 
-    TIME_END();
+    Prof::end();
+
+    Prof::printSummary();
+    Prof::writeReport("generated_files/profile");
 
     return 0;
 }
+
+static void printUsage() {
+    cout << "Usage: main.exe [options] <file.pnml>...\n"
+            "       main.exe --batch DIR|MANIFEST [--jobs N] [-o results.jsonl]\n"
+            "       main.exe --serve [--socket PATH] [--cache N] [--threads N]\n"
+            "       main.exe            (interactive: asks for a file number)\n"
+            "Options:\n"
+            "  --tasks LIST      tasks to run, e.g. 2,3 (default 1,2,3,4,5)\n"
+            "  --engine G=NAME   explicit=bfs|batch|jit|coverability,\n"
+            "                    symbolic=bdd|zdd|parallel,\n"
+            "                    deadlock=ilp|bdd|sim|astar|best-first|\n"
+            "                    unfolding|zdd, opt=recursive|add|zdd\n"
+            "  --threads N       worker threads for parallel engines\n"
+            "  --simd L          explicit=batch kernels: auto (default),\n"
+            "                    scalar, avx2 or avx512\n"
+            "  --jit-cache DIR   explicit=jit: compiled nets are kept in DIR\n"
+            "                    (generated_files/jit)\n"
+            "  --jit-compiler CXX\n"
+            "                    explicit=jit: C++ compiler to run (g++)\n"
+            "  --format F        human (default), json or csv\n"
+            "  --costs LIST      Task 5 costs, comma separated (default 1)\n"
+            "  --costs-pair P,Q,W\n"
+            "                    Task 5 also adds W * M(P) * M(Q), places\n"
+            "                    by index (repeatable, ADD engine)\n"
+            "  --opt-topk K      Task 5 also lists the K best reachable\n"
+            "                    markings under --costs\n"
+            "  --opt-pareto LIST Task 5 also reports the Pareto front of\n"
+            "                    the objectives given (repeatable, one\n"
+            "                    costs list each, all maximized)\n"
+            "  --costs-sweep FILE\n"
+            "                    Task 5 also maximizes every costs list of\n"
+            "                    FILE (one per line) in one BDD traversal\n"
+            "  --samples N       reachable markings shown by Task 2\n"
+            "  --cover LIST      is a marking covering LIST (tokens per\n"
+            "                    place) reachable: Karp-Miller with\n"
+            "                    explicit=coverability, else guided search\n"
+            "  --print-raw       print the parsed PNML blocks and arcs\n"
+            "  --profile PREFIX  write PREFIX.json and PREFIX.folded\n"
+            "  --walks N         deadlock=sim: random walks (1000)\n"
+            "  --walk-length N   firings per walk (100000)\n"
+            "  --seed N          random walk seed (1)\n"
+            "  --prefix-events N deadlock=unfolding: prefix event limit\n"
+            "                    (20000, 0 = none)\n"
+            "  --reach LIST      guided search for this marking\n"
+            "  --ctl FORMULA     check a CTL formula on the reachable set,\n"
+            "                    e.g. 'AG EF initial' (repeatable, see\n"
+            "                    include/ctl.h for the syntax)\n"
+            "  --heuristic H     guided search estimate: tokens (default)\n"
+            "                    or lp (state equation, admissible, one\n"
+            "                    LP per expanded marking)\n"
+            "  --search-limit N  markings a guided search may generate\n"
+            "  --compress        drop places implied by P-invariants\n"
+            "  --reduce          structural reduction before Tasks 2-4\n"
+            "  --graph           Task 2 keeps its edges: reachability graph\n"
+            "                    with its SCCs, liveness, reversibility and\n"
+            "                    home states (not with --reduce)\n"
+            "  --graph-out FILE  --graph, also written to FILE (binary CSR,\n"
+            "                    see include/reachability_graph.h)\n"
+            "  --checkpoint P    Tasks 2-3 write checkpoints to P.states and\n"
+            "                    P.bdd and resume from them when rerun\n"
+            "  --checkpoint-every SEC\n"
+            "                    seconds between checkpoints (60)\n"
+            "  --budget-time SEC wall time for Task 2 and the Task 3 BDD;\n"
+            "                    when it runs out they report what they\n"
+            "                    found so far (a lower bound)\n"
+            "  --budget-mem MB   same for resident memory\n"
+            "  --budget-nodes N  same for live BDD nodes\n"
+            "  --fallback F      after a budget stop: none (default),\n"
+            "                    bitstate (hashed DFS) or sim (random walks),\n"
+            "                    within what is left of the budget\n"
+            "  --traces          Task 2 keeps BFS parent pointers: shortest\n"
+            "                    firing sequence to the Task 4 deadlock\n"
+            "  --encoding E      auto (from token bounds, default) or safe\n"
+            "                    (1 bit per place, no bound analysis)\n"
+            "  --verbose         keep the engines' progress messages\n"
+            "  -o FILE           write the report to FILE\n"
+            "Batch mode (one JSON line per net, see include/batch.h):\n"
+            "  --batch PATH      directory of .pnml files or manifest file\n"
+            "  --jobs N          nets analyzed at once (default: all cores)\n"
+            "  --mem-budget MB   memory the running nets may reserve\n"
+            "                    (default 3/4 of physical memory)\n"
+            "  --probe N         states explored to estimate a net (20000)\n"
+            "Server mode (one JSON request per line, see include/server.h):\n"
+            "  --serve           answer requests on stdin/stdout\n"
+            "  --socket PATH     listen on a Unix socket instead\n"
+            "  --cache N         nets kept warm (default 16)\n";
+}
+
+static vector<int> parseIntList(const string& s) {
+    vector<int> out;
+    size_t start = 0;
+    while (start <= s.size()) {
+        size_t comma = s.find(',', start);
+        if (comma == string::npos) comma = s.size();
+        if (comma > start) out.push_back(stoi(s.substr(start, comma - start)));
+        start = comma + 1;
+    }
+    return out;
+}
+
+// One costs list per line; blank lines and '#' comments are skipped
+static vector<vector<int>> readCostSweep(const string& path) {
+    ifstream in(path);
+    if (!in) throw invalid_argument("cannot read " + path);
+    vector<vector<int>> sweep;
+    string line;
+    while (getline(in, line)) {
+        line = line.substr(0, line.find('#'));
+        if (line.find_first_not_of(" \t\r") == string::npos) continue;
+        sweep.push_back(parseIntList(line));
+    }
+    return sweep;
+}
+
+int main(int argc, char** argv) {
+    if (argc == 1) return runInteractive();
+
+    ios::sync_with_stdio(false);
+
+    AnalysisOptions opt;
+    OutputFormat format = OutputFormat::Human;
+    vector<string> files;
+    string outFile, profilePrefix;
+    bool printRaw = false;
+    bool serve = false;
+    ServerOptions serverOpt;
+    BatchOptions batchOpt;
+    vector<string> batchInputs;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            string arg = argv[i];
+            auto value = [&]() -> string {
+                if (i + 1 >= argc)
+                    throw invalid_argument(arg + " needs a value");
+                return argv[++i];
+            };
+            if (arg == "-h" || arg == "--help") {
+                printUsage();
+                return 0;
+            } else if (arg == "--tasks") {
+                opt.tasks.clear();
+                for (int t : parseIntList(value())) opt.tasks.insert(t);
+            } else if (arg == "--engine") {
+                string assignment = value();
+                if (!setEngine(opt, assignment))
+                    throw invalid_argument("unknown engine " + assignment);
+            } else if (arg == "--threads") {
+                opt.threads = max(1, stoi(value()));
+            } else if (arg == "--simd") {
+                opt.simd = value();
+                SimdLevel level;
+                if (!parseSimdLevel(opt.simd, level))
+                    throw invalid_argument("unknown SIMD level " + opt.simd);
+            } else if (arg == "--jit-cache") {
+                opt.jit.cacheDir = value();
+            } else if (arg == "--jit-compiler") {
+                opt.jit.compiler = value();
+            } else if (arg == "--format") {
+                string name = value();
+                if (!parseOutputFormat(name, format))
+                    throw invalid_argument("unknown format " + name);
+            } else if (arg == "--costs") {
+                opt.costs = parseIntList(value());
+            } else if (arg == "--costs-pair") {
+                vector<int> term = parseIntList(value());
+                if (term.size() != 3)
+                    throw invalid_argument("--costs-pair takes P,Q,W");
+                opt.costPairs.push_back({term[0], term[1], double(term[2])});
+            } else if (arg == "--opt-topk") {
+                opt.optTopK = max(0, stoi(value()));
+            } else if (arg == "--opt-pareto") {
+                opt.paretoObjectives.push_back(parseIntList(value()));
+            } else if (arg == "--costs-sweep") {
+                opt.costSweep = readCostSweep(value());
+            } else if (arg == "--cover") {
+                opt.coverTarget = parseIntList(value());
+            } else if (arg == "--reach") {
+                opt.reachTarget = parseIntList(value());
+            } else if (arg == "--heuristic") {
+                opt.heuristic = value();
+                if (opt.heuristic != "lp" && opt.heuristic != "tokens")
+                    throw invalid_argument("unknown heuristic " +
+                                           opt.heuristic);
+            } else if (arg == "--search-limit") {
+                opt.searchLimit = max(1L, stol(value()));
+            } else if (arg == "--walks") {
+                opt.walks = max(1L, stol(value()));
+            } else if (arg == "--walk-length") {
+                opt.walkLength = max(1L, stol(value()));
+            } else if (arg == "--ctl") {
+                opt.ctl.push_back(value());
+            } else if (arg == "--prefix-events") {
+                opt.prefixEvents = max(0L, stol(value()));
+            } else if (arg == "--seed") {
+                opt.seed = stoull(value());
+            } else if (arg == "--samples") {
+                opt.samples = stoi(value());
+            } else if (arg == "--print-raw") {
+                printRaw = true;
+            } else if (arg == "--profile") {
+                profilePrefix = value();
+            } else if (arg == "--reduce") {
+                opt.reduce = true;
+            } else if (arg == "--encoding") {
+                opt.encoding = value();
+                if (opt.encoding != "auto" && opt.encoding != "safe")
+                    throw invalid_argument("unknown encoding " + opt.encoding);
+            } else if (arg == "--compress") {
+                opt.compress = true;
+            } else if (arg == "--traces") {
+                opt.traces = true;
+            } else if (arg == "--graph") {
+                opt.graph = true;
+            } else if (arg == "--graph-out") {
+                opt.graph = true;
+                opt.graphOut = value();
+            } else if (arg == "--checkpoint") {
+                opt.checkpoint = value();
+            } else if (arg == "--checkpoint-every") {
+                opt.checkpointEvery = max(0.0, stod(value()));
+            } else if (arg == "--budget-time") {
+                opt.budget.seconds = max(0.0, stod(value()));
+            } else if (arg == "--budget-mem") {
+                opt.budget.memoryMB = max(0L, stol(value()));
+            } else if (arg == "--budget-nodes") {
+                opt.budget.bddNodes = max(0L, stol(value()));
+            } else if (arg == "--fallback") {
+                opt.fallback = value();
+                if (opt.fallback != "none" && opt.fallback != "bitstate" &&
+                    opt.fallback != "sim")
+                    throw invalid_argument("unknown fallback " + opt.fallback);
+            } else if (arg == "--verbose") {
+                opt.verbose = true;
+            } else if (arg == "--batch") {
+                batchInputs.push_back(value());
+            } else if (arg == "--jobs") {
+                batchOpt.jobs = max(1, stoi(value()));
+            } else if (arg == "--mem-budget") {
+                batchOpt.memoryBudget = size_t(max(1, stoi(value()))) << 20;
+            } else if (arg == "--probe") {
+                batchOpt.probeStates = max(1, stoi(value()));
+            } else if (arg == "--serve") {
+                serve = true;
+            } else if (arg == "--socket") {
+                serve = true;
+                serverOpt.socketPath = value();
+            } else if (arg == "--cache") {
+                serverOpt.cacheSize = max(1, stoi(value()));
+            } else if (arg == "-o") {
+                outFile = value();
+            } else if (!arg.empty() && arg[0] == '-') {
+                throw invalid_argument("unknown option " + arg);
+            } else {
+                files.push_back(arg);
+            }
+        }
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << "\n";
+        printUsage();
+        return 2;
+    }
+    // closed profiler regions are kept for --profile only: a server or a
+    // long batch would otherwise collect them without end
+    Prof::Registry::instance().setRecording(!serve && !profilePrefix.empty());
+    if (serve) {
+        serverOpt.threads = opt.threads;
+        return runServer(serverOpt);
+    }
+    for (const auto& input : batchInputs) {
+        vector<string> found = collectBatchInputs(input);
+        if (found.empty()) cerr << "Warning: no nets in " << input << "\n";
+        files.insert(files.end(), found.begin(), found.end());
+    }
+    if (files.empty()) {
+        printUsage();
+        return 2;
+    }
+
+    ofstream fileOut;
+    if (!outFile.empty()) {
+        fileOut.open(outFile);
+        if (!fileOut.is_open()) {
+            cerr << "Error: cannot write " << outFile << "\n";
+            return 2;
+        }
+    }
+    ostream& out = outFile.empty() ? cout : fileOut;
+
+    if (!batchInputs.empty()) {
+        // workers mute cout while they run; results bypass that switch
+        ostream results(out.rdbuf());
+        batchOpt.analysis = opt;
+        int failed = runBatch(files, batchOpt, results);
+        if (!profilePrefix.empty()) Prof::writeReport(profilePrefix);
+        return failed == 0 ? 0 : 1;
+    }
+
+    if (format == OutputFormat::CSV) out << csvHeader();
+    int failures = 0;
+    for (const auto& file : files) {
+        if (printRaw && format == OutputFormat::Human) {
+            RawData raw = toRaw(file);
+            raw.print();
+            cout << "\n";
+        }
+        AnalysisReport report = analyzeFile(file, opt);
+        if (!report.error.empty()) ++failures;
+        out << formatReport(report, format);
+    }
+    out.flush();
+
+    if (!profilePrefix.empty()) Prof::writeReport(profilePrefix);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,212 @@
+#include "net_generator.h"
+
+namespace {
+
+// Collects blocks and arcs; pre/post are place ids.
+struct NetBuilder {
+    RawData raw;
+    int arcCount = 0;
+
+    string place(const string& name, int index, int tokens) {
+        string id = "p_" + name + to_string(index);
+        raw.Blocks.push_back({id, tokens});
+        return id;
+    }
+
+    void transition(const string& name, int index, const vector<string>& pre,
+                    const vector<string>& post) {
+        string id = "t_" + name + to_string(index);
+        raw.Blocks.push_back({id, -1});
+        for (const auto& p : pre) {
+            raw.Arcs.push_back({"a" + to_string(arcCount++), p, id});
+        }
+        for (const auto& p : post) {
+            raw.Arcs.push_back({"a" + to_string(arcCount++), id, p});
+        }
+    }
+};
+
+RawData philosophersNet(int N) {
+    NetBuilder b;
+    vector<string> think(N), left(N), eat(N), fork(N);
+    for (int i = 0; i < N; ++i) {
+        think[i] = b.place("think", i, 1);
+        left[i] = b.place("hasLeft", i, 0);
+        eat[i] = b.place("eat", i, 0);
+        fork[i] = b.place("fork", i, 1);
+    }
+    for (int i = 0; i < N; ++i) {
+        int next = (i + 1) % N;
+        b.transition("takeLeft", i, {think[i], fork[i]}, {left[i]});
+        b.transition("takeRight", i, {left[i], fork[next]}, {eat[i]});
+        b.transition("release", i, {eat[i]}, {think[i], fork[i], fork[next]});
+    }
+    return b.raw;
+}
+
+RawData tokenRingNet(int N) {
+    NetBuilder b;
+    vector<string> idle(N), crit(N), token(N);
+    for (int i = 0; i < N; ++i) {
+        idle[i] = b.place("idle", i, 1);
+        crit[i] = b.place("crit", i, 0);
+        token[i] = b.place("token", i, i == 0 ? 1 : 0);
+    }
+    for (int i = 0; i < N; ++i) {
+        int next = (i + 1) % N;
+        b.transition("enter", i, {idle[i], token[i]}, {crit[i]});
+        b.transition("leave", i, {crit[i]}, {idle[i], token[next]});
+        b.transition("pass", i, {token[i]}, {token[next]});
+    }
+    return b.raw;
+}
+
+RawData kanbanNet(int N) {
+    NetBuilder b;
+    vector<string> card(N), busy(N), check(N), done(N);
+    for (int i = 0; i < N; ++i) {
+        card[i] = b.place("card", i, 1);
+        busy[i] = b.place("busy", i, 0);
+        check[i] = b.place("check", i, 0);
+        done[i] = b.place("done", i, 0);
+    }
+    for (int i = 0; i < N; ++i) {
+        // entering cell i hands the card of cell i-1 back
+        if (i == 0) {
+            b.transition("start", i, {card[i]}, {busy[i]});
+        } else {
+            b.transition("start", i, {card[i], done[i - 1]},
+                         {busy[i], card[i - 1]});
+        }
+        b.transition("work", i, {busy[i]}, {check[i]});
+        b.transition("ok", i, {check[i]}, {done[i]});
+        b.transition("rework", i, {check[i]}, {busy[i]});
+    }
+    b.transition("out", N - 1, {done[N - 1]}, {card[N - 1]});
+    return b.raw;
+}
+
+RawData fmsNet(int N) {
+    NetBuilder b;
+    string robot = b.place("robot", 0, 1);
+    vector<string> idle(N), loaded(N), busy(N), finished(N), unloaded(N);
+    for (int i = 0; i < N; ++i) {
+        idle[i] = b.place("idle", i, 1);
+        loaded[i] = b.place("loaded", i, 0);
+        busy[i] = b.place("busy", i, 0);
+        finished[i] = b.place("finished", i, 0);
+        unloaded[i] = b.place("unloaded", i, 0);
+    }
+    for (int i = 0; i < N; ++i) {
+        b.transition("load", i, {idle[i], robot}, {loaded[i]});
+        b.transition("startMachine", i, {loaded[i]}, {busy[i], robot});
+        b.transition("finish", i, {busy[i]}, {finished[i]});
+        b.transition("unload", i, {finished[i], robot}, {unloaded[i]});
+        b.transition("restart", i, {unloaded[i]}, {idle[i], robot});
+    }
+    return b.raw;
+}
+
+RawData mutexNet(int N) {
+    NetBuilder b;
+    string lock = b.place("lock", 0, 1);
+    vector<string> idle(N), wait(N), crit(N);
+    for (int i = 0; i < N; ++i) {
+        idle[i] = b.place("idle", i, 1);
+        wait[i] = b.place("wait", i, 0);
+        crit[i] = b.place("crit", i, 0);
+    }
+    for (int i = 0; i < N; ++i) {
+        b.transition("request", i, {idle[i]}, {wait[i]});
+        b.transition("acquire", i, {wait[i], lock}, {crit[i]});
+        b.transition("release", i, {crit[i]}, {idle[i], lock});
+    }
+    return b.raw;
+}
+
+RawData producerConsumerNet(int N) {
+    NetBuilder b;
+    vector<string> empty(N), full(N);
+    for (int i = 0; i < N; ++i) {
+        empty[i] = b.place("empty", i, 1);
+        full[i] = b.place("full", i, 0);
+    }
+    b.transition("produce", 0, {empty[0]}, {full[0]});
+    for (int i = 0; i + 1 < N; ++i) {
+        b.transition("move", i, {full[i], empty[i + 1]},
+                     {empty[i], full[i + 1]});
+    }
+    b.transition("consume", N - 1, {full[N - 1]}, {empty[N - 1]});
+    return b.raw;
+}
+
+}  // namespace
+
+vector<string> netFamilyNames() {
+    return {"philosophers", "tokenring", "kanban",
+            "fms",          "mutex",     "prodcons"};
+}
+
+string netFamilyName(NetFamily family) {
+    return netFamilyNames()[static_cast<int>(family)];
+}
+
+bool parseNetFamily(const string& name, NetFamily& family) {
+    vector<string> names = netFamilyNames();
+    for (size_t i = 0; i < names.size(); ++i) {
+        if (names[i] == name) {
+            family = static_cast<NetFamily>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+RawData generateNet(NetFamily family, int N) {
+    if (N < 1) N = 1;
+    switch (family) {
+        case NetFamily::Philosophers:
+            return philosophersNet(N);
+        case NetFamily::TokenRing:
+            return tokenRingNet(N);
+        case NetFamily::Kanban:
+            return kanbanNet(N);
+        case NetFamily::FMS:
+            return fmsNet(N);
+        case NetFamily::Mutex:
+            return mutexNet(N);
+        case NetFamily::ProducerConsumer:
+            return producerConsumerNet(N);
+    }
+    return RawData();
+}
+
+bool writePNML(const RawData& raw, const string& fileName) {
+    ofstream file(fileName);
+    if (!file.is_open()) {
+        cerr << "Error: Cannot create PNML file " << fileName << "\n";
+        return false;
+    }
+    file << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+         << "<pnml>\n  <net id=\"generated\" type=\"PTNet\">\n";
+    for (const auto& blk : raw.Blocks) {
+        if (blk.tokenAmount == -1) {
+            file << "    <transition id=\"" << blk.id << "\">\n"
+                 << "    </transition>\n";
+        } else {
+            file << "    <place id=\"" << blk.id << "\">\n";
+            if (blk.tokenAmount > 0) {
+                file << "      <initialMarking>\n"
+                     << "        <text>" << blk.tokenAmount << "</text>\n"
+                     << "      </initialMarking>\n";
+            }
+            file << "    </place>\n";
+        }
+    }
+    for (const auto& arc : raw.Arcs) {
+        file << "    <arc id=\"" << arc.id << "\" source=\"" << arc.start
+             << "\" target=\"" << arc.end << "\">\n    </arc>\n";
+    }
+    file << "  </net>\n</pnml>\n";
+    return true;
+}
@@ -1,6 +1,13 @@
 #include "optimization.h"
 
-static map<DdNode*, double> memoVal;
+#include <algorithm>
+#include <chrono>
+#include <unordered_map>
+
+#include "profiler.h"
+
+// thread_local: the server answers queries on different nets concurrently
+static thread_local map<DdNode*, double> memoVal;
 const double NEG_INF = -1e18;
 
 static double getGapBonus(int current_level, int next_level,
@@ -168,26 +175,427 @@ void OptimizationTask5Result::print() {
 
 OptimizationTask5Result runOptimizationTask5(const PetriNet& net,
                                              const std::vector<int>& costs) {
+    PROFILE_SCOPE("runOptimizationTask5");
+    ReachableContext ctx = buildReachableContext(net);
+
+    OptimizationTask5Result result =
+        optimizationTask5Function(ctx.mgr, ctx.R, costs);
+
+    PROFILE_CUDD(ctx.mgr);
+    freeReachableContext(ctx);
+
+    return result;
+}
+
+ReachableContext buildReachableContext(const PetriNet& net,
+                                       const CheckpointOptions* checkpoint,
+                                       CheckpointStats* stats,
+                                       BudgetMonitor* budget) {
     int P = static_cast<int>(net.places.size());
 
-    DdManager* mgr = Cudd_Init(0, 0, CUDD_UNIQUE_SLOTS, CUDD_CACHE_SLOTS, 0);
-    std::vector<DdNode*> x(P), x_next(P);
-    for (int i = 0; i < P; ++i) {
-        x[i] = Cudd_bddIthVar(mgr, i);  // was Cudd_bddNewVar(mgr)
-        Cudd_Ref(x[i]);
-        x_next[i] = Cudd_bddIthVar(mgr, i + P);  // was Cudd_bddNewVar(mgr)
-        Cudd_Ref(x_next[i]);
+    ReachableContext ctx;
+    ctx.mgr = Cudd_Init(0, 0, CUDD_UNIQUE_SLOTS, CUDD_CACHE_SLOTS, 0);
+    ctx.x.resize(P);
+    ctx.x_next.resize(P);
+    // creates and Refs x, x_next itself
+    ctx.R = symbolicReachability_in_mgr(ctx.mgr, net, ctx.x, ctx.x_next,
+                                        checkpoint, stats, budget);
+    return ctx;
+}
+
+void freeReachableContext(ReachableContext& ctx) {
+    if (ctx.mgr == nullptr) return;
+    Cudd_RecursiveDeref(ctx.mgr, ctx.R);
+    for (auto v : ctx.x) Cudd_RecursiveDeref(ctx.mgr, v);
+    for (auto v : ctx.x_next) Cudd_RecursiveDeref(ctx.mgr, v);
+    Cudd_Quit(ctx.mgr);
+    ctx = ReachableContext();
+}
+
+// --- Top-k and Pareto front ---
+// Same traversal as calculateMaxValueRec, but every node keeps a list of
+// partial results for its sub-path (levels >= its own) instead of one max.
+// Levels skipped by an edge are free, so they branch into 0 and 1 (the
+// list version of getGapBonus).
+
+static thread_local map<DdNode*, vector<RankedMarking>> memoTopK;
+static thread_local map<DdNode*, vector<ParetoPoint>> memoPareto;
+
+static int childLevel(DdNode* node, int nvars) {
+    return Cudd_IsConstant(node) ? nvars : (int)Cudd_NodeReadIndex(node);
+}
+
+static void truncateTopK(vector<RankedMarking>& list, int k) {
+    stable_sort(list.begin(), list.end(),
+                [](const RankedMarking& a, const RankedMarking& b) {
+                    return a.value > b.value;
+                });
+    if ((int)list.size() > k) list.resize(k);
+}
+
+static void expandGapTopK(vector<RankedMarking>& list, int from, int to,
+                          const vector<int>& costs, int k) {
+    for (int i = from + 1; i < to; ++i) {
+        size_t n = list.size();
+        for (size_t e = 0; e < n; ++e) {
+            RankedMarking with = list[e];
+            with.marking[i] = 1;
+            with.value += costs[i];
+            list[e].marking[i] = 0;
+            list.push_back(with);
+        }
+        truncateTopK(list, k);
     }
+}
 
-    DdNode* reachableSet = symbolicReachability_in_mgr(mgr, net, x, x_next);
+static const vector<RankedMarking>& topKRec(DdManager* mgr, DdNode* node,
+                                            const vector<int>& costs, int k) {
+    auto it = memoTopK.find(node);
+    if (it != memoTopK.end()) return it->second;
+
+    int nvars = static_cast<int>(costs.size());
+    vector<RankedMarking> list;
+
+    if (node == Cudd_ReadOne(mgr)) {
+        list.push_back({0.0, vector<int>(nvars, 0)});
+    } else if (node != Cudd_ReadLogicZero(mgr)) {
+        int currPart = Cudd_NodeReadIndex(node);
+        DdNode* highNode = Cudd_T(node);
+        DdNode* lowNode = Cudd_E(node);
+        if (Cudd_IsComplement(node)) {
+            highNode = Cudd_Not(highNode);
+            lowNode = Cudd_Not(lowNode);
+        }
 
-    OptimizationTask5Result result =
-        optimizationTask5Function(mgr, reachableSet, costs);
+        for (int bit = 1; bit >= 0; --bit) {
+            DdNode* child = bit ? highNode : lowNode;
+            vector<RankedMarking> part = topKRec(mgr, child, costs, k);
+            expandGapTopK(part, currPart, childLevel(child, nvars), costs, k);
+            for (auto& e : part) {
+                e.marking[currPart] = bit;
+                if (bit) e.value += costs[currPart];
+                list.push_back(std::move(e));
+            }
+        }
+        truncateTopK(list, k);
+    }
 
-    Cudd_RecursiveDeref(mgr, reachableSet);
-    for (auto v : x) Cudd_RecursiveDeref(mgr, v);
-    for (auto v : x_next) Cudd_RecursiveDeref(mgr, v);
-    Cudd_Quit(mgr);
+    return memoTopK[node] = list;
+}
 
-    return result;
+OptimizationTopKResult optimizationTopK(DdManager* mgr, DdNode* reachableSet,
+                                        const vector<int>& costs, int k) {
+    OptimizationTopKResult res;
+    memoTopK.clear();
+    if (k <= 0 || reachableSet == Cudd_ReadLogicZero(mgr)) return res;
+
+    int nvars = static_cast<int>(costs.size());
+    res.best = topKRec(mgr, reachableSet, costs, k);
+    expandGapTopK(res.best, -1, childLevel(reachableSet, nvars), costs, k);
+
+    memoTopK.clear();
+    return res;
+}
+
+// a dominates b if it is at least as good for every objective; equal value
+// vectors dominate each other, so the front keeps one witness per vector.
+static bool dominates(const vector<double>& a, const vector<double>& b) {
+    for (size_t j = 0; j < a.size(); ++j) {
+        if (a[j] < b[j]) return false;
+    }
+    return true;
+}
+
+static void pruneDominated(vector<ParetoPoint>& points) {
+    vector<ParetoPoint> kept;
+    for (auto& p : points) {
+        bool dominated = false;
+        for (const auto& q : kept) {
+            if (dominates(q.values, p.values)) {
+                dominated = true;
+                break;
+            }
+        }
+        if (dominated) continue;
+        kept.erase(remove_if(kept.begin(), kept.end(),
+                             [&](const ParetoPoint& q) {
+                                 return dominates(p.values, q.values);
+                             }),
+                   kept.end());
+        kept.push_back(std::move(p));
+    }
+    points.swap(kept);
+}
+
+static void expandGapPareto(vector<ParetoPoint>& points, int from, int to,
+                            const vector<vector<int>>& objectives) {
+    for (int i = from + 1; i < to; ++i) {
+        size_t n = points.size();
+        for (size_t e = 0; e < n; ++e) {
+            ParetoPoint with = points[e];
+            with.marking[i] = 1;
+            for (size_t j = 0; j < objectives.size(); ++j)
+                with.values[j] += objectives[j][i];
+            points[e].marking[i] = 0;
+            points.push_back(with);
+        }
+        pruneDominated(points);
+    }
+}
+
+static const vector<ParetoPoint>& paretoRec(
+    DdManager* mgr, DdNode* node, const vector<vector<int>>& objectives,
+    int nvars) {
+    auto it = memoPareto.find(node);
+    if (it != memoPareto.end()) return it->second;
+
+    vector<ParetoPoint> points;
+
+    if (node == Cudd_ReadOne(mgr)) {
+        points.push_back({vector<double>(objectives.size(), 0.0),
+                          vector<int>(nvars, 0)});
+    } else if (node != Cudd_ReadLogicZero(mgr)) {
+        int currPart = Cudd_NodeReadIndex(node);
+        DdNode* highNode = Cudd_T(node);
+        DdNode* lowNode = Cudd_E(node);
+        if (Cudd_IsComplement(node)) {
+            highNode = Cudd_Not(highNode);
+            lowNode = Cudd_Not(lowNode);
+        }
+
+        for (int bit = 1; bit >= 0; --bit) {
+            DdNode* child = bit ? highNode : lowNode;
+            vector<ParetoPoint> part =
+                paretoRec(mgr, child, objectives, nvars);
+            expandGapPareto(part, currPart, childLevel(child, nvars),
+                            objectives);
+            for (auto& p : part) {
+                p.marking[currPart] = bit;
+                if (bit) {
+                    for (size_t j = 0; j < objectives.size(); ++j)
+                        p.values[j] += objectives[j][currPart];
+                }
+                points.push_back(std::move(p));
+            }
+        }
+        pruneDominated(points);
+    }
+
+    return memoPareto[node] = points;
+}
+
+OptimizationParetoResult optimizationPareto(
+    DdManager* mgr, DdNode* reachableSet,
+    const vector<vector<int>>& objectives) {
+    OptimizationParetoResult res;
+    memoPareto.clear();
+    if (objectives.empty() || reachableSet == Cudd_ReadLogicZero(mgr))
+        return res;
+
+    int nvars = static_cast<int>(objectives[0].size());
+    res.front = paretoRec(mgr, reachableSet, objectives, nvars);
+    expandGapPareto(res.front, -1, childLevel(reachableSet, nvars),
+                    objectives);
+
+    // deterministic order: first objective descending
+    sort(res.front.begin(), res.front.end(),
+         [](const ParetoPoint& a, const ParetoPoint& b) {
+             return a.values > b.values;
+         });
+
+    memoPareto.clear();
+    return res;
+}
+
+// --- Batch evaluation ---
+
+// Children-before-parents order of the (possibly complemented) node
+// pointers below root, matching the memo keys of calculateMaxValueRec.
+static vector<DdNode*> topologicalNodes(DdNode* root) {
+    vector<DdNode*> order;
+    if (Cudd_IsConstant(root)) return order;
+
+    unordered_map<DdNode*, bool> seen;
+    vector<pair<DdNode*, bool>> stack;  // node, children already pushed
+    stack.push_back({root, false});
+    while (!stack.empty()) {
+        auto [node, expanded] = stack.back();
+        stack.pop_back();
+        if (expanded) {
+            order.push_back(node);
+            continue;
+        }
+        if (seen.count(node)) continue;
+        seen[node] = true;
+        stack.push_back({node, true});
+
+        DdNode* highNode = Cudd_T(node);
+        DdNode* lowNode = Cudd_E(node);
+        if (Cudd_IsComplement(node)) {
+            highNode = Cudd_Not(highNode);
+            lowNode = Cudd_Not(lowNode);
+        }
+        if (!Cudd_IsConstant(highNode) && !seen.count(highNode))
+            stack.push_back({highNode, false});
+        if (!Cudd_IsConstant(lowNode) && !seen.count(lowNode))
+            stack.push_back({lowNode, false});
+    }
+    return order;
+}
+
+// One node of the batch traversal: out[m] = max over the two children of
+// child value + cost of the branch + the free levels skipped below it, for
+// every costs vector m. W is a multiple of 8 and nothing aliases, so this
+// is one vectorized loop (checked with -fopt-info-vec).
+static void maxRow(const double* __restrict hi, const double* __restrict lo,
+                   const double* __restrict c,
+                   const double* __restrict gapHi,
+                   const double* __restrict gapLo,
+                   const double* __restrict gapBase, double* __restrict out,
+                   size_t W) {
+    for (size_t m = 0; m < W; ++m) {
+        double vh = hi[m] + c[m] + gapHi[m] - gapBase[m];
+        double vl = lo[m] + gapLo[m] - gapBase[m];
+        out[m] = vh >= vl ? vh : vl;
+    }
+}
+
+OptimizationBatchResult optimizationBatch(
+    DdManager* mgr, DdNode* reachableSet,
+    const vector<vector<int>>& costMatrix) {
+    OptimizationBatchResult res;
+    size_t M = costMatrix.size();
+    if (M == 0) return res;
+    res.maxValues.assign(M, NEG_INF);
+    res.optimalMarkings.assign(M, vector<int>());
+
+    DdNode* deadNode = Cudd_ReadLogicZero(mgr);
+    DdNode* leafNode = Cudd_ReadOne(mgr);
+    if (reachableSet == deadNode) return res;
+
+    auto start = chrono::steady_clock::now();
+
+    int nvars = static_cast<int>(costMatrix[0].size());
+
+    // Level-major cost table and prefix sums of the positive costs, so
+    // getGapBonus(cur, next) becomes posPrefix[next] - posPrefix[cur + 1].
+    // Rows are padded to W doubles: the loops below then run a multiple of
+    // the vector width and GCC vectorizes them at -O2 (no scalar epilogue).
+    size_t W = (M + 7) & ~size_t(7);
+    vector<double> cost((size_t)nvars * W, 0.0);
+    vector<double> posPrefix((size_t)(nvars + 1) * W, 0.0);
+    for (int i = 0; i < nvars; ++i) {
+        for (size_t m = 0; m < M; ++m) {
+            int c = costMatrix[m][i];
+            cost[i * W + m] = c;
+            posPrefix[(i + 1) * W + m] = posPrefix[i * W + m] + max(c, 0);
+        }
+    }
+
+    vector<DdNode*> order = topologicalNodes(reachableSet);
+    unordered_map<DdNode*, size_t> id;
+    id.reserve(order.size());
+    for (size_t k = 0; k < order.size(); ++k) id[order[k]] = k;
+
+    // the zero leaf as a row of NEG_INF, so both children go through the
+    // same branch-free loop
+    vector<double> value(order.size() * W);
+    vector<double> zeroRow(W, 0.0), deadRow(W, NEG_INF);
+    auto childRow = [&](DdNode* child) -> const double* {
+        if (child == deadNode) return deadRow.data();
+        if (child == leafNode) return zeroRow.data();
+        return &value[id[child] * W];
+    };
+    auto children = [](DdNode* node, DdNode*& high, DdNode*& low) {
+        high = Cudd_T(node);
+        low = Cudd_E(node);
+        if (Cudd_IsComplement(node)) {
+            high = Cudd_Not(high);
+            low = Cudd_Not(low);
+        }
+    };
+
+    for (size_t k = 0; k < order.size(); ++k) {
+        DdNode* node = order[k];
+        int currPart = Cudd_NodeReadIndex(node);
+        DdNode *highNode, *lowNode;
+        children(node, highNode, lowNode);
+        maxRow(childRow(highNode), childRow(lowNode),
+               &cost[(size_t)currPart * W],
+               &posPrefix[(size_t)childLevel(highNode, nvars) * W],
+               &posPrefix[(size_t)childLevel(lowNode, nvars) * W],
+               &posPrefix[(size_t)(currPart + 1) * W], &value[k * W], W);
+    }
+
+    // Add the gap above the root, then follow the maximizing child down,
+    // comparing the two sides as maxRow did.
+    int rootPart = childLevel(reachableSet, nvars);
+    for (size_t m = 0; m < M; ++m) {
+        double rootValue = (reachableSet == leafNode)
+                               ? 0.0
+                               : value[id[reachableSet] * W + m];
+        res.maxValues[m] =
+            rootValue + posPrefix[rootPart * W + m] - posPrefix[m];
+
+        vector<int>& marking = res.optimalMarkings[m];
+        marking.assign(nvars, 0);
+        DdNode* node = reachableSet;
+        int parent_level = -1;
+        while (true) {
+            int level = childLevel(node, nvars);
+            for (int i = parent_level + 1; i < level; ++i)
+                marking[i] = (costMatrix[m][i] > 0) ? 1 : 0;
+            if (node == leafNode) break;
+
+            DdNode *highNode, *lowNode;
+            children(node, highNode, lowNode);
+            double vh = childRow(highNode)[m] + cost[level * W + m] +
+                        posPrefix[childLevel(highNode, nvars) * W + m] -
+                        posPrefix[(level + 1) * W + m];
+            double vl = childRow(lowNode)[m] +
+                        posPrefix[childLevel(lowNode, nvars) * W + m] -
+                        posPrefix[(level + 1) * W + m];
+            bool high = vh >= vl;
+            marking[level] = high ? 1 : 0;
+            node = high ? highNode : lowNode;
+            parent_level = level;
+        }
+    }
+
+    res.seconds = chrono::duration<double>(chrono::steady_clock::now() -
+                                           start)
+                      .count();
+    res.vectorsPerSecond = res.seconds > 0 ? M / res.seconds : 0;
+    return res;
+}
+
+void OptimizationBatchResult::print() {
+    for (size_t m = 0; m < maxValues.size(); ++m) {
+        cout << "costs #" << m << ": ";
+        printMarking_opt(optimalMarkings[m]);
+        cout << " Max value: " << maxValues[m] << "\n";
+    }
+    cout << maxValues.size() << " costs vectors in " << seconds * 1000
+         << " ms (" << vectorsPerSecond << " vectors/s)\n";
+}
+
+void OptimizationTopKResult::print() {
+    for (size_t i = 0; i < best.size(); ++i) {
+        cout << "#" << i + 1 << ": ";
+        printMarking_opt(best[i].marking);
+        cout << " value: " << best[i].value << "\n";
+    }
+}
+
+void OptimizationParetoResult::print() {
+    cout << "Pareto front (" << front.size() << " points):\n";
+    for (const auto& p : front) {
+        cout << "(";
+        for (size_t j = 0; j < p.values.size(); ++j) {
+            cout << p.values[j] << (j + 1 < p.values.size() ? ", " : "");
+        }
+        cout << ") ";
+        printMarking_opt(p.marking);
+        cout << "\n";
+    }
 }
@@ -0,0 +1,123 @@
+#include "optimization_add.h"
+
+#include <iostream>
+
+AddObjective linearObjective(const vector<int>& costs) {
+    AddObjective obj;
+    obj.linear.assign(costs.begin(), costs.end());
+    return obj;
+}
+
+// res = op(a, b); Derefs a and b, returns a Ref'd node
+static DdNode* applyAndDeref(DdManager* mgr, DD_AOP op, DdNode* a,
+                             DdNode* b) {
+    DdNode* res = Cudd_addApply(mgr, op, a, b);
+    Cudd_Ref(res);
+    Cudd_RecursiveDeref(mgr, a);
+    Cudd_RecursiveDeref(mgr, b);
+    return res;
+}
+
+static DdNode* constADD(DdManager* mgr, double c) {
+    DdNode* res = Cudd_addConst(mgr, c);
+    Cudd_Ref(res);
+    return res;
+}
+
+// Token count of place p: sum_j 2^j * bit_j
+static DdNode* placeValueADD(DdManager* mgr, const vector<int>& bits) {
+    DdNode* sum = constADD(mgr, 0);
+    double weight = 1;
+    for (int var : bits) {
+        DdNode* v = Cudd_addIthVar(mgr, var);
+        Cudd_Ref(v);
+        DdNode* term =
+            applyAndDeref(mgr, Cudd_addTimes, constADD(mgr, weight), v);
+        sum = applyAndDeref(mgr, Cudd_addPlus, sum, term);
+        weight *= 2;
+    }
+    return sum;
+}
+
+DdNode* buildObjectiveADD(DdManager* mgr, const PlaceEncoding& enc,
+                          const AddObjective& obj) {
+    int P = static_cast<int>(enc.bits.size());
+    vector<DdNode*> value(P, nullptr);
+    auto valueOf = [&](int p) {
+        if (value[p] == nullptr) value[p] = placeValueADD(mgr, enc.bits[p]);
+        return value[p];
+    };
+
+    DdNode* f = constADD(mgr, 0);
+    for (int p = 0; p < P && p < (int)obj.linear.size(); ++p) {
+        if (obj.linear[p] == 0) continue;
+        DdNode* vp = valueOf(p);
+        Cudd_Ref(vp);
+        DdNode* term =
+            applyAndDeref(mgr, Cudd_addTimes, constADD(mgr, obj.linear[p]), vp);
+        f = applyAndDeref(mgr, Cudd_addPlus, f, term);
+    }
+    for (const auto& pt : obj.pairwise) {
+        if (pt.weight == 0) continue;
+        DdNode* vp = valueOf(pt.p);
+        Cudd_Ref(vp);
+        DdNode* vq = valueOf(pt.q);
+        Cudd_Ref(vq);
+        DdNode* prod = applyAndDeref(mgr, Cudd_addTimes, vp, vq);
+        DdNode* term =
+            applyAndDeref(mgr, Cudd_addTimes, constADD(mgr, pt.weight), prod);
+        f = applyAndDeref(mgr, Cudd_addPlus, f, term);
+    }
+
+    for (auto v : value) {
+        if (v != nullptr) Cudd_RecursiveDeref(mgr, v);
+    }
+    return f;
+}
+
+OptimizationTask5Result optimizationADD(DdManager* mgr, DdNode* reachableSet,
+                                        const PlaceEncoding& enc,
+                                        const AddObjective& obj) {
+    const double NEG_INF = -1e18;  // same sentinel as optimization.cpp
+    OptimizationTask5Result res;
+    res.found = false;
+    res.maxValue = NEG_INF;
+    if (reachableSet == Cudd_ReadLogicZero(mgr)) return res;
+
+    DdNode* f = buildObjectiveADD(mgr, enc, obj);
+
+    // f restricted to R: unreachable markings get NEG_INF
+    DdNode* inR = Cudd_BddToAdd(mgr, reachableSet);
+    Cudd_Ref(inR);
+    DdNode* floor = constADD(mgr, NEG_INF);
+    DdNode* restricted = Cudd_addIte(mgr, inR, f, floor);
+    Cudd_Ref(restricted);
+    Cudd_RecursiveDeref(mgr, inR);
+    Cudd_RecursiveDeref(mgr, floor);
+    Cudd_RecursiveDeref(mgr, f);
+
+    DdNode* maxNode = Cudd_addFindMax(mgr, restricted);
+    double maxValue = Cudd_V(maxNode);
+
+    // markings of R reaching the max; any one of them is a maximizer
+    DdNode* argmax = Cudd_addBddInterval(mgr, restricted, maxValue, maxValue);
+    Cudd_Ref(argmax);
+    Cudd_RecursiveDeref(mgr, restricted);
+
+    vector<char> cube(Cudd_ReadSize(mgr));
+    if (Cudd_bddPickOneCube(mgr, argmax, cube.data())) {
+        res.found = true;
+        res.maxValue = maxValue;
+        res.optimalMarking.assign(enc.bits.size(), 0);
+        for (size_t p = 0; p < enc.bits.size(); ++p) {
+            int weight = 1;
+            for (int var : enc.bits[p]) {
+                if (cube[var] == 1) res.optimalMarking[p] += weight;
+                weight *= 2;  // don't-care (2) bits are taken as 0
+            }
+        }
+    }
+    Cudd_RecursiveDeref(mgr, argmax);
+
+    return res;
+}
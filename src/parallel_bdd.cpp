@@ -0,0 +1,199 @@
+#include "parallel_bdd.h"
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+
+#include "profiler.h"
+#include "thread_pool.h"
+
+using namespace std;
+
+namespace {
+
+using Clock = chrono::steady_clock;
+
+double msSince(Clock::time_point start) {
+    return chrono::duration<double, milli>(Clock::now() - start).count();
+}
+
+// CPU time of the calling thread, so that workers sharing a core are not
+// charged for each other's time slices
+double threadMs() {
+#ifndef _WIN32
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+#else
+    return chrono::duration<double, milli>(Clock::now().time_since_epoch())
+        .count();
+#endif
+}
+
+struct Worker {
+    DdManager* mgr = nullptr;
+    TransitionRelations tr;
+    DdNode* image = nullptr;  // partial image of the level, Ref'd
+    double workMs = 0;        // this level
+    double transferMs = 0;
+};
+
+// Transitions first, first + step, ... of net
+PetriNet transitionShare(const PetriNet& net, int first, int step) {
+    PetriNet share;
+    share.places = net.places;
+    share.initialMarking = net.initialMarking;
+    share.incidenceMatrix.resize(net.places.size());
+    int T = static_cast<int>(net.transitions.size());
+    for (int t = first; t < T; t += step) {
+        share.transitions.push_back(net.transitions[t]);
+        for (size_t p = 0; p < net.places.size(); ++p)
+            share.incidenceMatrix[p].push_back(net.incidenceMatrix[p][t]);
+    }
+    return share;
+}
+
+// f of from copied into to, Ref'd; the time goes to ms
+DdNode* transfer(DdManager* from, DdManager* to, DdNode* f, double& ms) {
+    double start = threadMs();
+    DdNode* g = Cudd_bddTransfer(from, to, f);
+    Cudd_Ref(g);
+    ms += threadMs() - start;
+    return g;
+}
+
+DdNode* orInto(DdManager* mgr, DdNode* acc, DdNode* f) {  // consumes both
+    DdNode* tmp = Cudd_bddOr(mgr, acc, f);
+    Cudd_Ref(tmp);
+    Cudd_RecursiveDeref(mgr, acc);
+    Cudd_RecursiveDeref(mgr, f);
+    return tmp;
+}
+
+}  // namespace
+
+double ParallelImageStats::speedup() const {
+    double work = 0, wall = 0;
+    for (const auto& it : iterations) {
+        work += it.workMs;
+        wall += it.imageMs;
+    }
+    return wall > 0 ? work / wall : 0;
+}
+
+double ParallelImageStats::transferShare() const {
+    double transfer = 0, busy = 0;
+    for (const auto& it : iterations) {
+        transfer += it.transferMs;
+        busy += it.workMs + it.transferMs;
+    }
+    return busy > 0 ? transfer / busy : 0;
+}
+
+EncodedReachable parallelSymbolicReachability(const PetriNet& net,
+                                              const PlaceEncoding& enc,
+                                              bool safe, int threads,
+                                              ParallelImageStats* stats) {
+    PROFILE_SCOPE("parallelSymbolicReachability");
+    int T = static_cast<int>(net.transitions.size());
+    threads = max(1, min(threads, T));
+
+    EncodedReachable er;
+    er.enc = enc;
+    for (const auto& b : enc.bits) er.nvars += static_cast<int>(b.size());
+    er.mgr = Cudd_Init(er.nvars, 0, CUDD_UNIQUE_SLOTS, CUDD_CACHE_SLOTS, 0);
+    DdManager* main = er.mgr;
+
+    ThreadPool pool(threads);
+    vector<Worker> workers(threads);
+    for (int w = 0; w < threads; ++w) {
+        pool.submit([&, w] {
+            Worker& worker = workers[w];
+            worker.mgr = Cudd_Init(er.nvars, 0, CUDD_UNIQUE_SLOTS,
+                                   CUDD_CACHE_SLOTS, 0);
+            worker.tr = buildTransitionRelations(
+                worker.mgr, transitionShare(net, w, threads), enc, safe);
+        });
+    }
+    pool.wait();
+    if (stats) *stats = ParallelImageStats{threads, {}};
+
+    DdNode* zero = Cudd_ReadLogicZero(main);
+    DdNode* R = markingBDD(main, enc, net.initialMarking);
+    DdNode* frontier = R;
+    Cudd_Ref(frontier);
+    while (frontier != zero) {
+        ParallelIteration level;
+        auto start = Clock::now();
+
+        // partial images; the main manager is only read meanwhile
+        for (int w = 0; w < threads; ++w) {
+            pool.submit([&, w] {
+                Worker& worker = workers[w];
+                DdManager* mgr = worker.mgr;
+                worker.transferMs = 0;
+                DdNode* f = transfer(main, mgr, frontier, worker.transferMs);
+                double begin = threadMs();
+                DdNode* image = Cudd_ReadLogicZero(mgr);
+                Cudd_Ref(image);
+                int share = static_cast<int>(worker.tr.guard.size());
+                for (int t = 0; t < share; ++t)
+                    image = orInto(mgr, image, postImage(worker.tr, f, t));
+                Cudd_RecursiveDeref(mgr, f);
+                worker.image = image;
+                worker.workMs = threadMs() - begin;
+            });
+        }
+        pool.wait();
+        level.imageMs = msSince(start);
+
+        // reduction tree: one level's pairs touch distinct managers
+        auto merge = Clock::now();
+        for (int d = 1; d < threads; d *= 2) {
+            for (int w = 0; w + d < threads; w += 2 * d) {
+                pool.submit([&, w, d] {
+                    Worker& into = workers[w];
+                    Worker& from = workers[w + d];
+                    DdNode* moved = transfer(from.mgr, into.mgr, from.image,
+                                             into.transferMs);
+                    Cudd_RecursiveDeref(from.mgr, from.image);
+                    from.image = nullptr;
+                    into.image = orInto(into.mgr, into.image, moved);
+                });
+            }
+            pool.wait();
+        }
+        double backMs = 0;
+        DdNode* image =
+            transfer(workers[0].mgr, main, workers[0].image, backMs);
+        Cudd_RecursiveDeref(workers[0].mgr, workers[0].image);
+        workers[0].image = nullptr;
+        level.mergeMs = msSince(merge);
+
+        Cudd_RecursiveDeref(main, frontier);
+        frontier = Cudd_bddAnd(main, image, Cudd_Not(R));
+        Cudd_Ref(frontier);
+        Cudd_RecursiveDeref(main, image);
+        DdNode* tmp = Cudd_bddOr(main, R, frontier);
+        Cudd_Ref(tmp);
+        Cudd_RecursiveDeref(main, R);
+        R = tmp;
+
+        level.transferMs = backMs;
+        for (const Worker& worker : workers) {
+            level.workMs += worker.workMs;
+            level.transferMs += worker.transferMs;
+        }
+        level.wallMs = msSince(start);
+        if (stats) stats->iterations.push_back(level);
+    }
+    Cudd_RecursiveDeref(main, frontier);
+
+    for (Worker& worker : workers) {
+        freeTransitionRelations(worker.tr);
+        Cudd_Quit(worker.mgr);
+    }
+    er.R = R;
+    PROFILE_CUDD(main);
+    return er;
+}
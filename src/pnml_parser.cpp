@@ -1,6 +1,7 @@
 #include "pnml_parser.h"
 
 #include <cctype>  // for std::isspace
+#include <sstream>
 
 string RawBlock::toString() {
     return "(" + id + "," + to_string(tokenAmount) + ")";
@@ -126,16 +127,8 @@ RawData cascade(string extracted) {
  *  - Reads all <transition id="..."> as RawBlock with tokenAmount = -1.
  *  - Reads all <arc id="..." source="X" target="Y"> as RawArc.
  */
-RawData toRaw(const string& fileName) {
+static RawData parseRaw(istream& file) {
     RawData raw;
-
-    ifstream file(fileName);
-    if (!file.is_open()) {
-        cout << "Cannot open file " << fileName << "." << endl;
-        return raw;
-    }
-    cout << "File " << fileName << " is opened." << endl;
-
     string line;
     string currentPlaceId;
     bool inPlace = false;
@@ -236,11 +229,24 @@ RawData toRaw(const string& fileName) {
             continue;
         }
     }
-
-    file.close();
     return raw;
 }
 
+RawData toRaw(const string& fileName) {
+    ifstream file(fileName);
+    if (!file.is_open()) {
+        cout << "Cannot open file " << fileName << "." << endl;
+        return RawData();
+    }
+    cout << "File " << fileName << " is opened." << endl;
+    return parseRaw(file);
+}
+
+RawData rawFromText(const string& text) {
+    istringstream in(text);
+    return parseRaw(in);
+}
+
 /*
  * Convert RawData to explicit PetriNet representation.
  */
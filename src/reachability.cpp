@@ -1,8 +1,12 @@
 #include "reachability.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
 #include <iostream>
+#include <map>
 
-#include "heap_counter.h"
+#include "profiler.h"
 
 using namespace std;
 
@@ -26,42 +30,344 @@ Marking fire_transition(const Marking& M, int T_index, const PetriNet& net) {
     return M_prime;
 }
 
+void ParentTable::reset(int transitions) {
+    parent.clear();
+    via16.clear();
+    via32.clear();
+    wide = transitions > UINT16_MAX;
+}
+
+void ParentTable::record(uint32_t from, int t) {
+    parent.push_back(from);
+    if (wide) {
+        via32.push_back(static_cast<uint32_t>(t));
+    } else {
+        via16.push_back(static_cast<uint16_t>(t));
+    }
+}
+
+size_t ParentTable::bytes() const {
+    return parent.size() * sizeof(uint32_t) + via16.size() * sizeof(uint16_t) +
+           via32.size() * sizeof(uint32_t);
+}
+
+vector<int> ParentTable::trace(size_t state) const {
+    vector<int> transitions;
+    for (size_t s = state; parent[s] != NONE; s = parent[s])
+        transitions.push_back(via(s));
+    reverse(transitions.begin(), transitions.end());
+    return transitions;
+}
+
+void EdgeTable::reset() {
+    offset.assign(1, 0);
+    target.clear();
+    label.clear();
+}
+
 // --- Hàm chính Task 2: Explicit Reachability bằng BFS ---
 
-vector<Marking> explicitReachability(const PetriNet& net) {
-    HEAP_START();
+// States get their index in discovery order, which is also the order the
+// FIFO queue hands them out and appends them to the result; the visited
+// maps keep it for the edges.
+
+vector<Marking> explicitReachability(const PetriNet& net,
+                                     ParentTable* parents,
+                                     BudgetMonitor* budget,
+                                     EdgeTable* edges) {
+    PROFILE_SCOPE("explicitReachability");
     queue<Marking> queue;
-    set<Marking> reachSet;
+    map<Marking, uint32_t> reachSet;
 
     Marking M0 = net.initialMarking;
     queue.push(M0);
-    reachSet.insert(M0);
+    reachSet.emplace(M0, 0);
 
     vector<Marking> reachableMarkings;
     int T_size = net.transitions.size();
+    if (parents) {
+        parents->reset(T_size);
+        parents->record(ParentTable::NONE, 0);
+    }
+    if (edges) edges->reset();
 
     while (!queue.empty()) {
+        if (budget && (reachableMarkings.size() & 1023) == 0 &&
+            budget->exhausted()) {
+            budget->progress(reachableMarkings.size(), queue.size());
+            break;
+        }
         Marking M = queue.front();
         queue.pop();
+        uint32_t index = static_cast<uint32_t>(reachableMarkings.size());
         reachableMarkings.push_back(M);
 
         for (int j = 0; j < T_size; ++j) {
             if (is_enabled(M, j, net)) {
                 Marking M_prime = fire_transition(M, j, net);
 
-                if (reachSet.find(M_prime) == reachSet.end()) {
-                    reachSet.insert(M_prime);
-                    queue.push(M_prime);
+                uint32_t next = static_cast<uint32_t>(reachSet.size());
+                auto found = reachSet.try_emplace(M_prime, next);
+                if (found.second) {
+                    queue.push(std::move(M_prime));
+                    if (parents) parents->record(index, j);
                 }
+                if (edges) edges->add(found.first->second, j);
             }
         }
+        if (edges) edges->close();
     }
 
     cout << "--- Task 2 Results (Explicit Reachability) ---" << endl;
     cout << "Total reachable markings found: " << reachableMarkings.size()
          << endl;
 
-    HEAP_END();
+    return reachableMarkings;
+}
+
+// Same BFS, but the visited set holds only the kept places of pc; a marking
+// is expanded to fire transitions and to be returned.
+vector<Marking> explicitReachability(const PetriNet& net,
+                                     const PlaceCompression& pc,
+                                     ParentTable* parents,
+                                     BudgetMonitor* budget,
+                                     EdgeTable* edges) {
+    PROFILE_SCOPE("explicitReachabilityCompressed");
+    queue<Marking> queue;
+    map<Marking, uint32_t> reachSet;
+
+    Marking m0 = pc.compress(net.initialMarking);
+    queue.push(m0);
+    reachSet.emplace(m0, 0);
+
+    vector<Marking> reachableMarkings;
+    int T_size = net.transitions.size();
+    if (parents) {
+        parents->reset(T_size);
+        parents->record(ParentTable::NONE, 0);
+    }
+    if (edges) edges->reset();
+
+    while (!queue.empty()) {
+        if (budget && (reachableMarkings.size() & 1023) == 0 &&
+            budget->exhausted()) {
+            budget->progress(reachableMarkings.size(), queue.size());
+            break;
+        }
+        Marking M = pc.expand(queue.front());
+        queue.pop();
+        uint32_t index = static_cast<uint32_t>(reachableMarkings.size());
+
+        for (int j = 0; j < T_size; ++j) {
+            if (is_enabled(M, j, net)) {
+                Marking m_prime = pc.compress(fire_transition(M, j, net));
+                uint32_t next = static_cast<uint32_t>(reachSet.size());
+                auto found = reachSet.try_emplace(m_prime, next);
+                if (found.second) {
+                    queue.push(m_prime);
+                    if (parents) parents->record(index, j);
+                }
+                if (edges) edges->add(found.first->second, j);
+            }
+        }
+        if (edges) edges->close();
+        reachableMarkings.push_back(std::move(M));
+    }
+
+    cout << "--- Task 2 Results (Explicit Reachability, "
+         << pc.implied.size() << " implied places dropped) ---" << endl;
+    cout << "Total reachable markings found: " << reachableMarkings.size()
+         << endl;
+
+    return reachableMarkings;
+}
+
+// BFS over markings packed as Count per place; the visited set is the only
+// large structure, so narrow counts shrink it directly.
+template <typename Count>
+static vector<Marking> packedReachability(const PetriNet& net,
+                                          ParentTable* parents,
+                                          BudgetMonitor* budget,
+                                          EdgeTable* edges) {
+    using Packed = vector<Count>;
+    int P = net.places.size();
+    auto pack = [&](const Marking& M) {
+        Packed m(P);
+        for (int i = 0; i < P; ++i) m[i] = static_cast<Count>(M[i]);
+        return m;
+    };
+    auto unpack = [&](const Packed& m) { return Marking(m.begin(), m.end()); };
 
+    queue<Packed> queue;
+    map<Packed, uint32_t> reachSet;
+    Packed m0 = pack(net.initialMarking);
+    queue.push(m0);
+    reachSet.emplace(m0, 0);
+
+    vector<Marking> reachableMarkings;
+    int T_size = net.transitions.size();
+    if (parents) {
+        parents->reset(T_size);
+        parents->record(ParentTable::NONE, 0);
+    }
+    if (edges) edges->reset();
+    while (!queue.empty()) {
+        if (budget && (reachableMarkings.size() & 1023) == 0 &&
+            budget->exhausted()) {
+            budget->progress(reachableMarkings.size(), queue.size());
+            break;
+        }
+        Marking M = unpack(queue.front());
+        queue.pop();
+        uint32_t index = static_cast<uint32_t>(reachableMarkings.size());
+        reachableMarkings.push_back(M);
+
+        for (int j = 0; j < T_size; ++j) {
+            if (is_enabled(M, j, net)) {
+                Packed next = pack(fire_transition(M, j, net));
+                uint32_t id = static_cast<uint32_t>(reachSet.size());
+                auto found = reachSet.try_emplace(next, id);
+                if (found.second) {
+                    queue.push(next);
+                    if (parents) parents->record(index, j);
+                }
+                if (edges) edges->add(found.first->second, j);
+            }
+        }
+        if (edges) edges->close();
+    }
     return reachableMarkings;
-}
\ No newline at end of file
+}
+
+vector<Marking> explicitReachability(const PetriNet& net, int width,
+                                     ParentTable* parents,
+                                     BudgetMonitor* budget,
+                                     EdgeTable* edges) {
+    PROFILE_SCOPE("explicitReachabilityPacked");
+    vector<Marking> reachableMarkings;
+    if (width == 1) {
+        reachableMarkings =
+            packedReachability<uint8_t>(net, parents, budget, edges);
+    } else if (width == 2) {
+        reachableMarkings =
+            packedReachability<uint16_t>(net, parents, budget, edges);
+    } else {
+        reachableMarkings =
+            packedReachability<int>(net, parents, budget, edges);
+    }
+
+    cout << "--- Task 2 Results (Explicit Reachability, " << width
+         << " byte(s) per place) ---" << endl;
+    cout << "Total reachable markings found: " << reachableMarkings.size()
+         << endl;
+    return reachableMarkings;
+}
+
+vector<Marking> explicitReachability(const PetriNet& net,
+                                     const CheckpointOptions& cp,
+                                     CheckpointStats* stats,
+                                     ParentTable* parents,
+                                     BudgetMonitor* budget,
+                                     EdgeTable* edges) {
+    PROFILE_SCOPE("explicitReachabilityCheckpointed");
+    using Clock = chrono::steady_clock;
+    auto msSince = [](Clock::time_point t) {
+        return chrono::duration<double, milli>(Clock::now() - t).count();
+    };
+    auto start = Clock::now();
+    CheckpointStats local;
+    CheckpointStats& st = stats ? *stats : local;
+    st = CheckpointStats();
+
+    // discovered markings double as the queue: the first `expanded` of
+    // them are done, the rest wait in FIFO order
+    int P = static_cast<int>(net.places.size());
+    int T_size = static_cast<int>(net.transitions.size());
+    string path = cp.path + ".states";
+    uint64_t fingerprint = netFingerprint(net);
+    StateLog log;
+    bool resume = loadStateLog(path, fingerprint, P, log);
+    map<Marking, uint32_t> reachSet;
+    for (size_t i = 0; i < log.states.size(); ++i)
+        reachSet.emplace(log.states[i], static_cast<uint32_t>(i));
+    if (resume) {
+        st.resumed = true;
+        st.resumedAt = log.expanded;
+    } else {
+        log.states.assign(1, net.initialMarking);
+        log.parent.assign(1, uint32_t(ParentTable::NONE));
+        log.via.assign(1, 0);
+        reachSet.emplace(net.initialMarking, 0);
+    }
+    vector<Marking>& states = log.states;
+    auto expand = [&](size_t i) {
+        Marking M = states[i];
+        for (int j = 0; j < T_size; ++j) {
+            if (!is_enabled(M, j, net)) continue;
+            Marking M_prime = fire_transition(M, j, net);
+            uint32_t next = static_cast<uint32_t>(states.size());
+            auto found = reachSet.try_emplace(M_prime, next);
+            if (found.second) {
+                states.push_back(move(M_prime));
+                log.parent.push_back(static_cast<uint32_t>(i));
+                log.via.push_back(static_cast<uint32_t>(j));
+            }
+            if (edges) edges->add(found.first->second, j);
+        }
+        if (edges) edges->close();
+    };
+    // the successors of the logged expanded markings are all logged, so
+    // refiring them only rebuilds their rows
+    if (edges) {
+        edges->reset();
+        for (size_t i = 0; i < log.expanded; ++i) expand(i);
+    }
+    StateLogWriter writer;
+    writer.open(path, fingerprint, P, resume);
+    st.bytes = writer.bytes();
+    size_t logged = resume ? states.size() : 0;
+
+    auto checkpoint = [&](size_t expanded) {
+        auto begin = Clock::now();
+        writer.append(states, logged, log.parent, log.via, expanded);
+        logged = states.size();
+        st.writes++;
+        st.bytes = writer.bytes();
+        st.writeMs += msSince(begin);
+    };
+    auto last = Clock::now();
+    size_t expanded = log.expanded;
+    bool cut = false;  // by the budget
+    for (size_t i = log.expanded; i < states.size(); ++i) {
+        // the clock is read once per 1024 markings
+        if ((i & 1023) == 0 && msSince(last) >= cp.seconds * 1000) {
+            checkpoint(i);
+            last = Clock::now();
+        }
+        if (budget && (i & 1023) == 0 && budget->exhausted()) {
+            budget->progress(i, states.size() - i);
+            if (logged < states.size()) checkpoint(i);
+            expanded = i;
+            cut = true;
+            break;
+        }
+        expand(i);
+    }
+    if (cut) {
+        states.resize(expanded);
+    } else if (logged < states.size() || log.expanded < states.size()) {
+        checkpoint(states.size());
+    }
+
+    if (parents) {
+        parents->reset(T_size);
+        for (size_t i = 0; i < states.size(); ++i)
+            parents->record(log.parent[i], log.via[i]);
+    }
+    st.runMs = msSince(start);
+
+    cout << "--- Task 2 Results (Explicit Reachability, checkpointed) ---"
+         << endl;
+    cout << "Total reachable markings found: " << states.size() << endl;
+    return move(states);
+}
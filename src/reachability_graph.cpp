@@ -0,0 +1,156 @@
+#include "reachability_graph.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <utility>
+
+#include "profiler.h"
+
+using namespace std;
+
+namespace {
+
+const char MAGIC[4] = {'P', 'N', 'R', 'G'};
+const uint32_t VERSION = 1;
+
+struct GraphHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t places;
+    uint32_t transitions;
+    uint64_t states;
+    uint64_t edges;
+};
+
+void pad(ofstream& out, size_t bytes) {
+    static const char zeros[8] = {};
+    if (bytes % 8) out.write(zeros, 8 - bytes % 8);
+}
+
+template <typename T>
+void writeArray(ofstream& out, const vector<T>& v) {
+    out.write(reinterpret_cast<const char*>(v.data()), v.size() * sizeof(T));
+}
+
+}  // namespace
+
+size_t writeReachabilityGraph(const ReachabilityGraph& g, const string& path) {
+    ofstream out(path, ios::binary);
+    if (!out) return 0;
+    GraphHeader h;
+    memcpy(h.magic, MAGIC, 4);
+    h.version = VERSION;
+    h.places = g.places;
+    h.transitions = g.transitions;
+    h.states = g.states.size();
+    h.edges = g.edges();
+    out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+
+    vector<int32_t> markings;
+    markings.reserve(g.states.size() * g.places);
+    for (const Marking& M : g.states)
+        markings.insert(markings.end(), M.begin(), M.end());
+    writeArray(out, markings);
+    pad(out, markings.size() * sizeof(int32_t));
+    writeArray(out, g.offset);
+    writeArray(out, g.target);
+    pad(out, g.target.size() * sizeof(uint32_t));
+    writeArray(out, g.label);
+    if (!out) return 0;
+    return static_cast<size_t>(out.tellp());
+}
+
+SccAnalysis analyzeSccs(const ReachabilityGraph& g) {
+    PROFILE_SCOPE("analyzeSccs");
+    const uint32_t NONE = UINT32_MAX;
+    size_t n = g.states.size();
+    SccAnalysis a;
+    a.component.assign(n, NONE);
+
+    // Tarjan with an explicit call stack of (state, next edge)
+    vector<uint32_t> order(n, NONE), low(n);
+    vector<uint32_t> stack;
+    vector<bool> onStack(n, false);
+    vector<pair<uint32_t, uint64_t>> calls;
+    uint32_t counter = 0;
+    for (uint32_t root = 0; root < n; ++root) {
+        if (order[root] != NONE) continue;
+        calls.push_back({root, g.offset[root]});
+        order[root] = low[root] = counter++;
+        stack.push_back(root);
+        onStack[root] = true;
+        while (!calls.empty()) {
+            uint32_t s = calls.back().first;
+            uint64_t& e = calls.back().second;
+            if (e < g.offset[s + 1]) {
+                uint32_t next = g.target[e++];
+                if (order[next] == NONE) {
+                    order[next] = low[next] = counter++;
+                    stack.push_back(next);
+                    onStack[next] = true;
+                    calls.push_back({next, g.offset[next]});
+                } else if (onStack[next]) {
+                    low[s] = min(low[s], order[next]);
+                }
+                continue;
+            }
+            calls.pop_back();
+            if (!calls.empty()) {
+                uint32_t parent = calls.back().first;
+                low[parent] = min(low[parent], low[s]);
+            }
+            if (low[s] != order[s]) continue;
+            uint32_t member;
+            do {
+                member = stack.back();
+                stack.pop_back();
+                onStack[member] = false;
+                a.component[member] = a.components;
+            } while (member != s);
+            ++a.components;
+        }
+    }
+
+    a.bottom.assign(a.components, true);
+    for (uint32_t s = 0; s < n; ++s) {
+        for (uint64_t e = g.offset[s]; e < g.offset[s + 1]; ++e) {
+            if (a.component[g.target[e]] != a.component[s])
+                a.bottom[a.component[s]] = false;
+        }
+    }
+    for (bool b : a.bottom) a.bottomCount += b;
+    a.reversible = a.components == 1;
+    if (a.bottomCount == 1) {
+        for (uint32_t s = 0; s < n; ++s) {
+            if (a.bottom[a.component[s]]) a.homeStates.push_back(s);
+        }
+    }
+
+    // t is live iff every bottom SCC has a t edge (they never leave it):
+    // count the bottom SCCs per label, visiting states SCC by SCC
+    vector<uint32_t> first(a.components + 1, 0), bySccs(n);
+    for (uint32_t s = 0; s < n; ++s) ++first[a.component[s] + 1];
+    for (uint32_t c = 0; c < a.components; ++c) first[c + 1] += first[c];
+    vector<uint32_t> fill(first.begin(), first.end() - 1);
+    for (uint32_t s = 0; s < n; ++s) bySccs[fill[a.component[s]]++] = s;
+
+    a.fires.assign(g.transitions, false);
+    vector<size_t> bottoms(g.transitions, 0);
+    vector<uint32_t> seenIn(g.transitions, NONE);
+    for (uint32_t s : bySccs) {
+        uint32_t c = a.component[s];
+        for (uint64_t e = g.offset[s]; e < g.offset[s + 1]; ++e) {
+            uint32_t t = g.label[e];
+            a.fires[t] = true;
+            if (a.bottom[c] && seenIn[t] != c) {
+                seenIn[t] = c;
+                ++bottoms[t];
+            }
+        }
+    }
+    a.live.assign(g.transitions, false);
+    for (int t = 0; t < g.transitions; ++t)
+        a.live[t] = bottoms[t] == a.bottomCount;
+    return a;
+}
@@ -0,0 +1,366 @@
+#include "reduction.h"
+
+#include <map>
+
+#include "profiler.h"
+
+using namespace std;
+
+string reductionRuleName(ReductionRule rule) {
+    switch (rule) {
+        case ReductionRule::ConstantPlace:
+            return "constant_place";
+        case ReductionRule::ParallelPlace:
+            return "parallel_place";
+        case ReductionRule::ParallelTransition:
+            return "parallel_transition";
+        case ReductionRule::SeriesPlace:
+            return "series_place";
+        case ReductionRule::SeriesTransition:
+            return "series_transition";
+        case ReductionRule::ImplicitPlace:
+            return "implicit_place";
+    }
+    return "?";
+}
+
+namespace {
+
+// Works on the original P x T matrix: removed places and transitions keep
+// their index with a zero row/column, fused columns live in the survivor.
+class Reducer {
+   public:
+    Reducer(const PetriNet& net, const InvariantBasis& invariants,
+            const PlaceBounds* bounds)
+        : invariants_(invariants),
+          bounds_(bounds),
+          C_(net.incidenceMatrix),
+          M0_(net.initialMarking),
+          P_(static_cast<int>(net.places.size())),
+          T_(static_cast<int>(net.transitions.size())),
+          placeAlive_(P_, true),
+          pinned_(P_, false),
+          transitionAlive_(T_, true),
+          origin_(T_) {
+        for (int t = 0; t < T_; ++t) origin_[t] = {t};
+    }
+
+    void run(NetReduction& out) {
+        out_ = &out;
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            changed |= constantPlaces();
+            changed |= parallelPlaces();
+            changed |= parallelTransitions();
+            changed |= seriesPlaces();
+            changed |= seriesTransitions();
+            changed |= implicitPlaces();
+        }
+    }
+
+    void build(const PetriNet& net, NetReduction& out) {
+        vector<int> newIndex(P_, -1);
+        for (int p = 0; p < P_; ++p) {
+            if (!placeAlive_[p]) continue;
+            newIndex[p] = static_cast<int>(out.net.places.size());
+            out.net.places.push_back(
+                {net.places[p].id, M0_[p], newIndex[p]});
+            out.net.initialMarking.push_back(M0_[p]);
+            out.placeOrigin.push_back(p);
+        }
+        for (int t = 0; t < T_; ++t) {
+            if (!transitionAlive_[t]) continue;
+            string id;
+            for (int u : origin_[t]) {
+                id += (id.empty() ? "" : "+") + net.transitions[u].id;
+            }
+            int index = static_cast<int>(out.net.transitions.size());
+            out.net.transitions.push_back({id, index});
+            out.transitionOrigin.push_back(origin_[t]);
+        }
+        int P = static_cast<int>(out.net.places.size());
+        int T = static_cast<int>(out.net.transitions.size());
+        out.net.incidenceMatrix.assign(P, vector<int>(T, 0));
+        for (int i = 0; i < P; ++i) {
+            int col = 0;
+            for (int t = 0; t < T_; ++t) {
+                if (!transitionAlive_[t]) continue;
+                out.net.incidenceMatrix[i][col++] = C_[out.placeOrigin[i]][t];
+            }
+        }
+    }
+
+   private:
+    void removePlace(int p, ReductionRule rule, int source = -1) {
+        out_->removed.push_back({p, rule, source, M0_[p]});
+        ++out_->applied[static_cast<int>(rule)];
+        if (rule != ReductionRule::ConstantPlace &&
+            rule != ReductionRule::ParallelPlace) {
+            out_->countsExact = false;
+        }
+        placeAlive_[p] = false;
+        for (int t = 0; t < T_; ++t) C_[p][t] = 0;
+    }
+
+    void removeTransition(int t) {
+        transitionAlive_[t] = false;
+        for (int p = 0; p < P_; ++p) C_[p][t] = 0;
+    }
+
+    bool constantPlaces() {
+        bool changed = false;
+        for (int p = 0; p < P_; ++p) {
+            if (!placeAlive_[p]) continue;
+            bool zero = true;
+            for (int t = 0; t < T_ && zero; ++t) zero = C_[p][t] == 0;
+            if (zero) {
+                removePlace(p, ReductionRule::ConstantPlace);
+                changed = true;
+            }
+        }
+        return changed;
+    }
+
+    bool parallelPlaces() {
+        bool changed = false;
+        map<pair<vector<int>, int>, int> seen;  // (row, M0) -> place
+        for (int p = 0; p < P_; ++p) {
+            if (!placeAlive_[p]) continue;
+            auto it = seen.find({C_[p], M0_[p]});
+            if (it == seen.end()) {
+                seen[{C_[p], M0_[p]}] = p;
+            } else {
+                pinned_[it->second] = true;  // expand copies it into p
+                removePlace(p, ReductionRule::ParallelPlace, it->second);
+                changed = true;
+            }
+        }
+        return changed;
+    }
+
+    bool parallelTransitions() {
+        bool changed = false;
+        map<vector<int>, int> seen;
+        for (int t = 0; t < T_; ++t) {
+            if (!transitionAlive_[t]) continue;
+            vector<int> column(P_);
+            for (int p = 0; p < P_; ++p) column[p] = C_[p][t];
+            if (seen.count(column)) {
+                removeTransition(t);
+                ++out_->applied[static_cast<int>(
+                    ReductionRule::ParallelTransition)];
+                changed = true;
+            } else {
+                seen[column] = t;
+            }
+        }
+        return changed;
+    }
+
+    // t1 -> p -> t2, fused into t1;t2 when t2 waits only for p
+    bool seriesPlaces() {
+        bool changed = false;
+        for (int p = 0; p < P_; ++p) {
+            if (!placeAlive_[p] || M0_[p] != 0) continue;
+            int t1 = -1, t2 = -1, producers = 0, consumers = 0;
+            for (int t = 0; t < T_; ++t) {
+                if (C_[p][t] > 0) t1 = t, ++producers;
+                if (C_[p][t] < 0) t2 = t, ++consumers;
+            }
+            if (producers != 1 || consumers != 1) continue;
+
+            bool ok = true;
+            for (int r = 0; r < P_ && ok; ++r) {
+                if (r == p) continue;
+                if (C_[r][t2] < 0) ok = false;  // •t2 = {p}
+                // disjoint effects, so the sum keeps every arc visible
+                if (C_[r][t1] != 0 && C_[r][t2] != 0) ok = false;
+            }
+            if (!ok) continue;
+
+            for (int r = 0; r < P_; ++r) C_[r][t1] += C_[r][t2];
+            origin_[t1].insert(origin_[t1].end(), origin_[t2].begin(),
+                               origin_[t2].end());
+            removeTransition(t2);
+            removePlace(p, ReductionRule::SeriesPlace);
+            changed = true;
+        }
+        return changed;
+    }
+
+    // p -> t -> q with p• = {t}: producers of p mark q directly
+    bool seriesTransitions() {
+        bool changed = false;
+        for (int t = 0; t < T_; ++t) {
+            if (!transitionAlive_[t]) continue;
+            int p = -1, q = -1, inputs = 0, outputs = 0;
+            for (int r = 0; r < P_; ++r) {
+                if (C_[r][t] < 0) p = r, ++inputs;
+                if (C_[r][t] > 0) q = r, ++outputs;
+            }
+            if (inputs != 1 || outputs != 1 || M0_[p] != 0) continue;
+
+            bool ok = true;
+            for (int u = 0; u < T_ && ok; ++u) {
+                if (u != t && C_[p][u] < 0) ok = false;  // p• = {t}
+                if (C_[p][u] > 0 && C_[q][u] != 0) ok = false;
+            }
+            if (!ok) continue;
+
+            for (int u = 0; u < T_; ++u) {
+                if (C_[p][u] <= 0) continue;
+                C_[q][u] += C_[p][u];
+                origin_[u].insert(origin_[u].end(), origin_[t].begin(),
+                                  origin_[t].end());
+            }
+            removeTransition(t);
+            removePlace(p, ReductionRule::SeriesTransition);
+            changed = true;
+        }
+        return changed;
+    }
+
+    // p may go only if it is bounded and expand can rebuild it: some
+    // P-invariant of the original net weighs p. Its other places are then
+    // pinned, so none of them is removed the same way later on and the
+    // invariant stays solvable for p.
+    bool rebuildable(int p) {
+        if (bounds_ == nullptr || bounds_->bound[p] < 0 || pinned_[p])
+            return false;
+        for (const auto& y : invariants_.vectors) {
+            bool weighs = false;
+            for (const auto& e : y) weighs |= e.first == p;
+            if (!weighs) continue;
+            for (const auto& e : y)
+                if (e.first != p) pinned_[e.first] = true;
+            return true;
+        }
+        return false;
+    }
+
+    // M = M0 + C sigma with sigma >= 0 gives M(p) - M(q) >= 0 when
+    // M0(p) >= M0(q) and C[p] >= C[q] column-wise; C[p][t] < 0 then implies
+    // C[q][t] <= C[p][t], so q is consumed at least as much as p.
+    bool implicitPlaces() {
+        bool changed = false;
+        for (int p = 0; p < P_; ++p) {
+            if (!placeAlive_[p]) continue;
+            int firstConsumer = -1;
+            for (int t = 0; t < T_ && firstConsumer < 0; ++t) {
+                if (C_[p][t] < 0) firstConsumer = t;
+            }
+            if (firstConsumer < 0) {
+                // never consumed: never disables anything
+                if (!rebuildable(p)) continue;
+                removePlace(p, ReductionRule::ImplicitPlace);
+                changed = true;
+                continue;
+            }
+            for (int q = 0; q < P_; ++q) {
+                if (q == p || !placeAlive_[q] || M0_[q] > M0_[p] ||
+                    C_[q][firstConsumer] >= 0)
+                    continue;
+                bool dominated = true;
+                for (int t = 0; t < T_ && dominated; ++t) {
+                    dominated = C_[q][t] <= C_[p][t];
+                }
+                if (dominated) {
+                    if (!rebuildable(p)) break;
+                    removePlace(p, ReductionRule::ImplicitPlace, q);
+                    changed = true;
+                    break;
+                }
+            }
+        }
+        return changed;
+    }
+
+    const InvariantBasis& invariants_;
+    const PlaceBounds* bounds_;
+    vector<vector<int>> C_;
+    Marking M0_;
+    int P_, T_;
+    vector<bool> placeAlive_;
+    vector<bool> pinned_;  // some removed place is rebuilt from it
+    vector<bool> transitionAlive_;
+    vector<vector<int>> origin_;
+    NetReduction* out_ = nullptr;
+};
+
+}  // namespace
+
+NetReduction reduceNet(const PetriNet& net, const PlaceBounds* bounds) {
+    PROFILE_SCOPE("reduceNet");
+    NetReduction out;
+    out.originalPlaces = static_cast<int>(net.places.size());
+    out.originalTransitions = static_cast<int>(net.transitions.size());
+    out.originalInitial = net.initialMarking;
+    out.originalInvariants = pInvariantBasis(net.incidenceMatrix);
+
+    Reducer reducer(net, out.originalInvariants, bounds);
+    reducer.run(out);
+    reducer.build(net, out);
+    return out;
+}
+
+Marking NetReduction::expand(const Marking& reduced) const {
+    Marking full(originalPlaces, 0);
+    vector<bool> known(originalPlaces, false);
+    for (size_t i = 0; i < placeOrigin.size(); ++i) {
+        full[placeOrigin[i]] = reduced[i];
+        known[placeOrigin[i]] = true;
+    }
+
+    // A removed place may depend on one removed later: repeat until stable
+    bool progress = true;
+    while (progress) {
+        progress = false;
+        for (const auto& r : removed) {
+            if (known[r.place]) continue;
+            switch (r.rule) {
+                case ReductionRule::ConstantPlace:
+                    full[r.place] = r.value;
+                    break;
+                case ReductionRule::ParallelPlace:
+                    if (!known[r.source]) continue;
+                    full[r.place] = full[r.source];
+                    break;
+                case ReductionRule::SeriesPlace:
+                case ReductionRule::SeriesTransition:
+                    full[r.place] = 0;
+                    break;
+                case ReductionRule::ImplicitPlace: {
+                    // y . M = y . M0 with every other place of y known
+                    bool solved = false;
+                    for (const auto& y : originalInvariants.vectors) {
+                        long long a = 0, rest = 0;
+                        bool usable = true;
+                        for (const auto& e : y) {
+                            rest += e.second * originalInitial[e.first];
+                            if (e.first == r.place) {
+                                a = e.second;
+                            } else if (known[e.first]) {
+                                rest -= e.second * full[e.first];
+                            } else {
+                                usable = false;
+                            }
+                        }
+                        if (a != 0 && usable && rest % a == 0) {
+                            full[r.place] = static_cast<int>(rest / a);
+                            solved = true;
+                            break;
+                        }
+                    }
+                    if (!solved) continue;
+                    break;
+                }
+                default:
+                    continue;
+            }
+            known[r.place] = true;
+            progress = true;
+        }
+    }
+    return full;
+}
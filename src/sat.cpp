@@ -0,0 +1,275 @@
+#include "sat.h"
+
+#include <algorithm>
+
+using namespace std;
+
+int SatSolver::newVar() {
+    int v = static_cast<int>(value_.size());
+    value_.push_back(-1);
+    level_.push_back(0);
+    reason_.push_back(-1);
+    phase_.push_back(false);
+    seen_.push_back(false);
+    activity_.push_back(0);
+    heapIndex_.push_back(-1);
+    watches_.resize(2 * (v + 1));
+    heapInsert(v);
+    return v + 1;
+}
+
+int8_t SatSolver::litValue(int l) const {
+    int8_t v = value_[l >> 1];
+    return v < 0 ? -1 : static_cast<int8_t>(v ^ (l & 1));
+}
+
+void SatSolver::assign(int l, int reason) {
+    int v = l >> 1;
+    value_[v] = static_cast<int8_t>(!(l & 1));
+    level_[v] = static_cast<int>(trailLim_.size());
+    reason_[v] = reason;
+    trail_.push_back(l);
+}
+
+int SatSolver::attach(const vector<int>& clause) {
+    int id = static_cast<int>(clauses_.size());
+    clauses_.push_back(clause);
+    watches_[clause[0]].push_back(id);
+    watches_[clause[1]].push_back(id);
+    return id;
+}
+
+void SatSolver::addClause(const vector<int>& lits) {
+    if (unsat_) return;
+    vector<int> c;
+    for (int d : lits) c.push_back(lit(d));
+    sort(c.begin(), c.end());
+    c.erase(unique(c.begin(), c.end()), c.end());
+    for (size_t i = 1; i < c.size(); ++i) {
+        if ((c[i] ^ 1) == c[i - 1]) return;  // tautology
+    }
+    // clauses are added before solving, at level 0
+    vector<int> open;
+    for (int l : c) {
+        int8_t v = litValue(l);
+        if (v == 1) return;
+        if (v < 0) open.push_back(l);
+    }
+    if (open.empty()) {
+        unsat_ = true;
+    } else if (open.size() == 1) {
+        assign(open[0], -1);
+        if (propagate() >= 0) unsat_ = true;
+    } else {
+        attach(open);
+    }
+}
+
+int SatSolver::propagate() {
+    while (qhead_ < trail_.size()) {
+        int falseLit = trail_[qhead_++] ^ 1;
+        vector<int>& ws = watches_[falseLit];
+        size_t keep = 0;
+        for (size_t i = 0; i < ws.size(); ++i) {
+            int id = ws[i];
+            vector<int>& c = clauses_[id];
+            if (c[0] == falseLit) swap(c[0], c[1]);
+            if (litValue(c[0]) == 1) {
+                ws[keep++] = id;
+                continue;
+            }
+            bool moved = false;
+            for (size_t k = 2; k < c.size(); ++k) {
+                if (litValue(c[k]) != 0) {
+                    swap(c[1], c[k]);
+                    watches_[c[1]].push_back(id);
+                    moved = true;
+                    break;
+                }
+            }
+            if (moved) continue;
+            ws[keep++] = id;
+            if (litValue(c[0]) == 0) {
+                for (++i; i < ws.size(); ++i) ws[keep++] = ws[i];
+                ws.resize(keep);
+                return id;
+            }
+            assign(c[0], id);
+        }
+        ws.resize(keep);
+    }
+    return -1;
+}
+
+void SatSolver::bump(int var) {
+    activity_[var] += bumpBy_;
+    if (activity_[var] > 1e100) {
+        for (double& a : activity_) a *= 1e-100;
+        bumpBy_ *= 1e-100;
+    }
+    if (heapIndex_[var] >= 0) heapUp(heapIndex_[var]);
+}
+
+void SatSolver::analyze(int conflict, vector<int>& learnt, int& backLevel) {
+    int current = static_cast<int>(trailLim_.size());
+    learnt.assign(1, -1);  // slot for the asserting literal
+    int pending = 0;
+    int p = -1;
+    size_t index = trail_.size();
+    int reason = conflict;
+    do {
+        const vector<int>& c = clauses_[reason];
+        for (size_t j = (p < 0 ? 0 : 1); j < c.size(); ++j) {
+            int q = c[j];
+            int v = q >> 1;
+            if (seen_[v] || level_[v] == 0) continue;
+            seen_[v] = true;
+            bump(v);
+            if (level_[v] == current) {
+                ++pending;
+            } else {
+                learnt.push_back(q);
+            }
+        }
+        do {
+            p = trail_[--index];
+        } while (!seen_[p >> 1]);
+        seen_[p >> 1] = false;
+        reason = reason_[p >> 1];
+        --pending;
+        // the reason clause keeps its implied literal first
+        if (pending > 0 && clauses_[reason][0] != p) {
+            auto& rc = clauses_[reason];
+            auto it = find(rc.begin(), rc.end(), p);
+            swap(*it, rc[0]);
+        }
+    } while (pending > 0);
+    learnt[0] = p ^ 1;
+
+    backLevel = 0;
+    size_t best = 1;
+    for (size_t i = 1; i < learnt.size(); ++i) {
+        seen_[learnt[i] >> 1] = false;
+        if (level_[learnt[i] >> 1] > backLevel) {
+            backLevel = level_[learnt[i] >> 1];
+            best = i;
+        }
+    }
+    if (learnt.size() > 1) swap(learnt[1], learnt[best]);
+    bumpBy_ *= 1.05;
+}
+
+void SatSolver::backtrack(int level) {
+    if (static_cast<int>(trailLim_.size()) <= level) return;
+    for (size_t i = trail_.size(); i > size_t(trailLim_[level]); --i) {
+        int v = trail_[i - 1] >> 1;
+        phase_[v] = value_[v] == 1;
+        value_[v] = -1;
+        reason_[v] = -1;
+        if (heapIndex_[v] < 0) heapInsert(v);
+    }
+    trail_.resize(trailLim_[level]);
+    trailLim_.resize(level);
+    qhead_ = trail_.size();
+}
+
+int SatSolver::pickBranch() {
+    while (!heap_.empty()) {
+        int v = heapPop();
+        if (value_[v] < 0) return v;
+    }
+    return -1;
+}
+
+void SatSolver::heapUp(int i) {
+    int v = heap_[i];
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (activity_[heap_[parent]] >= activity_[v]) break;
+        heap_[i] = heap_[parent];
+        heapIndex_[heap_[i]] = i;
+        i = parent;
+    }
+    heap_[i] = v;
+    heapIndex_[v] = i;
+}
+
+void SatSolver::heapDown(int i) {
+    int v = heap_[i];
+    int n = static_cast<int>(heap_.size());
+    while (2 * i + 1 < n) {
+        int child = 2 * i + 1;
+        if (child + 1 < n && activity_[heap_[child + 1]] > activity_[heap_[child]])
+            ++child;
+        if (activity_[heap_[child]] <= activity_[v]) break;
+        heap_[i] = heap_[child];
+        heapIndex_[heap_[i]] = i;
+        i = child;
+    }
+    heap_[i] = v;
+    heapIndex_[v] = i;
+}
+
+void SatSolver::heapInsert(int var) {
+    heap_.push_back(var);
+    heapUp(static_cast<int>(heap_.size()) - 1);
+}
+
+int SatSolver::heapPop() {
+    int top = heap_[0];
+    heapIndex_[top] = -1;
+    heap_[0] = heap_.back();
+    heap_.pop_back();
+    if (!heap_.empty()) {
+        heapIndex_[heap_[0]] = 0;
+        heapDown(0);
+    }
+    return top;
+}
+
+SatSolver::Result SatSolver::solve(size_t maxConflicts) {
+    if (unsat_) return Unsat;
+    size_t restartAt = 100;
+    size_t sinceRestart = 0;
+    vector<int> learnt;
+    while (true) {
+        int conflict = propagate();
+        if (conflict >= 0) {
+            ++conflicts_;
+            ++sinceRestart;
+            if (trailLim_.empty()) {
+                unsat_ = true;
+                return Unsat;
+            }
+            int backLevel;
+            analyze(conflict, learnt, backLevel);
+            backtrack(backLevel);
+            if (learnt.size() == 1) {
+                assign(learnt[0], -1);
+            } else {
+                assign(learnt[0], attach(learnt));
+            }
+            if (maxConflicts > 0 && conflicts_ >= maxConflicts) {
+                backtrack(0);
+                return Unknown;
+            }
+            continue;
+        }
+        if (sinceRestart >= restartAt) {
+            sinceRestart = 0;
+            restartAt += restartAt / 2;
+            backtrack(0);
+            continue;
+        }
+        int v = pickBranch();
+        if (v < 0) {
+            model_.assign(value_.size(), false);
+            for (size_t i = 0; i < value_.size(); ++i) model_[i] = value_[i] == 1;
+            backtrack(0);
+            return Sat;
+        }
+        ++decisions_;
+        trailLim_.push_back(static_cast<int>(trail_.size()));
+        assign(2 * v + (phase_[v] ? 0 : 1), -1);
+    }
+}
@@ -0,0 +1,738 @@
+#include "server.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <cstring>
+#include <thread>
+#include <unordered_map>
+
+#include "bdd.h"
+#include "bounds.h"
+#include "deadlock_ILP.h"
+#include "optimization.h"
+#include "optimization_add.h"
+#include "thread_pool.h"
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+// ---------- Minimal JSON (requests are small flat objects) ----------
+
+struct Json {
+    enum Type { Null, Bool, Number, String, Array, Object } type = Null;
+    bool boolean = false;
+    double number = 0;
+    string text;
+    vector<Json> items;                  // Array
+    vector<pair<string, Json>> fields;  // Object
+
+    const Json* get(const string& key) const {
+        for (const auto& f : fields) {
+            if (f.first == key) return &f.second;
+        }
+        return nullptr;
+    }
+};
+
+class JsonParser {
+   public:
+    explicit JsonParser(const string& s) : s_(s) {}
+
+    bool parse(Json& out) {
+        if (!value(out)) return false;
+        skipSpace();
+        return pos_ == s_.size();
+    }
+
+   private:
+    void skipSpace() {
+        while (pos_ < s_.size() && isspace((unsigned char)s_[pos_])) ++pos_;
+    }
+
+    bool literal(const char* word) {
+        size_t n = char_traits<char>::length(word);
+        if (s_.compare(pos_, n, word) != 0) return false;
+        pos_ += n;
+        return true;
+    }
+
+    bool str(string& out) {
+        if (pos_ >= s_.size() || s_[pos_] != '"') return false;
+        ++pos_;
+        while (pos_ < s_.size() && s_[pos_] != '"') {
+            char c = s_[pos_++];
+            if (c == '\\' && pos_ < s_.size()) {
+                char e = s_[pos_++];
+                c = (e == 'n') ? '\n' : (e == 't') ? '\t' : e;
+            }
+            out += c;
+        }
+        if (pos_ >= s_.size()) return false;
+        ++pos_;
+        return true;
+    }
+
+    bool value(Json& out) {
+        skipSpace();
+        if (pos_ >= s_.size()) return false;
+        char c = s_[pos_];
+        if (c == '{') {
+            out.type = Json::Object;
+            ++pos_;
+            skipSpace();
+            if (pos_ < s_.size() && s_[pos_] == '}') return ++pos_, true;
+            while (true) {
+                skipSpace();
+                string key;
+                if (!str(key)) return false;
+                skipSpace();
+                if (pos_ >= s_.size() || s_[pos_++] != ':') return false;
+                Json v;
+                if (!value(v)) return false;
+                out.fields.push_back({key, std::move(v)});
+                skipSpace();
+                if (pos_ < s_.size() && s_[pos_] == ',') {
+                    ++pos_;
+                    continue;
+                }
+                return pos_ < s_.size() && s_[pos_++] == '}';
+            }
+        }
+        if (c == '[') {
+            out.type = Json::Array;
+            ++pos_;
+            skipSpace();
+            if (pos_ < s_.size() && s_[pos_] == ']') return ++pos_, true;
+            while (true) {
+                Json v;
+                if (!value(v)) return false;
+                out.items.push_back(std::move(v));
+                skipSpace();
+                if (pos_ < s_.size() && s_[pos_] == ',') {
+                    ++pos_;
+                    continue;
+                }
+                return pos_ < s_.size() && s_[pos_++] == ']';
+            }
+        }
+        if (c == '"') {
+            out.type = Json::String;
+            return str(out.text);
+        }
+        if (literal("true")) {
+            out.type = Json::Bool;
+            out.boolean = true;
+            return true;
+        }
+        if (literal("false")) {
+            out.type = Json::Bool;
+            return true;
+        }
+        if (literal("null")) return true;
+
+        size_t end = pos_;
+        while (end < s_.size() &&
+               (isdigit((unsigned char)s_[end]) || strchr("+-.eE", s_[end])))
+            ++end;
+        if (end == pos_) return false;
+        // strtod must take the whole token: "-" or "1e" is malformed
+        string token = s_.substr(pos_, end - pos_);
+        char* stop = nullptr;
+        out.type = Json::Number;
+        out.number = strtod(token.c_str(), &stop);
+        if (stop != token.c_str() + token.size() || !isfinite(out.number))
+            return false;
+        pos_ = end;
+        return true;
+    }
+
+    const string& s_;
+    size_t pos_ = 0;
+};
+
+string jsonString(const string& s) {
+    string out = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        if (c == '\n') {
+            out += "\\n";
+            continue;
+        }
+        out += c;
+    }
+    return out + "\"";
+}
+
+string jsonArray(const vector<int>& v) {
+    string s = "[";
+    for (size_t i = 0; i < v.size(); ++i) {
+        s += (i ? ", " : "") + to_string(v[i]);
+    }
+    return s + "]";
+}
+
+bool intArray(const Json* j, vector<int>& out) {
+    if (j == nullptr || j->type != Json::Array) return false;
+    out.clear();
+    for (const auto& item : j->items) {
+        if (item.type != Json::Number) return false;
+        double v = item.number;
+        if (v != floor(v) || v < INT_MIN || v > INT_MAX) return false;
+        out.push_back(static_cast<int>(v));
+    }
+    return true;
+}
+
+// ---------- Net cache ----------
+
+// FNV-1a over the PNML bytes
+uint64_t hashBytes(const string& bytes) {
+    uint64_t h = 1469598103934665603ull;
+    for (unsigned char c : bytes) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+struct NetEntry {
+    mutex lock;  // one CUDD manager per net: serialize work on it
+    bool ready = false;
+    string error;
+    PetriNet net;
+    PlaceBounds bounds;
+    // 1-safe nets: one variable per place in ctx; otherwise binary
+    // counters (boundedEncoding) in er, with ctx.mgr and ctx.R aliasing it
+    bool encoded = false;
+    ReachableContext ctx;
+    EncodedReachable er;
+    double states = 0;
+
+    ~NetEntry() {
+        if (encoded) {
+            freeEncodedReachable(er);
+        } else {
+            freeReachableContext(ctx);
+        }
+    }
+};
+
+class NetCache {
+   public:
+    explicit NetCache(size_t capacity) : capacity_(max<size_t>(1, capacity)) {}
+
+    // Entry for hash, created (not yet built) on a miss
+    shared_ptr<NetEntry> get(uint64_t hash) {
+        lock_guard<mutex> guard(mutex_);
+        auto it = entries_.find(hash);
+        if (it != entries_.end()) {
+            order_.splice(order_.begin(), order_, it->second.second);
+            return it->second.first;
+        }
+        order_.push_front(hash);
+        auto entry = make_shared<NetEntry>();
+        entries_[hash] = {entry, order_.begin()};
+        while (entries_.size() > capacity_) {
+            // requests still holding the evicted entry keep it alive
+            entries_.erase(order_.back());
+            order_.pop_back();
+            ++evictions_;
+        }
+        return entry;
+    }
+
+    size_t size() {
+        lock_guard<mutex> guard(mutex_);
+        return entries_.size();
+    }
+
+    long evictions() {
+        lock_guard<mutex> guard(mutex_);
+        return evictions_;
+    }
+
+   private:
+    mutex mutex_;
+    size_t capacity_;
+    list<uint64_t> order_;  // most recently used first
+    unordered_map<uint64_t,
+                  pair<shared_ptr<NetEntry>, list<uint64_t>::iterator>>
+        entries_;
+    long evictions_ = 0;
+};
+
+// ---------- Latency metrics ----------
+
+struct OpMetrics {
+    long count = 0;
+    long errors = 0;
+    double totalUs = 0;
+    double maxUs = 0;
+    vector<double> recent;  // ring of the last RECENT latencies
+    size_t next = 0;
+};
+
+const size_t RECENT = 1024;
+
+class Metrics {
+   public:
+    void record(const string& op, double us, bool ok) {
+        lock_guard<mutex> guard(mutex_);
+        OpMetrics& m = ops_[op];
+        ++m.count;
+        if (!ok) ++m.errors;
+        m.totalUs += us;
+        m.maxUs = max(m.maxUs, us);
+        if (m.recent.size() < RECENT) {
+            m.recent.push_back(us);
+        } else {
+            m.recent[m.next] = us;
+            m.next = (m.next + 1) % RECENT;
+        }
+    }
+
+    void hit(bool cached) {
+        lock_guard<mutex> guard(mutex_);
+        (cached ? hits_ : misses_)++;
+    }
+
+    string json() {
+        lock_guard<mutex> guard(mutex_);
+        ostringstream out;
+        out << "\"cache_hits\": " << hits_ << ", \"cache_misses\": "
+            << misses_ << ", \"ops\": {";
+        bool first = true;
+        for (auto& [op, m] : ops_) {
+            vector<double> sorted = m.recent;
+            sort(sorted.begin(), sorted.end());
+            auto pct = [&](double q) {
+                if (sorted.empty()) return 0.0;
+                return sorted[(size_t)(q * (sorted.size() - 1))];
+            };
+            out << (first ? "" : ", ") << jsonString(op) << ": {\"count\": "
+                << m.count << ", \"errors\": " << m.errors
+                << ", \"mean_us\": " << (m.count ? m.totalUs / m.count : 0)
+                << ", \"p50_us\": " << pct(0.5) << ", \"p99_us\": " << pct(0.99)
+                << ", \"max_us\": " << m.maxUs << "}";
+            first = false;
+        }
+        out << "}";
+        return out.str();
+    }
+
+   private:
+    mutex mutex_;
+    map<string, OpMetrics> ops_;
+    long hits_ = 0;
+    long misses_ = 0;
+};
+
+// ---------- Request handling ----------
+
+// Engines report progress on cout; the server answers through its own
+// channel, so cout is pointed at this sink for the server's lifetime.
+class NullBuffer : public streambuf {
+   protected:
+    int overflow(int c) override { return c; }
+    streamsize xsputn(const char*, streamsize n) override { return n; }
+};
+
+struct Server {
+    ServerOptions options;
+    NetCache cache;
+    Metrics metrics;
+    atomic<bool> stopping{false};
+    int listenFd = -1;
+
+    explicit Server(const ServerOptions& opt)
+        : options(opt), cache(opt.cacheSize) {}
+};
+
+bool readFile(const string& path, string& bytes) {
+    ifstream in(path, ios::binary);
+    if (!in.is_open()) return false;
+    ostringstream ss;
+    ss << in.rdbuf();
+    bytes = ss.str();
+    return true;
+}
+
+// Builds the entry from the bytes it is cached under, on first use;
+// entry->lock must be held.
+void ensureBuilt(NetEntry& e, const string& bytes) {
+    if (e.ready || !e.error.empty()) return;
+    RawData raw = rawFromText(bytes);
+    if (raw.Blocks.empty()) {
+        e.error = "failed to parse data or file is empty";
+        return;
+    }
+    e.net = toPetriNet(raw);
+    e.bounds = computePlaceBounds(e.net);
+    if (e.bounds.unboundedPlace >= 0) {
+        e.error = "place " + e.net.places[e.bounds.unboundedPlace].id +
+                  " is unbounded (main.exe --engine explicit=coverability "
+                  "explores it)";
+        return;
+    }
+    if (!e.bounds.allBounded()) {
+        e.error = "no token bound found within the sweep";
+        return;
+    }
+    e.encoded = !e.bounds.oneSafe();
+    int nvars = static_cast<int>(e.net.places.size());
+    if (e.encoded) {
+        e.er = symbolicReachability(e.net, boundedEncoding(e.bounds));
+        e.ctx.mgr = e.er.mgr;
+        e.ctx.R = e.er.R;
+        nvars = e.er.nvars;
+    } else {
+        e.ctx = buildReachableContext(e.net);
+    }
+    e.states = Cudd_CountMinterm(e.ctx.mgr, e.ctx.R, nvars);
+    e.ready = true;
+}
+
+// Result fields of one op, or an error message
+bool runOp(Server& server, const string& op, const Json& req, string& result,
+           string& error, bool& cached) {
+    if (op == "stats") {
+        result = server.metrics.json() +
+                 ", \"cache_entries\": " + to_string(server.cache.size()) +
+                 ", \"cache_evictions\": " +
+                 to_string(server.cache.evictions());
+        return true;
+    }
+    if (op == "shutdown") {
+        server.stopping = true;
+#ifndef _WIN32
+        if (server.listenFd >= 0) shutdown(server.listenFd, SHUT_RDWR);
+#endif
+        return true;
+    }
+
+    const Json* netField = req.get("net");
+    if (netField == nullptr || netField->type != Json::String) {
+        error = "missing \"net\" (path of a PNML file)";
+        return false;
+    }
+    string bytes;
+    if (!readFile(netField->text, bytes)) {
+        error = "cannot read " + netField->text;
+        return false;
+    }
+
+    shared_ptr<NetEntry> entry = server.cache.get(hashBytes(bytes));
+    lock_guard<mutex> guard(entry->lock);
+    cached = entry->ready;
+    server.metrics.hit(cached);
+    ensureBuilt(*entry, bytes);
+    if (!entry->error.empty()) {
+        error = entry->error;
+        return false;
+    }
+
+    const PetriNet& net = entry->net;
+    ReachableContext& ctx = entry->ctx;
+    int P = static_cast<int>(net.places.size());
+
+    if (op == "load" || op == "count") {
+        ostringstream out;
+        out << "\"places\": " << P
+            << ", \"transitions\": " << net.transitions.size()
+            << ", \"states\": " << entry->states
+            << ", \"bdd_nodes\": " << Cudd_DagSize(ctx.R)
+            << ", \"max_bound\": " << entry->bounds.maxBound();
+        result = out.str();
+    } else if (op == "reachable") {
+        vector<int> M;
+        if (!intArray(req.get("marking"), M) || (int)M.size() != P) {
+            error = "\"marking\" must list " + to_string(P) + " token counts";
+            return false;
+        }
+        // counts above a bound do not fit the encoding
+        bool fits = true;
+        for (int p = 0; p < P; ++p)
+            fits &= M[p] >= 0 && M[p] <= entry->bounds.bound[p];
+        bool inR = false;
+        if (fits && entry->encoded) {
+            DdNode* m = markingBDD(ctx.mgr, entry->er.enc, M);
+            inR = Cudd_bddLeq(ctx.mgr, m, ctx.R);
+            Cudd_RecursiveDeref(ctx.mgr, m);
+        } else if (fits) {
+            inR = is_marking_in_R(ctx.mgr, ctx.R, ctx.x, M);
+        }
+        result = string("\"reachable\": ") + (inR ? "true" : "false");
+    } else if (op == "deadlock") {
+        DdNode* dead = entry->encoded
+                           ? deadMarkingsBDD(ctx.mgr, net, entry->er.enc)
+                           : deadMarkingsBDD(ctx.mgr, net, ctx.x);
+        DdNode* reachableDead = Cudd_bddAnd(ctx.mgr, ctx.R, dead);
+        Cudd_Ref(reachableDead);
+        Cudd_RecursiveDeref(ctx.mgr, dead);
+        vector<char> cube(Cudd_ReadSize(ctx.mgr));
+        if (reachableDead != Cudd_ReadLogicZero(ctx.mgr) &&
+            Cudd_bddPickOneCube(ctx.mgr, reachableDead, cube.data())) {
+            vector<int> M(P);
+            if (entry->encoded) {
+                M = decodeMarking(entry->er.enc, cube);
+            } else {
+                for (int p = 0; p < P; ++p) M[p] = (cube[p] == 1) ? 1 : 0;
+            }
+            result = "\"deadlock\": true, \"marking\": " + jsonArray(M);
+        } else {
+            result = "\"deadlock\": false";
+        }
+        Cudd_RecursiveDeref(ctx.mgr, reachableDead);
+    } else if (op == "optimize") {
+        vector<int> costs;
+        const Json* costsField = req.get("costs");
+        if (costsField == nullptr) {
+            costs.assign(P, 1);
+        } else if (!intArray(costsField, costs)) {
+            error = "\"costs\" must list integers";
+            return false;
+        }
+        costs.resize(P, 0);
+        // w * M(p) * M(q) terms, as --costs-pair
+        AddObjective objective = linearObjective(costs);
+        if (const Json* pairs = req.get("costs_pair")) {
+            bool valid = pairs->type == Json::Array;
+            for (size_t i = 0; valid && i < pairs->items.size(); ++i) {
+                vector<int> t;
+                valid = intArray(&pairs->items[i], t) && t.size() == 3 &&
+                        t[0] >= 0 && t[0] < P && t[1] >= 0 && t[1] < P;
+                if (valid)
+                    objective.pairwise.push_back({t[0], t[1], double(t[2])});
+            }
+            if (!valid) {
+                error = "\"costs_pair\" must list [place, place, weight]";
+                return false;
+            }
+        }
+        // the recursive engine reads one bit per place and sums linear
+        // costs only
+        OptimizationTask5Result r =
+            entry->encoded
+                ? optimizationADD(ctx.mgr, ctx.R, entry->er.enc, objective)
+            : !objective.pairwise.empty()
+                ? optimizationADD(ctx.mgr, ctx.R, oneBitEncoding(P), objective)
+                : optimizationTask5Function(ctx.mgr, ctx.R, costs);
+        ostringstream out;
+        out << "\"found\": " << (r.found ? "true" : "false");
+        if (r.found) {
+            out << ", \"max_value\": " << r.maxValue
+                << ", \"marking\": " << jsonArray(r.optimalMarking);
+        }
+        result = out.str();
+    } else {
+        error = "unknown op " + op;
+        return false;
+    }
+    return true;
+}
+
+string handleLine(Server& server, const string& line,
+                  chrono::steady_clock::time_point received) {
+    Json req;
+    string idField = "null";
+    string op = "?";
+    string result, error;
+    bool cached = false;
+    bool ok = false;
+
+    JsonParser parser(line);
+    if (!parser.parse(req) || req.type != Json::Object) {
+        error = "malformed JSON request";
+    } else {
+        if (const Json* id = req.get("id")) {
+            if (id->type == Json::Number) {
+                ostringstream s;
+                s << id->number;
+                idField = s.str();
+            } else if (id->type == Json::String) {
+                idField = jsonString(id->text);
+            }
+        }
+        const Json* opField = req.get("op");
+        if (opField == nullptr || opField->type != Json::String) {
+            error = "missing \"op\"";
+        } else {
+            op = opField->text;
+            ok = runOp(server, op, req, result, error, cached);
+        }
+    }
+
+    double us = chrono::duration<double, micro>(chrono::steady_clock::now() -
+                                                received)
+                    .count();
+    server.metrics.record(op, us, ok);
+
+    ostringstream out;
+    out << "{\"id\": " << idField << ", \"ok\": " << (ok ? "true" : "false");
+    if (ok) {
+        out << ", \"cached\": " << (cached ? "true" : "false");
+        if (!result.empty()) out << ", " << result;
+    } else {
+        out << ", \"error\": " << jsonString(error);
+    }
+    out << ", \"latency_us\": " << static_cast<long long>(us) << "}\n";
+    return out.str();
+}
+
+// ---------- Transports ----------
+
+int serveStdin(Server& server) {
+    ThreadPool pool(server.options.threads);
+    mutex outLock;
+    string line;
+    while (!server.stopping && getline(cin, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
+        auto received = chrono::steady_clock::now();
+        pool.submit([&server, &outLock, line, received] {
+            string response = handleLine(server, line, received);
+            lock_guard<mutex> guard(outLock);
+            fwrite(response.data(), 1, response.size(), stdout);
+            fflush(stdout);
+        });
+    }
+    pool.wait();
+    return 0;
+}
+
+#ifndef _WIN32
+// Closed with its last reference: the reader's, or the last queued answer's
+struct Connection {
+    int fd;
+    mutex writeLock;
+    explicit Connection(int f) : fd(f) {}
+    ~Connection() { close(fd); }
+};
+
+// Open connections, each read by a detached thread that removes its own
+// entry when the client hangs up
+struct Clients {
+    mutex lock;
+    condition_variable closed;
+    list<shared_ptr<Connection>> open;
+};
+
+void readConnection(Server& server, ThreadPool& pool, Clients& clients,
+                    list<shared_ptr<Connection>>::iterator it) {
+    shared_ptr<Connection> conn = *it;
+    string buffer;
+    char chunk[4096];
+    ssize_t n;
+    while ((n = recv(conn->fd, chunk, sizeof(chunk), 0)) > 0) {
+        buffer.append(chunk, n);
+        size_t nl;
+        while ((nl = buffer.find('\n')) != string::npos) {
+            string line = buffer.substr(0, nl);
+            buffer.erase(0, nl + 1);
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.empty()) continue;
+            auto received = chrono::steady_clock::now();
+            pool.submit([&server, conn, line, received] {
+                string response = handleLine(server, line, received);
+                lock_guard<mutex> guard(conn->writeLock);
+                send(conn->fd, response.data(), response.size(), MSG_NOSIGNAL);
+            });
+        }
+    }
+    lock_guard<mutex> guard(clients.lock);
+    clients.open.erase(it);
+    clients.closed.notify_all();
+}
+
+int serveSocket(Server& server) {
+    const string& path = server.options.socketPath;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (fd < 0 || path.size() >= sizeof(addr.sun_path)) {
+        cerr << "Error: cannot create socket " << path << "\n";
+        return 1;
+    }
+    path.copy(addr.sun_path, path.size());
+    unlink(path.c_str());
+    if (bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 64) != 0) {
+        cerr << "Error: cannot listen on " << path << "\n";
+        close(fd);
+        return 1;
+    }
+    server.listenFd = fd;
+    cerr << "Serving on " << path << "\n";
+
+    ThreadPool pool(server.options.threads);
+    Clients clients;
+    while (!server.stopping) {
+        int client = accept(fd, nullptr, nullptr);
+        if (client < 0) break;
+        lock_guard<mutex> guard(clients.lock);
+        clients.open.push_front(make_shared<Connection>(client));
+        thread(readConnection, ref(server), ref(pool), ref(clients),
+               clients.open.begin())
+            .detach();
+    }
+    // Stop reading from clients that are still connected; answers to the
+    // requests already queued are still sent.
+    {
+        unique_lock<mutex> guard(clients.lock);
+        for (auto& conn : clients.open) shutdown(conn->fd, SHUT_RD);
+        clients.closed.wait(guard, [&] { return clients.open.empty(); });
+    }
+    pool.wait();
+    close(fd);
+    unlink(path.c_str());
+    return 0;
+}
+#endif
+
+}  // namespace
+
+int runServer(const ServerOptions& options) {
+    Server server(options);
+    NullBuffer sink;
+    streambuf* old = cout.rdbuf(&sink);
+
+    int rc;
+    if (options.socketPath.empty()) {
+        rc = serveStdin(server);
+    } else {
+#ifndef _WIN32
+        rc = serveSocket(server);
+#else
+        cerr << "Error: Unix sockets are not available, serve stdin instead\n";
+        rc = 1;
+#endif
+    }
+
+    cout.rdbuf(old);
+    return rc;
+}
+
+string serverRequest(const string& line) {
+    static Server server((ServerOptions()));
+    return handleLine(server, line, chrono::steady_clock::now());
+}
@@ -0,0 +1,168 @@
+#include "simplex.h"
+
+#include <cmath>
+
+using namespace std;
+
+namespace {
+
+const double EPS = 1e-9;
+
+// Dense tableau: rows 0..m-1 are constraints, row m is the objective
+// (reduced costs, maximization), the last column is the right-hand side.
+class Tableau {
+   public:
+    Tableau(int rows, int cols)
+        : m_(rows), n_(cols), t_(rows + 1, vector<double>(cols + 1, 0)),
+          basis_(rows, -1) {}
+
+    double& at(int r, int c) { return t_[r][c]; }
+    double& rhs(int r) { return t_[r][n_]; }
+    int& basis(int r) { return basis_[r]; }
+    int rows() const { return m_; }
+    int cols() const { return n_; }
+
+    void pivot(int r, int c) {
+        double p = t_[r][c];
+        for (double& v : t_[r]) v /= p;
+        for (int i = 0; i <= m_; ++i) {
+            if (i == r || fabs(t_[i][c]) < EPS) continue;
+            double f = t_[i][c];
+            for (int j = 0; j <= n_; ++j) t_[i][j] -= f * t_[r][j];
+        }
+        basis_[r] = c;
+    }
+
+    // Objective row from costs over the columns (basic columns priced out)
+    void setObjective(const vector<double>& cost) {
+        vector<double>& z = t_[m_];
+        for (int j = 0; j <= n_; ++j) z[j] = j < n_ ? -cost[j] : 0;
+        for (int i = 0; i < m_; ++i) {
+            double f = z[basis_[i]];
+            if (fabs(f) < EPS) continue;
+            for (int j = 0; j <= n_; ++j) z[j] -= f * t_[i][j];
+        }
+    }
+
+    double objective() { return t_[m_][n_]; }
+
+    // Bland's rule on the allowed columns
+    LPResult::Status optimize(const vector<bool>& allowed, int& iterations) {
+        while (iterations-- > 0) {
+            int enter = -1;
+            for (int j = 0; j < n_ && enter < 0; ++j) {
+                if (allowed[j] && t_[m_][j] < -EPS) enter = j;
+            }
+            if (enter < 0) return LPResult::Optimal;
+
+            int leave = -1;
+            double best = 0;
+            for (int i = 0; i < m_; ++i) {
+                if (t_[i][enter] <= EPS) continue;
+                double ratio = t_[i][n_] / t_[i][enter];
+                if (leave < 0 || ratio < best - EPS ||
+                    (ratio < best + EPS && basis_[i] < basis_[leave])) {
+                    leave = i;
+                    best = ratio;
+                }
+            }
+            if (leave < 0) return LPResult::Unbounded;
+            pivot(leave, enter);
+        }
+        return LPResult::IterationLimit;
+    }
+
+   private:
+    int m_, n_;
+    vector<vector<double>> t_;
+    vector<int> basis_;
+};
+
+}  // namespace
+
+LPResult solveLP(const LinearProgram& lp, int maxIterations) {
+    int m = static_cast<int>(lp.A.size());
+    int n = static_cast<int>(lp.c.size());
+
+    // Rows with b >= 0; '>' rows get a surplus, '<' rows a slack, '>' and
+    // '=' rows an artificial variable that starts in the basis.
+    vector<char> sense = lp.sense;
+    vector<double> sign(m, 1);
+    for (int i = 0; i < m; ++i) {
+        if (lp.b[i] < 0) {
+            sign[i] = -1;
+            if (sense[i] == '<') {
+                sense[i] = '>';
+            } else if (sense[i] == '>') {
+                sense[i] = '<';
+            }
+        }
+    }
+    int slacks = 0, artificials = 0;
+    for (char s : sense) {
+        if (s != '=') ++slacks;
+        if (s != '<') ++artificials;
+    }
+    int cols = n + slacks + artificials;
+    Tableau tab(m, cols);
+
+    int nextSlack = n, nextArtificial = n + slacks;
+    for (int i = 0; i < m; ++i) {
+        for (int j = 0; j < n; ++j) tab.at(i, j) = sign[i] * lp.A[i][j];
+        tab.rhs(i) = sign[i] * lp.b[i];
+        if (sense[i] == '<') {
+            tab.at(i, nextSlack) = 1;
+            tab.basis(i) = nextSlack++;
+        } else {
+            if (sense[i] == '>') tab.at(i, nextSlack++) = -1;
+            tab.at(i, nextArtificial) = 1;
+            tab.basis(i) = nextArtificial++;
+        }
+    }
+
+    int iterations = maxIterations;
+    vector<bool> allowed(cols, true);
+    LPResult result;
+
+    if (artificials > 0) {
+        // Phase 1: maximize -sum(artificials)
+        vector<double> cost(cols, 0);
+        for (int j = n + slacks; j < cols; ++j) cost[j] = -1;
+        tab.setObjective(cost);
+        LPResult::Status s = tab.optimize(allowed, iterations);
+        if (s == LPResult::IterationLimit) {
+            result.status = s;
+            return result;
+        }
+        if (tab.objective() < -1e-7) {
+            result.status = LPResult::Infeasible;
+            return result;
+        }
+        // Artificials left in the basis sit at 0: pivot them out where a
+        // real column allows it (the others belong to redundant rows).
+        for (int i = 0; i < m; ++i) {
+            if (tab.basis(i) < n + slacks) continue;
+            for (int j = 0; j < n + slacks; ++j) {
+                if (fabs(tab.at(i, j)) > EPS) {
+                    tab.pivot(i, j);
+                    break;
+                }
+            }
+        }
+        for (int j = n + slacks; j < cols; ++j) allowed[j] = false;
+    }
+
+    // Phase 2
+    vector<double> cost(cols, 0);
+    for (int j = 0; j < n; ++j) cost[j] = lp.c[j];
+    tab.setObjective(cost);
+    result.status = tab.optimize(allowed, iterations);
+    if (result.status != LPResult::Optimal) return result;
+
+    result.value = tab.objective();
+    result.x.assign(n, 0);
+    for (int i = 0; i < m; ++i) {
+        if (tab.basis(i) < n) result.x[tab.basis(i)] = tab.rhs(i);
+    }
+    return result;
+}
@@ -0,0 +1,213 @@
+#include "simulation.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+#include "profiler.h"
+
+using namespace std;
+
+namespace {
+
+// xorshift64* with a splitmix64 seed, one per walk
+class XorShift {
+   public:
+    explicit XorShift(uint64_t seed) {
+        seed += 0x9e3779b97f4a7c15ull;
+        seed = (seed ^ (seed >> 30)) * 0xbf58476d1ce4e5b9ull;
+        seed = (seed ^ (seed >> 27)) * 0x94d049bb133111ebull;
+        state_ = (seed ^ (seed >> 31)) | 1;
+    }
+
+    uint64_t next() {
+        state_ ^= state_ >> 12;
+        state_ ^= state_ << 25;
+        state_ ^= state_ >> 27;
+        return state_ * 0x2545f4914f6cdd1dull;
+    }
+
+    // uniform in [0, n) by multiply-shift
+    uint32_t below(uint32_t n) {
+        return static_cast<uint32_t>(((next() >> 32) * n) >> 32);
+    }
+
+   private:
+    uint64_t state_;
+};
+
+// State of one walk, reused across the walks of a thread: tokens, the
+// number of unsatisfied pre places per transition, and the enabled
+// transitions as a set with O(1) insert, erase and random pick.
+class Walker {
+   public:
+    explicit Walker(const CompactNet& net)
+        : net_(net),
+          tokens_(net.places),
+          missing_(net.transitions),
+          position_(net.transitions) {
+        enabled_.reserve(net.transitions);
+    }
+
+    void reset() {
+        tokens_ = net_.initial;
+        enabled_.clear();
+        for (int t = 0; t < net_.transitions; ++t) {
+            missing_[t] = 0;
+            for (int i = net_.preStart[t]; i < net_.preStart[t + 1]; ++i) {
+                int p = net_.prePlace[i];
+                if (tokens_[p] < net_.preWeight[i]) ++missing_[t];
+            }
+            if (missing_[t] == 0) add(t);
+        }
+    }
+
+    bool dead() const { return enabled_.empty(); }
+
+    int pick(XorShift& rng) const {
+        return enabled_[rng.below(static_cast<uint32_t>(enabled_.size()))];
+    }
+
+    // Updates only the consumers of the places t changes
+    void fire(int t) {
+        for (int i = net_.deltaStart[t]; i < net_.deltaStart[t + 1]; ++i) {
+            int p = net_.deltaPlace[i];
+            int before = tokens_[p];
+            int after = before + net_.deltaValue[i];
+            tokens_[p] = after;
+            for (int j = net_.consumerStart[p]; j < net_.consumerStart[p + 1];
+                 ++j) {
+                int u = net_.consumer[j];
+                int w = net_.consumerWeight[j];
+                bool had = before >= w, has = after >= w;
+                if (had && !has) {
+                    if (missing_[u]++ == 0) remove(u);
+                } else if (!had && has) {
+                    if (--missing_[u] == 0) add(u);
+                }
+            }
+        }
+    }
+
+    const Marking& tokens() const { return tokens_; }
+
+   private:
+    void add(int t) {
+        position_[t] = static_cast<int>(enabled_.size());
+        enabled_.push_back(t);
+    }
+
+    void remove(int t) {
+        int last = enabled_.back();
+        enabled_[position_[t]] = last;
+        position_[last] = position_[t];
+        enabled_.pop_back();
+    }
+
+    const CompactNet& net_;
+    Marking tokens_;
+    vector<int> missing_;
+    vector<int> enabled_;
+    vector<int> position_;
+};
+
+}  // namespace
+
+CompactNet compactNet(const PetriNet& net) {
+    CompactNet cn;
+    cn.places = static_cast<int>(net.places.size());
+    cn.transitions = static_cast<int>(net.transitions.size());
+    cn.initial = net.initialMarking;
+    const vector<vector<int>>& C = net.incidenceMatrix;
+
+    vector<vector<pair<int, int>>> consumers(cn.places);
+    cn.preStart.push_back(0);
+    cn.deltaStart.push_back(0);
+    for (int t = 0; t < cn.transitions; ++t) {
+        for (int p = 0; p < cn.places; ++p) {
+            int c = C[p][t];
+            if (c == 0) continue;
+            cn.deltaPlace.push_back(p);
+            cn.deltaValue.push_back(c);
+            if (c < 0) {
+                cn.prePlace.push_back(p);
+                cn.preWeight.push_back(-c);
+                consumers[p].push_back({t, -c});
+            }
+        }
+        cn.preStart.push_back(static_cast<int>(cn.prePlace.size()));
+        cn.deltaStart.push_back(static_cast<int>(cn.deltaPlace.size()));
+    }
+    cn.consumerStart.push_back(0);
+    for (int p = 0; p < cn.places; ++p) {
+        for (const auto& c : consumers[p]) {
+            cn.consumer.push_back(c.first);
+            cn.consumerWeight.push_back(c.second);
+        }
+        cn.consumerStart.push_back(static_cast<int>(cn.consumer.size()));
+    }
+    return cn;
+}
+
+SimulationResult simulateDeadlock(const PetriNet& net,
+                                  const SimulationOptions& opt) {
+    PROFILE_SCOPE("simulateDeadlock");
+    CompactNet cn = compactNet(net);
+    SimulationResult result;
+
+    // lowest walk index that found a dead marking so far
+    atomic<size_t> firstDead{opt.walks};
+    atomic<size_t> walksRun{0}, firings{0};
+    mutex resultLock;
+    auto deadline = chrono::steady_clock::now() +
+                    chrono::duration_cast<chrono::steady_clock::duration>(
+                        chrono::duration<double>(opt.seconds));
+
+    auto worker = [&](int thread, int threads) {
+        Walker walker(cn);
+        vector<int> trace;
+        trace.reserve(min(opt.walkLength, size_t(1) << 20));
+        size_t fired = 0, walks = 0;
+        for (size_t w = thread; w < opt.walks && w < firstDead; w += threads) {
+            if (opt.seconds > 0 && chrono::steady_clock::now() >= deadline)
+                break;
+            XorShift rng(opt.seed * 0x100000001b3ull + w);
+            walker.reset();
+            trace.clear();
+            ++walks;
+            for (size_t step = 0; step < opt.walkLength && !walker.dead();
+                 ++step) {
+                int t = walker.pick(rng);
+                walker.fire(t);
+                trace.push_back(t);
+            }
+            fired += trace.size();
+            if (!walker.dead()) continue;
+
+            lock_guard<mutex> lock(resultLock);
+            if (w < firstDead) {
+                firstDead = w;
+                result.deadlockFound = true;
+                result.deadMarking = walker.tokens();
+                result.trace = trace;
+                result.walk = w;
+            }
+        }
+        walksRun += walks;
+        firings += fired;
+    };
+
+    int threads = max(1, opt.threads);
+    if (threads == 1) {
+        worker(0, 1);
+    } else {
+        vector<thread> pool;
+        for (int i = 0; i < threads; ++i) pool.emplace_back(worker, i, threads);
+        for (auto& th : pool) th.join();
+    }
+    result.walksRun = walksRun;
+    result.firings = firings;
+    return result;
+}
@@ -0,0 +1,319 @@
+#include "unfolding.h"
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <queue>
+
+#include "profiler.h"
+#include "sat.h"
+#include "simulation.h"
+
+using namespace std;
+
+namespace {
+
+// Growable bitset over condition ids
+class Bits {
+   public:
+    void set(int i) {
+        size_t w = static_cast<size_t>(i) >> 6;
+        if (w >= words_.size()) words_.resize(w + 1, 0);
+        words_[w] |= 1ull << (i & 63);
+    }
+
+    bool test(int i) const {
+        size_t w = static_cast<size_t>(i) >> 6;
+        return w < words_.size() && ((words_[w] >> (i & 63)) & 1);
+    }
+
+    void intersect(const Bits& o) {
+        if (words_.size() > o.words_.size()) words_.resize(o.words_.size());
+        for (size_t w = 0; w < words_.size(); ++w) words_[w] &= o.words_[w];
+    }
+
+    template <class F>
+    void forEach(F f) const {
+        for (size_t w = 0; w < words_.size(); ++w) {
+            for (uint64_t x = words_[w]; x; x &= x - 1)
+                f(static_cast<int>(w * 64 + __builtin_ctzll(x)));
+        }
+    }
+
+   private:
+    vector<uint64_t> words_;
+};
+
+struct Extension {
+    int transition;
+    vector<int> preset;  // sorted condition ids
+    vector<int> causes;  // [e] \ {e}, sorted event ids
+    vector<int> parikh;  // transitions of [e], sorted
+};
+
+// Adequate order: |[e]|, then the Parikh vectors. Comparing the sorted
+// multisets lexicographically ranks first the one with more occurrences of
+// the smallest differing transition, and adding the same events to both
+// sides keeps the ranking, which is what adequacy asks of it.
+bool smaller(const vector<int>& a, const vector<int>& b) {
+    if (a.size() != b.size()) return a.size() < b.size();
+    return a < b;
+}
+
+struct Later {
+    bool operator()(const Extension& a, const Extension& b) const {
+        return smaller(b.parikh, a.parikh);
+    }
+};
+
+class Unfolder {
+   public:
+    Unfolder(const PetriNet& net, size_t maxEvents)
+        : net_(compactNet(net)), maxEvents_(maxEvents) {
+        byPlace_.resize(net_.places);
+    }
+
+    UnfoldingPrefix run() {
+        // the initial cut: pairwise concurrent
+        vector<int> initial;
+        for (int p = 0; p < net_.places; ++p) {
+            if (net_.initial[p] > 0) initial.push_back(newCondition(p, -1));
+        }
+        for (int b : initial) {
+            for (int c : initial) {
+                if (b != c) co_[b].set(c);
+            }
+            byPlace_[prefix_.conditions[b].place].push_back(b);
+        }
+        first_[net_.initial] = {};
+        extend(initial);
+
+        while (!queue_.empty()) {
+            if (maxEvents_ > 0 && prefix_.events.size() >= maxEvents_)
+                return prefix_;
+            Extension ext = queue_.top();
+            queue_.pop();
+            addEvent(ext);
+        }
+        prefix_.complete = true;
+        return prefix_;
+    }
+
+   private:
+    int newCondition(int place, int pre) {
+        prefix_.conditions.push_back({place, pre, {}});
+        co_.emplace_back();
+        return static_cast<int>(prefix_.conditions.size()) - 1;
+    }
+
+    void addEvent(const Extension& ext) {
+        int e = static_cast<int>(prefix_.events.size());
+        PrefixEvent event;
+        event.transition = ext.transition;
+        event.preset = ext.preset;
+        event.local = ext.causes;
+        event.local.push_back(e);
+
+        // Mark([e]): M0 plus the effect of every event of [e]
+        Marking M = net_.initial;
+        for (int t : ext.parikh) {
+            for (int i = net_.deltaStart[t]; i < net_.deltaStart[t + 1]; ++i)
+                M[net_.deltaPlace[i]] += net_.deltaValue[i];
+        }
+        // events leave the queue in order, so the first local configuration
+        // reaching M is the smallest; equal keys are not strictly smaller
+        auto found = first_.find(M);
+        if (found == first_.end()) {
+            first_.emplace(move(M), ext.parikh);
+        } else if (smaller(found->second, ext.parikh)) {
+            event.cutoff = true;
+            ++prefix_.cutoffs;
+        }
+
+        for (int b : ext.preset) prefix_.conditions[b].post.push_back(e);
+        int t = ext.transition;
+        for (int i = net_.deltaStart[t]; i < net_.deltaStart[t + 1]; ++i) {
+            if (net_.deltaValue[i] > 0)
+                event.postset.push_back(newCondition(net_.deltaPlace[i], e));
+        }
+        prefix_.events.push_back(event);
+        if (event.cutoff) return;
+
+        // co(c) for c in e's postset: what every preset condition was
+        // concurrent with, plus the rest of the postset
+        Bits base = co_[ext.preset[0]];
+        for (size_t i = 1; i < ext.preset.size(); ++i)
+            base.intersect(co_[ext.preset[i]]);
+        const vector<int>& post = prefix_.events[e].postset;
+        for (int c : post) {
+            co_[c] = base;
+            for (int d : post) {
+                if (d != c) co_[c].set(d);
+            }
+        }
+        base.forEach([&](int d) {
+            for (int c : post) co_[d].set(c);
+        });
+        for (int c : post) byPlace_[prefix_.conditions[c].place].push_back(c);
+        extend(post);
+    }
+
+    // Possible extensions with at least one condition of fresh. A preset
+    // holding several fresh conditions is built only from its first one.
+    void extend(const vector<int>& fresh) {
+        for (size_t k = 0; k < fresh.size(); ++k) {
+            int c = fresh[k];
+            int p = prefix_.conditions[c].place;
+            for (int i = net_.consumerStart[p]; i < net_.consumerStart[p + 1];
+                 ++i) {
+                int t = net_.consumer[i];
+                vector<int> others;
+                bool usable = true;
+                for (int j = net_.preStart[t]; j < net_.preStart[t + 1]; ++j) {
+                    // a weight above 1 is never met on a 1-safe net
+                    if (net_.preWeight[j] > 1) usable = false;
+                    if (net_.prePlace[j] != p) others.push_back(net_.prePlace[j]);
+                }
+                if (!usable) continue;
+                vector<int> chosen{c};
+                auto skip = [&](int b) {
+                    for (size_t j = 0; j < k; ++j) {
+                        if (fresh[j] == b) return true;
+                    }
+                    return false;
+                };
+                combine(t, others, 0, co_[c], chosen, skip);
+            }
+        }
+    }
+
+    template <class Skip>
+    void combine(int t, const vector<int>& places, size_t next,
+                 const Bits& common, vector<int>& chosen, Skip& skip) {
+        if (next == places.size()) {
+            queue_.push(extension(t, chosen));
+            return;
+        }
+        for (int b : byPlace_[places[next]]) {
+            if (!common.test(b) || skip(b)) continue;
+            Bits narrowed = common;
+            narrowed.intersect(co_[b]);
+            chosen.push_back(b);
+            combine(t, places, next + 1, narrowed, chosen, skip);
+            chosen.pop_back();
+        }
+    }
+
+    Extension extension(int t, const vector<int>& preset) {
+        Extension ext;
+        ext.transition = t;
+        ext.preset = preset;
+        sort(ext.preset.begin(), ext.preset.end());
+        for (int b : preset) {
+            int pre = prefix_.conditions[b].pre;
+            if (pre < 0) continue;
+            const vector<int>& local = prefix_.events[pre].local;
+            vector<int> merged;
+            set_union(ext.causes.begin(), ext.causes.end(), local.begin(),
+                      local.end(), back_inserter(merged));
+            ext.causes.swap(merged);
+        }
+        for (int f : ext.causes)
+            ext.parikh.push_back(prefix_.events[f].transition);
+        ext.parikh.push_back(t);
+        sort(ext.parikh.begin(), ext.parikh.end());
+        return ext;
+    }
+
+    CompactNet net_;
+    size_t maxEvents_;
+    UnfoldingPrefix prefix_;
+    vector<Bits> co_;             // per condition
+    vector<vector<int>> byPlace_;  // extendable conditions per place
+    priority_queue<Extension, vector<Extension>, Later> queue_;
+    map<Marking, vector<int>> first_;  // marking -> smallest Parikh key
+};
+
+}  // namespace
+
+UnfoldingPrefix unfold(const PetriNet& net, size_t maxEvents) {
+    PROFILE_SCOPE("unfold");
+    return Unfolder(net, maxEvents).run();
+}
+
+PrefixDeadlock prefixDeadlock(const PetriNet& net,
+                              const UnfoldingPrefix& prefix) {
+    PROFILE_SCOPE("prefixDeadlock");
+    CompactNet cn = compactNet(net);
+    const auto& events = prefix.events;
+    SatSolver sat;
+    size_t clauses = 0;
+    auto clause = [&](const vector<int>& lits) {
+        sat.addClause(lits);
+        ++clauses;
+    };
+
+    // x_e: e in C, for the events that are not cut-offs
+    vector<int> x(events.size(), 0);
+    for (size_t e = 0; e < events.size(); ++e) {
+        if (!events[e].cutoff) x[e] = sat.newVar();
+    }
+    // z_p: place p is empty in Mark(C)
+    vector<int> z(cn.places);
+    for (int p = 0; p < cn.places; ++p) z[p] = sat.newVar();
+
+    for (size_t e = 0; e < events.size(); ++e) {
+        if (!x[e]) continue;
+        for (int b : events[e].preset) {
+            int pre = prefix.conditions[b].pre;
+            if (pre >= 0) clause({-x[e], x[pre]});  // causally closed
+        }
+    }
+    for (const PrefixCondition& b : prefix.conditions) {
+        vector<int> consumers;
+        for (int e : b.post) {
+            if (x[e]) consumers.push_back(x[e]);
+        }
+        for (size_t i = 0; i < consumers.size(); ++i) {
+            for (size_t j = i + 1; j < consumers.size(); ++j)
+                clause({-consumers[i], -consumers[j]});  // conflict free
+        }
+        // z_p -> b is not in the cut: its producer is out or a consumer in
+        if (b.pre >= 0 && !x[b.pre]) continue;
+        vector<int> lits{-z[b.place]};
+        if (b.pre >= 0) lits.push_back(-x[b.pre]);
+        lits.insert(lits.end(), consumers.begin(), consumers.end());
+        clause(lits);
+    }
+    for (int t = 0; t < cn.transitions; ++t) {
+        vector<int> lits;
+        bool never = false;
+        for (int i = cn.preStart[t]; i < cn.preStart[t + 1]; ++i) {
+            if (cn.preWeight[i] > 1) never = true;
+            lits.push_back(z[cn.prePlace[i]]);
+        }
+        if (!never) clause(lits);  // some pre place of t is empty
+    }
+
+    PrefixDeadlock res;
+    res.vars = sat.vars();
+    res.clauses = clauses;
+    SatSolver::Result answer = sat.solve();
+    res.conflicts = sat.conflicts();
+    if (answer == SatSolver::Sat) {
+        res.found = true;
+        res.decided = true;
+        res.marking = cn.initial;
+        // event ids are a topological order of the causality
+        for (size_t e = 0; e < events.size(); ++e) {
+            if (!x[e] || !sat.value(x[e])) continue;
+            int t = events[e].transition;
+            res.trace.push_back(t);
+            for (int i = cn.deltaStart[t]; i < cn.deltaStart[t + 1]; ++i)
+                res.marking[cn.deltaPlace[i]] += cn.deltaValue[i];
+        }
+    } else if (answer == SatSolver::Unsat) {
+        res.decided = prefix.complete;
+    }
+    return res;
+}
@@ -0,0 +1,180 @@
+#include "zdd.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <unordered_map>
+
+#include "profiler.h"
+
+using namespace std;
+
+namespace {
+
+const double NEG_INF = -1e18;
+
+// Replaces S (Ref'd) by f(S) (Ref'd)
+template <class F>
+void update(DdManager* mgr, DdNode*& S, F f) {
+    DdNode* tmp = f(S);
+    Cudd_Ref(tmp);
+    Cudd_RecursiveDerefZdd(mgr, S);
+    S = tmp;
+}
+
+DdNode* zddUnionInto(DdManager* mgr, DdNode* acc, DdNode* f) {  // consumes
+    DdNode* tmp = Cudd_zddUnion(mgr, acc, f);
+    Cudd_Ref(tmp);
+    Cudd_RecursiveDerefZdd(mgr, acc);
+    Cudd_RecursiveDerefZdd(mgr, f);
+    return tmp;
+}
+
+// The markings of S enabling t, Ref'd
+DdNode* enabledIn(const ZddReachable& zr, DdNode* S, int t) {
+    DdManager* mgr = zr.mgr;
+    Cudd_Ref(S);
+    for (int p : zr.consume[t]) {
+        update(mgr, S, [&](DdNode* f) { return Cudd_zddSubset1(mgr, f, p); });
+        update(mgr, S, [&](DdNode* f) { return Cudd_zddChange(mgr, f, p); });
+    }
+    return S;
+}
+
+}  // namespace
+
+ZddReachable zddReachability(const PetriNet& net) {
+    PROFILE_SCOPE("zddReachability");
+    ZddReachable zr;
+    zr.places = static_cast<int>(net.places.size());
+    int T = static_cast<int>(net.transitions.size());
+    zr.mgr = Cudd_Init(0, zr.places, CUDD_UNIQUE_SLOTS, CUDD_CACHE_SLOTS, 0);
+    DdManager* mgr = zr.mgr;
+
+    zr.consume.resize(T);
+    zr.produce.resize(T);
+    zr.usable.assign(T, true);
+    for (int t = 0; t < T; ++t) {
+        for (int p = 0; p < zr.places; ++p) {
+            int c = net.incidenceMatrix[p][t];
+            if (abs(c) > 1) zr.usable[t] = false;
+            if (c < 0) zr.consume[t].push_back(p);
+            if (c > 0) zr.produce[t].push_back(p);
+        }
+        if (!zr.usable[t]) {
+            zr.consume[t].clear();
+            zr.produce[t].clear();
+        }
+    }
+
+    // {M0}: the empty set with the marked places added
+    DdNode* M0 = Cudd_ReadOne(mgr);
+    Cudd_Ref(M0);
+    for (int p = 0; p < zr.places; ++p) {
+        if (net.initialMarking[p] == 0) continue;
+        update(mgr, M0, [&](DdNode* f) { return Cudd_zddChange(mgr, f, p); });
+    }
+
+    DdNode* zero = Cudd_ReadZero(mgr);
+    DdNode* R = M0;
+    Cudd_Ref(R);
+    DdNode* frontier = M0;
+    while (frontier != zero) {
+        DdNode* image = zero;
+        Cudd_Ref(image);
+        for (int t = 0; t < T; ++t) {
+            if (!zr.usable[t]) continue;
+            image = zddUnionInto(mgr, image, zddPostImage(zr, frontier, t));
+        }
+        Cudd_RecursiveDerefZdd(mgr, frontier);
+        frontier = Cudd_zddDiff(mgr, image, R);
+        Cudd_Ref(frontier);
+        Cudd_RecursiveDerefZdd(mgr, image);
+        update(mgr, R,
+               [&](DdNode* f) { return Cudd_zddUnion(mgr, f, frontier); });
+    }
+    Cudd_RecursiveDerefZdd(mgr, frontier);
+    zr.R = R;
+    PROFILE_CUDD(mgr);
+    return zr;
+}
+
+void freeZddReachable(ZddReachable& zr) {
+    if (zr.mgr == nullptr) return;
+    if (zr.R != nullptr) Cudd_RecursiveDerefZdd(zr.mgr, zr.R);
+    Cudd_Quit(zr.mgr);
+    zr = ZddReachable();
+}
+
+DdNode* zddPostImage(const ZddReachable& zr, DdNode* S, int t) {
+    DdManager* mgr = zr.mgr;
+    Cudd_Ref(S);
+    for (int p : zr.consume[t])
+        update(mgr, S, [&](DdNode* f) { return Cudd_zddSubset1(mgr, f, p); });
+    for (int p : zr.produce[t]) {
+        update(mgr, S, [&](DdNode* f) { return Cudd_zddSubset0(mgr, f, p); });
+        update(mgr, S, [&](DdNode* f) { return Cudd_zddChange(mgr, f, p); });
+    }
+    return S;
+}
+
+double zddCount(const ZddReachable& zr) {
+    return Cudd_zddCountDouble(zr.mgr, zr.R);
+}
+
+DdNode* zddDeadMarkings(const ZddReachable& zr) {
+    DdManager* mgr = zr.mgr;
+    DdNode* live = Cudd_ReadZero(mgr);
+    Cudd_Ref(live);
+    for (size_t t = 0; t < zr.consume.size(); ++t) {
+        if (zr.usable[t])
+            live = zddUnionInto(mgr, live, enabledIn(zr, zr.R, t));
+    }
+    DdNode* dead = Cudd_zddDiff(mgr, zr.R, live);
+    Cudd_Ref(dead);
+    Cudd_RecursiveDerefZdd(mgr, live);
+    return dead;
+}
+
+Marking zddPickMarking(const ZddReachable& zr, DdNode* S) {
+    DdNode* zero = Cudd_ReadZero(zr.mgr);
+    if (S == zero) return Marking();
+    // the then child of a ZDD node is never the empty family
+    Marking M(zr.places, 0);
+    for (DdNode* f = S; !Cudd_IsConstant(f); f = Cudd_T(f))
+        M[Cudd_NodeReadIndex(f)] = 1;
+    return M;
+}
+
+OptimizationTask5Result zddOptimization(const ZddReachable& zr,
+                                        const vector<int>& costs) {
+    PROFILE_SCOPE("zddOptimization");
+    DdNode* zero = Cudd_ReadZero(zr.mgr);
+    DdNode* one = Cudd_ReadOne(zr.mgr);
+    unordered_map<DdNode*, double> best;
+    auto value = [&](auto&& self, DdNode* f) -> double {
+        if (f == zero) return NEG_INF;
+        if (f == one) return 0;
+        auto it = best.find(f);
+        if (it != best.end()) return it->second;
+        double high = self(self, Cudd_T(f)) + costs[Cudd_NodeReadIndex(f)];
+        double v = max(self(self, Cudd_E(f)), high);
+        best.emplace(f, v);
+        return v;
+    };
+
+    OptimizationTask5Result res;
+    res.found = zr.R != zero;
+    res.maxValue = value(value, zr.R);
+    if (!res.found) return res;
+    res.optimalMarking.assign(zr.places, 0);
+    for (DdNode* f = zr.R; f != one;) {
+        int p = Cudd_NodeReadIndex(f);
+        if (value(value, Cudd_T(f)) + costs[p] >= value(value, Cudd_E(f))) {
+            res.optimalMarking[p] = 1;
+            f = Cudd_T(f);
+        } else {
+            f = Cudd_E(f);
+        }
+    }
+    return res;
+}